@@ -32,10 +32,24 @@
 #include "vk_layer_table.h"
 #include "vk_layer_extension_utils.h"
 #include "vk_layer_utils.h"
+#include "frame_schedule.h"
+#include "capture_control.h"
+#include "binary_encoding.h"
+#include "call_filter.h"
+#include "sharded_map.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <mutex>
 #include <iomanip>
 #include <iostream>
@@ -45,12 +59,27 @@
 #include <string>
 #include <type_traits>
 #include <map>
+#include <memory>
+#include <set>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 #include <unordered_set>
 #include <utility>
 
+#if defined(API_DUMP_USE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
 #ifdef ANDROID
 
 #include <android/log.h>
@@ -58,171 +87,2147 @@
 
 #endif  // ANDROID
 
-#define MAX_STRING_LENGTH 1024
+#define MAX_STRING_LENGTH 1024
+
+// Defines for utilized environment variables.
+#define API_DUMP_ENV_VAR_LOG_FILE "VK_APIDUMP_LOG_FILENAME"
+#define API_DUMP_ENV_VAR_OUTPUT_FMT "VK_APIDUMP_OUTPUT_FORMAT"
+#define API_DUMP_ENV_VAR_DETAILED_OUTPUT "VK_APIDUMP_DETAILED"
+#define API_DUMP_ENV_VAR_NO_ADDRESSES "VK_APIDUMP_NO_ADDR"
+#define API_DUMP_ENV_VAR_FLUSH_FILE "VK_APIDUMP_FLUSH"
+#define API_DUMP_ENV_VAR_OUTPUT_RANGE "VK_APIDUMP_OUTPUT_RANGE"
+#define API_DUMP_ENV_VAR_TIMESTAMP "VK_APIDUMP_TIMESTAMP"
+#define API_DUMP_ENV_VAR_COMPRESSION "VK_APIDUMP_COMPRESSION"
+
+enum class ApiDumpFormat {
+    Text,
+    Html,
+    Json,
+    Binary,
+    Stats,
+    Trace,
+};
+
+// The names of the functions the layer dumps, indexed by the generated function ids and ended by
+// NULL. Defined by the generated code.
+extern const char *const api_dump_function_names[];
+
+// Tags used by ApiDumpFormat::Binary. A capture starts with API_DUMP_BINARY_MAGIC, the format
+// version and the header flags, followed by Frame and Call records. Integers are written with the
+// helpers of binary_encoding.h. layersvt/api_dump_convert.py reads this format.
+enum class ApiDumpBinaryTag : char {
+    Call = 'C',     // thread, frame, time (us), function name, parameter names, return type, result, values, End
+    Frame = 'F',    // frame number
+    Value = 'v',    // name, type, address, payload
+    End = ')',      // ends the values of a call, struct or union
+    Null = 'n',     // NULL pointer
+    Int = 'i',      // zigzag encoded varint
+    Uint = 'u',     // varint
+    Float = 'f',    // 8 byte IEEE 754 double
+    String = 's',   // length and characters
+    Pointer = 'p',  // address
+    Handle = 'h',   // address and debug object name
+    Enum = 'e',     // zigzag encoded value and option name, 0 if the value is unknown
+    Bitmask = 'b',  // value and names of the set options, ended by 0
+    Struct = '{',   // values, End
+    Union = 'U',    // values, End
+    Array = '[',    // element type, element size, count and count payloads
+    Blob = 'r',     // length and raw bytes
+    Special = 'x',  // text written in place of the value
+};
+
+static const char API_DUMP_BINARY_MAGIC[8] = {'V', 'K', 'A', 'P', 'I', 'D', 'M', 'P'};
+static const uint64_t API_DUMP_BINARY_VERSION = 1;
+
+enum ApiDumpBinaryHeaderFlags {
+    API_DUMP_BINARY_SHOW_ADDRESS = 0x1,
+    API_DUMP_BINARY_SHOW_THREAD_AND_FRAME = 0x2,
+    API_DUMP_BINARY_SHOW_TIMESTAMP = 0x4,
+    API_DUMP_BINARY_SHOW_PARAMS = 0x8,
+};
+
+inline void dump_binary_tag(ApiDumpBinaryTag tag, std::ostream &stream) { stream.put(static_cast<char>(tag)); }
+
+// Turned off by the flight recorder and by segmented output, which may drop or split off the record
+// that first wrote a name.
+static bool api_dump_binary_intern_names = true;
+
+// Names, types and enum options are string literals, so they are interned by address. The first
+// use on a thread writes (id << 1 | 1) followed by the text, later uses only write (id << 1).
+// Ids are per thread, which keeps them valid when the records of several threads interleave.
+inline void dump_binary_name(const char *name, std::ostream &stream) {
+    static thread_local std::unordered_map<const char *, uint64_t> ids;
+    if (name == NULL) {
+        dump_binary_varint(0, stream);
+        return;
+    }
+    if (!api_dump_binary_intern_names) {
+        // Redefine id 1 every time
+        dump_binary_varint((1 << 1) | 1, stream);
+        dump_binary_text(name, strlen(name), stream);
+        return;
+    }
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        dump_binary_varint(it->second << 1, stream);
+        return;
+    }
+    uint64_t id = ids.size() + 1;
+    ids[name] = id;
+    dump_binary_varint((id << 1) | 1, stream);
+    dump_binary_text(name, strlen(name), stream);
+}
+
+// Number formatting for the text, html and json backends. Values are formatted into a small
+// buffer on the stack and appended with a single write, instead of going through the locale
+// aware std::num_put machinery behind operator<< for every value. The output is identical to
+// what operator<< writes with the default stream flags.
+static const size_t API_DUMP_NUMBER_BUFFER_SIZE = 32;
+
+// Formats value right aligned, ending at end, and returns the first character.
+inline char *format_decimal(uint64_t value, char *end) {
+    do {
+        *--end = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return end;
+}
+
+inline char *format_hex(uint64_t value, char *end, int min_digits, bool upper_case) {
+    const char *digits = upper_case ? "0123456789ABCDEF" : "0123456789abcdef";
+    int count = 0;
+    do {
+        *--end = digits[value & 0xf];
+        value >>= 4;
+        count++;
+    } while (value != 0 || count < min_digits);
+    return end;
+}
+
+inline std::ostream &dump_write_string(std::ostream &stream, const char *text) { return stream.write(text, strlen(text)); }
+
+template <size_t N>
+inline std::ostream &dump_write_literal(std::ostream &stream, const char (&text)[N]) {
+    return stream.write(text, N - 1);
+}
+
+typedef std::ostream &(*ApiDumpStreamManipulator)(std::ostream &);
+
+inline std::ostream &dump_line_break(std::ostream &stream) {
+    stream.rdbuf()->sputc('\n');
+    return stream;
+}
+
+inline std::ostream &dump_no_line_break(std::ostream &stream) { return stream; }
+
+inline std::ostream &dump_write_uint(std::ostream &stream, uint64_t value) {
+    char buffer[API_DUMP_NUMBER_BUFFER_SIZE];
+    char *end = buffer + sizeof(buffer);
+    char *begin = format_decimal(value, end);
+    return stream.write(begin, end - begin);
+}
+
+inline std::ostream &dump_write_int(std::ostream &stream, int64_t value) {
+    char buffer[API_DUMP_NUMBER_BUFFER_SIZE];
+    char *end = buffer + sizeof(buffer);
+    // Negate in unsigned arithmetic so that INT64_MIN does not overflow
+    char *begin = format_decimal(value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value), end);
+    if (value < 0) *--begin = '-';
+    return stream.write(begin, end - begin);
+}
+
+inline std::ostream &dump_write_double(std::ostream &stream, double value) {
+    char buffer[API_DUMP_NUMBER_BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "%g", value);
+    return stream.write(buffer, length);
+}
+
+// Matches the way each standard library prints a void pointer
+inline std::ostream &dump_write_pointer(std::ostream &stream, const void *value) {
+    char buffer[API_DUMP_NUMBER_BUFFER_SIZE];
+    char *end = buffer + sizeof(buffer);
+    uint64_t address = (uint64_t)(uintptr_t)value;
+#if defined(_MSC_VER)
+    char *begin = format_hex(address, end, sizeof(void *) * 2, true);
+#else
+#if defined(__GLIBCXX__)
+    if (address == 0) return stream.put('0');
+#endif
+    char *begin = format_hex(address, end, 1, false);
+    *--begin = 'x';
+    *--begin = '0';
+#endif
+    return stream.write(begin, end - begin);
+}
+
+template <typename T>
+inline std::ostream &dump_write_value(std::ostream &stream, T value) {
+    if (std::is_floating_point<T>::value) return dump_write_double(stream, (double)value);
+    // Unscoped enums are printed through their promotion to int
+    if (std::is_signed<T>::value || std::is_enum<T>::value) return dump_write_int(stream, (int64_t)value);
+    return dump_write_uint(stream, (uint64_t)value);
+}
+
+template <typename T>
+inline std::ostream &dump_write_value(std::ostream &stream, T *value) {
+    return dump_write_pointer(stream, (const void *)value);
+}
+
+inline std::ostream &dump_write_value(std::ostream &stream, const char *value) { return dump_write_string(stream, value); }
+
+inline std::ostream &dump_write_value(std::ostream &stream, char value) { return stream.put(value); }
+
+inline std::ostream &dump_write_value(std::ostream &stream, signed char value) { return stream.put(static_cast<char>(value)); }
+
+inline std::ostream &dump_write_value(std::ostream &stream, unsigned char value) { return stream.put(static_cast<char>(value)); }
+
+// The generated code describes every enum with a table of its options sorted by value, and every
+// bitmask with a table of its bits in the order they are declared, which the dump functions of all
+// output formats share. Each table is ended by an entry with a NULL name.
+struct ApiDumpEnumOption {
+    int64_t value;
+    const char *name;
+};
+
+struct ApiDumpBitmaskOption {
+    uint64_t value;
+    const char *name;
+    bool exact;  // Options given as a value, rather than a bit position, only match that value
+};
+
+// The name of an enum value, NULL if it is not one of the options.
+inline const char *dump_enum_name(const ApiDumpEnumOption *options, size_t count, int64_t value) {
+    const ApiDumpEnumOption *end = options + count;
+    const ApiDumpEnumOption *option =
+        std::lower_bound(options, end, value, [](const ApiDumpEnumOption &option, int64_t value) { return option.value < value; });
+    return option != end && option->value == value ? option->name : NULL;
+}
+
+template <size_t N>
+inline const char *dump_enum_name(const ApiDumpEnumOption (&options)[N], int64_t value) {
+    return dump_enum_name(options, N - 1, value);
+}
+
+inline bool dump_bitmask_option_set(const ApiDumpBitmaskOption &option, uint64_t value) {
+    return option.exact ? value == option.value : (value & option.value) != 0;
+}
+
+// The generated code also describes the members of most structs with a table, which one walker per
+// output format reads: dump_text_struct, dump_html_struct and so on. Structs that need code of their
+// own, such as members that are only valid in some states, keep a generated dump function instead.
+// A member refers to its type by an index into api_dump_types. The generated dump_<format>_type
+// functions dump a value of any type that a member table uses.
+enum class ApiDumpTypeKind {
+    Value,
+    Struct,
+    Union,
+};
+
+struct ApiDumpTypeInfo {
+    uint32_t size;
+    ApiDumpTypeKind kind;  // Structs and unions are passed to their dump functions by reference
+};
+
+extern const ApiDumpTypeInfo api_dump_types[];
+
+enum ApiDumpMemberFlags : uint8_t {
+    API_DUMP_MEMBER_POINTER = 0x01,  // Points to a single value
+    API_DUMP_MEMBER_ARRAY = 0x02,    // Points to count values
+    API_DUMP_MEMBER_INLINE = 0x04,   // An array in the struct, which the member decays to a pointer to
+    API_DUMP_MEMBER_PNEXT = 0x08,    // The pNext chain
+    API_DUMP_MEMBER_PAYLOAD = 0x10,  // A const void* to count bytes, which the blob store may keep
+};
+
+// Each table is ended by an entry with a NULL name.
+struct ApiDumpMemberInfo {
+    const char *name;
+    const char *type;
+    const char *child_type;  // The type of an array element, NULL for other members
+    uint32_t offset;
+    uint32_t count;        // The number of elements of arrays with a fixed size
+    uint16_t type_id;      // Of the value, or of an element of arrays and pointers
+    int16_t count_member;  // The index of the member holding the number of elements, or -1
+    uint8_t flags;
+};
+
+// Where the value of a member is, for a member that is not an array.
+inline const void *dump_member_value(const char *member, uint8_t flags, const void *&decayed) {
+    if (flags & API_DUMP_MEMBER_POINTER) return *reinterpret_cast<const void *const *>(member);
+    if (!(flags & API_DUMP_MEMBER_INLINE)) return member;
+    decayed = member;
+    return &decayed;
+}
+
+inline const void *dump_member_pointer(const char *member, uint8_t flags) {
+    return flags & API_DUMP_MEMBER_INLINE ? member : *reinterpret_cast<const void *const *>(member);
+}
+
+inline size_t dump_member_count(const ApiDumpMemberInfo *members, const ApiDumpMemberInfo &member, const void *object) {
+    if (member.count_member < 0) return member.count;
+    const ApiDumpMemberInfo &count = members[member.count_member];
+    const char *value = static_cast<const char *>(object) + count.offset;
+    switch (api_dump_types[count.type_id].size) {
+        case 1:
+            return *reinterpret_cast<const uint8_t *>(value);
+        case 2:
+            return *reinterpret_cast<const uint16_t *>(value);
+        case 4:
+            return *reinterpret_cast<const uint32_t *>(value);
+        default:
+            return static_cast<size_t>(*reinterpret_cast<const uint64_t *>(value));
+    }
+}
+
+// ApiDumpFormat::Trace writes a Chrome Trace Event format array, which chrome://tracing and Perfetto
+// load. Every event is followed by a comma, the array is closed by a metadata event naming the
+// process. Both viewers also accept an array that was never closed, after a crash.
+static const char API_DUMP_TRACE_HEADER[] = "[\n";
+static const char API_DUMP_TRACE_FOOTER[] =
+    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Vulkan API Dump\"}}\n]\n";
+
+// When the calling thread entered the API call it is in.
+inline std::chrono::steady_clock::time_point &dump_trace_call_start() {
+    static thread_local std::chrono::steady_clock::time_point start;
+    return start;
+}
+
+// Trace timestamps are in microseconds, written with nanosecond precision.
+inline std::ostream &dump_trace_time(std::ostream &stream, std::chrono::nanoseconds time) {
+    uint64_t ns = (uint64_t)std::max<int64_t>(time.count(), 0);
+    char buffer[API_DUMP_NUMBER_BUFFER_SIZE];
+    char *end = buffer + sizeof(buffer);
+    char *begin = format_decimal(ns % 1000 + 1000, end);
+    *begin = '.';  // Replaces the leading 1 that kept the zeros
+    begin = format_decimal(ns / 1000, begin);
+    return stream.write(begin, end - begin);
+}
+
+inline std::ostream &dump_trace_string(std::ostream &stream, const char *text) {
+    stream.put('"');
+    for (const char *c = text; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            stream.put('\\').put(*c);
+        } else if ((unsigned char)*c < 0x20) {
+            char buffer[API_DUMP_NUMBER_BUFFER_SIZE];
+            char *end = buffer + sizeof(buffer);
+            char *begin = format_hex((unsigned char)*c, end, 4, false);
+            dump_write_literal(stream, "\\u").write(begin, end - begin);
+        } else {
+            stream.put(*c);
+        }
+    }
+    return stream.put('"');
+}
+
+// Writes a complete event up to and including the frame argument, the caller adds any other
+// arguments and ends the event with dump_trace_event_end.
+inline std::ostream &dump_trace_event_begin(std::ostream &stream, const char *name, uint64_t thread, std::chrono::nanoseconds start,
+                                            std::chrono::nanoseconds duration, uint64_t frame) {
+    dump_write_literal(stream, "{\"name\":\"");
+    dump_write_string(stream, name);
+    dump_write_literal(stream, "\",\"cat\":\"vulkan\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+    dump_write_uint(stream, thread);
+    dump_write_literal(stream, ",\"ts\":");
+    dump_trace_time(stream, start);
+    dump_write_literal(stream, ",\"dur\":");
+    dump_trace_time(stream, duration);
+    dump_write_literal(stream, ",\"args\":{\"frame\":");
+    return dump_write_uint(stream, frame);
+}
+
+inline std::ostream &dump_trace_event_end(std::ostream &stream) { return dump_write_literal(stream, "}},\n"); }
+
+// A global instant event marking the start of a frame.
+inline std::ostream &dump_trace_frame(std::ostream &stream, uint64_t frame, std::chrono::nanoseconds time) {
+    dump_write_literal(stream, "{\"name\":\"Frame ");
+    dump_write_uint(stream, frame);
+    dump_write_literal(stream, "\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":");
+    dump_trace_time(stream, time);
+    return dump_write_literal(stream, "},\n");
+}
+
+// The kinds of records that are handed to the asynchronous writer.
+enum class ApiDumpRecordType {
+    Call,      // The complete output of one API call
+    Frame,     // Output written between frames (frame headers and footers)
+    FrameEnd,  // The footer of a frame, when the output is segmented and the frame header follows separately
+    Segment,   // The footer of a frame that also ends the current output segment
+};
+
+// A stream buffer that collects a record in a std::string, so that a finished record can be handed
+// to another thread without copying it. Text is written straight into the unused capacity of the
+// string, only running out of it goes through overflow.
+class ApiDumpRecordBuffer : public std::streambuf {
+   public:
+    // Reserved for a new string, and the most capacity zero filled at once to make room for text
+    static const size_t RESERVE_SIZE = 4096;
+
+    // Starts a new record, keeping the capacity of the string.
+    inline void clear() {
+        setp(NULL, NULL);
+        buffer.clear();
+    }
+
+    inline size_t size() const { return pbase() != NULL ? static_cast<size_t>(pptr() - pbase()) : buffer.size(); }
+
+    // The text written so far, more can be written after it.
+    inline const std::string &str() {
+        commit();
+        return buffer;
+    }
+
+    // Hands the text written so far over in text, and goes on with the string it held, emptied.
+    inline void swap(std::string &text) {
+        commit();
+        buffer.swap(text);
+        clear();
+    }
+
+   protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        commit();
+        buffer.push_back(traits_type::to_char_type(ch));
+        open();
+        return ch;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize count) override {
+        size_t length = static_cast<size_t>(count);
+        if (pbase() != NULL && length <= static_cast<size_t>(epptr() - pptr())) {
+            memcpy(pptr(), s, length);
+            pbump(static_cast<int>(length));
+        } else {
+            commit();
+            buffer.append(s, length);
+            open();
+        }
+        return count;
+    }
+
+   private:
+    // Ends the string where the text written so far ends.
+    void commit() {
+        if (pbase() == NULL) return;
+        buffer.resize(static_cast<size_t>(pptr() - pbase()));
+        setp(NULL, NULL);
+    }
+
+    // Extends the string over some of its unused capacity, for the text that follows.
+    void open() {
+        size_t used = buffer.size();
+        if (buffer.capacity() < RESERVE_SIZE) buffer.reserve(RESERVE_SIZE);
+        buffer.resize(std::min(buffer.capacity(), used + RESERVE_SIZE));
+        setp(&buffer[0], &buffer[0] + buffer.size());
+        pbump(static_cast<int>(used));
+    }
+
+    std::string buffer;
+};
+
+// Each thread formats its trace events here, before ApiDumpInstance::writeRecord writes them out.
+struct ApiDumpTraceBuffer {
+    ApiDumpTraceBuffer() : stream(&buffer) {}
+
+    ApiDumpRecordBuffer buffer;
+    std::ostream stream;
+};
+
+// The calling thread's trace buffer, emptied.
+inline ApiDumpTraceBuffer &dump_trace_buffer() {
+    static thread_local ApiDumpTraceBuffer trace;
+    trace.buffer.clear();
+    return trace;
+}
+
+// When the output is flushed to the file or stdout, provided flushing is enabled at all.
+enum class ApiDumpFlushPolicy {
+    Call,      // After the start and the end of every API call
+    Interval,  // Every flush interval, if anything was written since the last flush
+    Bytes,     // Whenever the flush size worth of output has been buffered
+    Frame,     // At every frame boundary
+};
+
+struct ApiDumpFlushOptions {
+    bool enabled;
+    ApiDumpFlushPolicy policy;
+    std::chrono::milliseconds interval;
+    size_t bytes;
+};
+
+// Calls a function at a fixed interval on a background thread until it is destroyed.
+class ApiDumpIntervalTimer {
+   public:
+    ApiDumpIntervalTimer(std::chrono::milliseconds interval, std::function<void()> callback)
+        : interval(interval), callback(callback), stop_requested(false) {
+        timer = std::thread(&ApiDumpIntervalTimer::run, this);
+    }
+
+    ~ApiDumpIntervalTimer() {
+        {
+            std::lock_guard<std::mutex> lg(stop_mutex);
+            stop_requested = true;
+        }
+        stop_condition.notify_one();
+        timer.join();
+    }
+
+   private:
+    void run() {
+        std::unique_lock<std::mutex> lock(stop_mutex);
+        while (!stop_condition.wait_for(lock, interval, [this] { return stop_requested; })) {
+            lock.unlock();
+            callback();
+            lock.lock();
+        }
+    }
+
+    std::chrono::milliseconds interval;
+    std::function<void()> callback;
+    bool stop_requested;
+    std::mutex stop_mutex;
+    std::condition_variable stop_condition;
+    std::thread timer;
+};
+
+#if !defined(_WIN32)
+// Runs a callback on a background thread when a signal handler asks for it. Signal handlers may
+// only do async-signal-safe work, so the handler just writes to a pipe to wake the thread and
+// sleeps until the callback is done, while the callback is free to take locks and join threads.
+// The handler gives up waiting after a timeout, in case the thread that got the signal holds
+// something the callback is waiting for. Each request runs the callback again, for applications
+// that handle a signal and keep running.
+class ApiDumpSignalFlusher {
+   public:
+    // The callback is told whether the process goes down once the signal handler returns.
+    explicit ApiDumpSignalFlusher(std::function<void(bool)> callback) : callback(callback), requested(false), completed(0) {
+        if (!openPipe(request_pipe)) return;
+        thread = std::thread(&ApiDumpSignalFlusher::run, this);
+    }
+
+    ~ApiDumpSignalFlusher() {
+        // The thread sees the end of the pipe and exits
+        if (request_pipe[1] != -1) close(request_pipe[1]);
+        if (thread.joinable()) thread.join();
+        if (request_pipe[0] != -1) close(request_pipe[0]);
+    }
+
+    // Only calls async-signal-safe functions. Signals that come in while the callback runs wait for
+    // that run instead of asking for another one.
+    void flushAndWait(int timeout_ms, bool process_ends) {
+        if (!thread.joinable()) return;
+        uint32_t completed_before = completed.load();
+        char byte = process_ends ? 1 : 0;
+        if (!requested.exchange(true) && write(request_pipe[1], &byte, 1) != 1) {
+            requested.store(false);
+            return;
+        }
+        // poll without descriptors only sleeps
+        for (int waited_ms = 0; waited_ms < timeout_ms && completed.load() == completed_before; waited_ms += 10) {
+            poll(NULL, 0, 10);
+        }
+    }
+
+   private:
+    static bool openPipe(int fds[2]) {
+        if (pipe(fds) != 0) {
+            fds[0] = fds[1] = -1;
+            return false;
+        }
+        // Not handed on to processes the application starts
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        return true;
+    }
+
+    void run() {
+        // A signal handled on this thread would wait for itself
+        sigset_t signals;
+        sigfillset(&signals);
+        pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+        char byte;
+        ssize_t size;
+        while ((size = read(request_pipe[0], &byte, 1)) != 0) {
+            if (size < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            callback(byte != 0);
+            // Rearmed before the waiting handlers are released, so that a later signal runs the callback again
+            requested.store(false);
+            completed.fetch_add(1);
+        }
+    }
+
+    std::function<void(bool)> callback;
+    std::atomic<bool> requested;
+    std::atomic<uint32_t> completed;
+    int request_pipe[2] = {-1, -1};
+    std::thread thread;
+};
+#endif
+
+// Splits vk_apidump.txt into vk_apidump and .txt, to name the files written next to it.
+inline void api_dump_split_filename(const std::string &filename, std::string &base, std::string &extension) {
+    size_t last_slash_idx = filename.find_last_of("\\/");
+    size_t extension_idx = filename.find_last_of('.');
+    if (extension_idx == std::string::npos || (last_slash_idx != std::string::npos && extension_idx < last_slash_idx))
+        extension_idx = filename.size();
+    base = filename.substr(0, extension_idx);
+    extension = filename.substr(extension_idx);
+}
+
+// The name of a file without its directory, for the files that list other files.
+inline std::string api_dump_file_name(const std::string &filename) {
+    size_t last_slash_idx = filename.find_last_of("\\/");
+    return last_slash_idx == std::string::npos ? filename : filename.substr(last_slash_idx + 1);
+}
+
+#if defined(API_DUMP_USE_ZLIB)
+// Compresses the output into a gzip file on a background thread. Output is collected into one block
+// while the previous block is compressed and written, so formatting only waits on compression when
+// it outpaces it. A flush compresses and writes out everything written so far and ends the deflate
+// block, so that the file can be decompressed up to that point even if it is never closed.
+class ApiDumpGzipBuffer : public std::streambuf {
+   public:
+    static const size_t BLOCK_SIZE = 256 * 1024;
+
+    explicit ApiDumpGzipBuffer(FILE *file)
+        : file(file), filling(BLOCK_SIZE), pending(BLOCK_SIZE), compressed(BLOCK_SIZE), pending_size(0), pending_flush(Z_NO_FLUSH) {
+        memset(&deflater, 0, sizeof(deflater));
+        // The fastest level still compresses text and json around tenfold. Adding 16 to the window
+        // bits writes a gzip header and trailer around the deflate stream.
+        deflate_ready = deflateInit2(&deflater, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        setp(filling.data(), filling.data() + filling.size());
+        compressor = std::thread(&ApiDumpGzipBuffer::run, this);
+    }
+
+    ~ApiDumpGzipBuffer() {
+        submit(Z_FINISH, true);
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            stop_requested = true;
+        }
+        condition.notify_all();
+        compressor.join();
+        if (deflate_ready) deflateEnd(&deflater);
+        fclose(file);
+    }
+
+   protected:
+    int_type overflow(int_type ch) override {
+        submit(Z_NO_FLUSH, false);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        submit(Z_SYNC_FLUSH, true);
+        return deflate_ready && !ferror(file) ? 0 : -1;
+    }
+
+   private:
+    // Hands the block filled so far to the compressor thread and goes on with the other one, once
+    // the compressor is done with it. Waits for the block to be written out if wait is set.
+    void submit(int flush, bool wait) {
+        size_t size = static_cast<size_t>(pptr() - pbase());
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return !pending_ready; });
+        pending.swap(filling);
+        pending_size = size;
+        pending_flush = flush;
+        pending_ready = true;
+        condition.notify_all();
+        if (wait) condition.wait(lock, [this] { return !pending_ready; });
+        lock.unlock();
+        setp(filling.data(), filling.data() + filling.size());
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            condition.wait(lock, [this] { return pending_ready || stop_requested; });
+            if (!pending_ready) return;
+            lock.unlock();
+            compress();
+            lock.lock();
+            pending_ready = false;
+            condition.notify_all();
+        }
+    }
+
+    void compress() {
+        if (!deflate_ready) return;
+        deflater.next_in = reinterpret_cast<Bytef *>(pending.data());
+        deflater.avail_in = static_cast<uInt>(pending_size);
+        do {
+            deflater.next_out = reinterpret_cast<Bytef *>(compressed.data());
+            deflater.avail_out = static_cast<uInt>(compressed.size());
+            deflate(&deflater, pending_flush);
+            fwrite(compressed.data(), 1, compressed.size() - deflater.avail_out, file);
+        } while (deflater.avail_out == 0);
+        if (pending_flush != Z_NO_FLUSH) fflush(file);
+    }
+
+    FILE *file;
+    z_stream deflater;
+    bool deflate_ready;
+    std::vector<char> filling;
+    std::vector<char> pending;
+    std::vector<char> compressed;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    // The block handed to the compressor, which owns it and the deflate stream until it is done
+    size_t pending_size;
+    int pending_flush;
+    bool pending_ready = false;
+    bool stop_requested = false;
+    std::thread compressor;
+};
+#endif
+
+// Opens a gzip file that everything written to the returned buffer is compressed into. Returns NULL
+// if the file cannot be opened, or if the layer was built without zlib.
+inline std::streambuf *api_dump_open_gzip_output(const std::string &filename) {
+#if defined(API_DUMP_USE_ZLIB)
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (file != NULL) return new ApiDumpGzipBuffer(file);
+#endif
+    return NULL;
+}
+
+struct ApiDumpSegmentOptions {
+    uint64_t frames;  // Frames per segment, 0 to not limit the number of frames
+    uint64_t bytes;   // Bytes per segment, 0 to not limit the size
+};
+
+// The page listing the frames of segmented html output. Rows are added as frames end, browsers show
+// the page as it is even if the application never closes it.
+static const char API_DUMP_FRAME_PAGE_HEADER[] =
+    "<!doctype html>"
+    "<html>"
+    "<head>"
+    "<title>Vulkan API Dump</title>"
+    "<style type='text/css'>"
+    "body { margin: 0; font-family: Consolas, monaco, monospace; font-size: 14px; background-color: #0b1e48; color: #eee; }"
+    "#frames { position: absolute; top: 0; bottom: 0; left: 0; width: 360px; overflow: auto; }"
+    "#frames td, #frames th { padding: 2px 8px; text-align: right; }"
+    "#frames a { color: #acf; }"
+    "iframe { position: absolute; top: 0; bottom: 0; left: 360px; right: 0; width: calc(100% - 360px); height: 100%; border: 0; }"
+    "</style>"
+    "</head>"
+    "<body>"
+    "<iframe name='frame'></iframe>"
+    "<div id='frames'><table><tr><th>Frame</th><th>Calls</th><th>Time (ms)</th></tr>\n";
+
+static const char API_DUMP_FRAME_PAGE_FOOTER[] = "</table></div></body></html>\n";
+
+// Writes the output to a series of files instead of a single one. A new segment starts at a frame
+// boundary once the current one holds enough frames or bytes, and every segment is a complete
+// document of the output format. Next to the segments, an index file records where each frame
+// and the first call of each thread in a frame start, one entry per line:
+//
+//     format <output format>
+//     segment <segment> <file name>
+//     frame <frame> <segment> <offset>
+//     thread <frame> <thread> <segment> <offset>
+//     end <segment> <offset of the closing output of the segment>
+//
+// Every record written to stream() has to be bracketed by beginRecord and endRecord, by whichever
+// thread writes it to the output.
+//
+// With the html output format, the output file itself becomes a page listing every frame with the
+// number of calls and the time it took, which loads the segment holding a frame when it is clicked,
+// so that a capture too large for a single document can still be browsed.
+class ApiDumpSegmentedOutput : public std::streambuf {
+   public:
+    ApiDumpSegmentedOutput(const std::string &filename, const char *format_name, std::ios_base::openmode mode,
+                           size_t buffer_size, const ApiDumpSegmentOptions &options,
+                           std::function<void(std::ostream &)> write_header, std::function<void(std::ostream &)> write_footer)
+        : options(options), mode(mode), write_header(write_header), write_footer(write_footer), output(this) {
+        // vk_apidump.txt is written to vk_apidump.0000.txt, vk_apidump.0001.txt, ... and vk_apidump.index
+        api_dump_split_filename(filename, file_base, file_extension);
+
+        buffer.resize(std::max(buffer_size, (size_t)1));
+        setp(buffer.data(), buffer.data() + buffer.size());
+        index.open(file_base + ".index", std::ofstream::out | std::ofstream::trunc);
+        index << "format " << format_name << '\n';
+        if (strcmp(format_name, "html") == 0) {
+            frame_page.open(filename, std::ofstream::out | std::ofstream::trunc);
+            frame_page << API_DUMP_FRAME_PAGE_HEADER;
+        }
+        openSegment();
+    }
+
+    ~ApiDumpSegmentedOutput() {
+        writeBuffer();
+        segment.close();
+        index.close();
+        frame_page.close();
+    }
+
+    inline std::ostream &stream() { return output; }
+
+    // Called at every frame boundary, by the thread formatting the output, before the end of the
+    // frame is written. Returns true if the frame ends the current segment, in which case its
+    // footer has to be written as a Segment record.
+    bool endFrame() {
+        ++segment_frames;
+        bool full = (options.frames > 0 && segment_frames >= options.frames) ||
+                    (options.bytes > 0 && segment_bytes.load(std::memory_order_relaxed) >= options.bytes);
+        if (full) segment_frames = 0;
+        return full;
+    }
+
+    inline void beginRecord(ApiDumpRecordType type) {
+        record_start = position();
+        if (type == ApiDumpRecordType::Frame) {
+            if (frame_page.is_open()) listFrame();
+            frame = next_frame++;
+            frame_threads.assign(frame_threads.size(), false);
+            index << "frame " << frame << ' ' << segment_number << ' ' << record_start << '\n';
+        }
+    }
+
+    inline void endRecord(ApiDumpRecordType type, uint64_t thread) {
+        if (type == ApiDumpRecordType::Call) {
+            ++frame_calls;
+            if (thread >= frame_threads.size()) frame_threads.resize(thread + 1, false);
+            if (!frame_threads[thread]) {
+                frame_threads[thread] = true;
+                index << "thread " << frame << ' ' << thread << ' ' << segment_number << ' ' << record_start << '\n';
+            }
+        } else if (type == ApiDumpRecordType::Segment) {
+            endSegment();
+            writeBuffer();
+            segment.close();
+            ++segment_number;
+            openSegment();
+            write_header(output);
+            index.flush();
+            frame_page.flush();
+        }
+        segment_bytes.store(position(), std::memory_order_relaxed);
+    }
+
+    // Writes the footer of the last segment.
+    void close() {
+        endSegment();
+        if (frame_page.is_open()) {
+            listFrame();
+            frame_page << API_DUMP_FRAME_PAGE_FOOTER;
+        }
+        sync();
+    }
+
+   protected:
+    int_type overflow(int_type ch) override {
+        if (!writeBuffer()) return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize count) override {
+        if (count <= epptr() - pptr()) {
+            memcpy(pptr(), s, static_cast<size_t>(count));
+            pbump(static_cast<int>(count));
+            return count;
+        }
+        // Large payloads, like shader code, go straight to the file
+        if (!writeBuffer()) return 0;
+        segment.write(s, count);
+        written += count;
+        return segment.fail() ? 0 : count;
+    }
+
+    int sync() override {
+        bool ok = writeBuffer();
+        segment.flush();
+        index.flush();
+        frame_page.flush();
+        return ok && !segment.fail() ? 0 : -1;
+    }
+
+   private:
+    inline uint64_t position() const { return written + static_cast<uint64_t>(pptr() - pbase()); }
+
+    bool writeBuffer() {
+        std::streamsize count = pptr() - pbase();
+        if (count > 0) {
+            segment.write(pbase(), count);
+            written += count;
+        }
+        setp(buffer.data(), buffer.data() + buffer.size());
+        return !segment.fail();
+    }
+
+    void openSegment() {
+        char number[24];
+        snprintf(number, sizeof(number), ".%04" PRIu64, segment_number);
+        std::string filename = file_base + number + file_extension;
+        // Only this buffer is needed, the file writes through
+        segment.rdbuf()->pubsetbuf(NULL, 0);
+        segment.open(filename, mode);
+        written = 0;
+        segment_name = api_dump_file_name(filename);
+        index << "segment " << segment_number << ' ' << segment_name << '\n';
+    }
+
+    // Adds the frame that just ended to the frame page, and starts counting the next one. Called at
+    // every frame boundary, once the next frame's segment is open.
+    void listFrame() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (frame_started) {
+            double milliseconds = std::chrono::duration<double, std::milli>(now - frame_start).count();
+            char duration[32];
+            snprintf(duration, sizeof(duration), "%.3f", milliseconds);
+            frame_page << "<tr><td><a href='" << frame_segment_name << "#frame-" << frame << "' target='frame'>" << frame
+                       << "</a></td><td>" << frame_calls << "</td><td>" << duration << "</td></tr>\n";
+        }
+        frame_started = true;
+        frame_start = now;
+        frame_segment_name = segment_name;
+        frame_calls = 0;
+    }
+
+    void endSegment() {
+        index << "end " << segment_number << ' ' << position() << '\n';
+        write_footer(output);
+    }
+
+    ApiDumpSegmentOptions options;
+    std::ios_base::openmode mode;
+    std::function<void(std::ostream &)> write_header;
+    std::function<void(std::ostream &)> write_footer;
+    std::string file_base;
+    std::string file_extension;
+
+    std::vector<char> buffer;
+    std::ofstream segment;
+    std::ofstream index;
+    std::ostream output;
+    uint64_t segment_number = 0;
+    uint64_t written = 0;
+
+    // Only touched by the thread formatting frame boundaries
+    uint64_t segment_frames = 0;
+    // Written by the thread writing the output, read when deciding whether a segment is full
+    std::atomic<uint64_t> segment_bytes{0};
+
+    uint64_t next_frame = 0;
+    uint64_t frame = 0;
+    uint64_t record_start = 0;
+    std::vector<bool> frame_threads;
+
+    // Only written with the html output format
+    std::ofstream frame_page;
+    std::string segment_name;
+    std::string frame_segment_name;
+    uint64_t frame_calls = 0;
+    std::chrono::steady_clock::time_point frame_start;
+    bool frame_started = false;
+};
+
+// Moves the output of API calls off of the application threads. Each thread formats its records
+// into a private buffer and pushes them onto its own single-producer/single-consumer queue, so
+// the calling threads never wait on each other or on file I/O. A single writer thread collects the
+// records from all of the queues and writes them to the output stream in sequence order.
+//
+// The queues are rings of QUEUE_SIZE records, a thread that fills its ring waits for the writer
+// to catch up. The strings of written records go back into the rings with their capacity, so that
+// a thread formats into a string that already has room for its record instead of growing a new
+// one. Only strings of up to RECYCLED_CAPACITY bytes are kept, which bounds what a thread holds
+// on to beyond its queued records to QUEUE_SIZE * RECYCLED_CAPACITY bytes, 16 MB.
+class ApiDumpAsyncWriter {
+   public:
+    ApiDumpAsyncWriter(std::ostream &output, bool separates_json_calls, const ApiDumpFlushOptions &flush_options,
+                       ApiDumpSegmentedOutput *segments)
+        : output(output),
+          separates_json_calls(separates_json_calls),
+          flush_options(flush_options),
+          segments(segments),
+          last_flush(std::chrono::steady_clock::now()),
+          next_sequence(0),
+          stop_requested(false),
+          writer_sleeping(false),
+          drain_requests(0),
+          drained(0) {
+        writer = std::thread(&ApiDumpAsyncWriter::run, this);
+    }
+
+    static const size_t QUEUE_SIZE = 1024;
+    static const size_t RECYCLED_CAPACITY = 16 * 1024;
+
+    ~ApiDumpAsyncWriter() {
+        stop();
+        for (RecordQueue *queue : queues) delete queue;
+    }
+
+    // Waits for every queued record to be written and stops the writer thread. Records queued
+    // after this are no longer written.
+    void stop() {
+        if (!writer.joinable() || writer.get_id() == std::this_thread::get_id()) return;
+        stop_requested.store(true, std::memory_order_release);
+        wake_condition.notify_one();
+        writer.join();
+    }
+
+    // Waits for every record queued so far to be written and flushed, while the writer thread keeps
+    // running. Records that an interrupted thread has not queued yet are written once they come in,
+    // without holding back the ones after them.
+    void drain() {
+        if (!writer.joinable() || writer.get_id() == std::this_thread::get_id()) return;
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        uint64_t request = drain_requests.fetch_add(1, std::memory_order_acq_rel) + 1;
+        wake_condition.notify_one();
+        drained_condition.wait(lock, [this, request] { return drained >= request; });
+    }
+
+    // The stream the calling thread should write its current record to.
+    inline std::ostream &stream() { return threadState().stream; }
+
+    inline void beginRecord() { threadState().buffer.clear(); }
+
+    // Hands the calling thread's current record to the writer thread. The thread is only needed for
+    // segmented output. Records that come in once the writer thread has stopped are dropped.
+    void endRecord(ApiDumpRecordType type, uint64_t thread) {
+        ThreadState &state = threadState();
+        if (state.queue == nullptr) {
+            state.queue = new RecordQueue();
+            std::lock_guard<std::mutex> lg(queues_mutex);
+            queues.push_back(state.queue);
+        }
+
+        // The sequence is only taken once there is room, so the writer never waits on a full queue
+        while (state.queue->full()) {
+            if (stop_requested.load(std::memory_order_acquire)) {
+                state.buffer.clear();
+                return;
+            }
+            wake_condition.notify_one();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        Record &record = state.queue->tailRecord();
+        record.type = type;
+        record.thread = thread;
+        state.buffer.swap(record.text);
+        record.sequence = next_sequence.fetch_add(1, std::memory_order_relaxed);
+        state.queue->push();
+
+        if (writer_sleeping.load(std::memory_order_relaxed)) wake_condition.notify_one();
+    }
+
+   private:
+    struct Record {
+        uint64_t sequence;
+        ApiDumpRecordType type;
+        uint64_t thread;
+        std::string text;
+    };
+
+    // Bounded single-producer/single-consumer ring. The producer fills the record at the tail and
+    // the consumer empties the one at the head, each only moves its own index.
+    class RecordQueue {
+       public:
+        RecordQueue() : records(QUEUE_SIZE), head(0), tail(0) {}
+
+        inline bool full() const {
+            return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == QUEUE_SIZE;
+        }
+
+        inline Record &tailRecord() { return records[tail.load(std::memory_order_relaxed) % QUEUE_SIZE]; }
+
+        inline void push() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        // Moves the oldest record into the reorder buffer and leaves a spare string in its place,
+        // returns false if the queue is empty.
+        bool pop(std::map<uint64_t, Record> &pending, std::vector<std::string> &spares) {
+            uint64_t index = head.load(std::memory_order_relaxed);
+            if (index == tail.load(std::memory_order_acquire)) return false;
+            Record &next = records[index % QUEUE_SIZE];
+            Record &record = pending[next.sequence];
+            record.sequence = next.sequence;
+            record.type = next.type;
+            record.thread = next.thread;
+            record.text.swap(next.text);
+            if (!spares.empty()) {
+                next.text.swap(spares.back());
+                spares.pop_back();
+            }
+            head.store(index + 1, std::memory_order_release);
+            return true;
+        }
+
+       private:
+        std::vector<Record> records;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+    };
+
+    struct ThreadState {
+        ThreadState() : stream(&buffer), queue(nullptr) {}
+
+        ApiDumpRecordBuffer buffer;
+        std::ostream stream;
+        RecordQueue *queue;
+    };
+
+    static inline ThreadState &threadState() {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    // Moves every available record into the reorder buffer.
+    void collect(std::vector<RecordQueue *> &known_queues, std::map<uint64_t, Record> &pending, std::vector<std::string> &spares) {
+        {
+            std::lock_guard<std::mutex> lg(queues_mutex);
+            for (size_t i = known_queues.size(); i < queues.size(); ++i) known_queues.push_back(queues[i]);
+        }
+        for (RecordQueue *queue : known_queues) {
+            while (queue->pop(pending, spares)) {
+            }
+        }
+    }
+
+    void write(const Record &record) {
+        if (separates_json_calls) {
+            // Calls are formatted concurrently, so the separators between them are only known here
+            if (record.type == ApiDumpRecordType::Call) {
+                if (json_call_on_frame) output << ",\n";
+                json_call_on_frame = true;
+            } else {
+                json_call_on_frame = false;
+            }
+        }
+        if (segments != nullptr) segments->beginRecord(record.type);
+        output.write(record.text.data(), record.text.size());
+        if (segments != nullptr) segments->endRecord(record.type, record.thread);
+        unflushed_bytes += record.text.size();
+        if (record.type == ApiDumpRecordType::Frame) unflushed_frame = true;
+    }
+
+    // Applies the flush policy to everything written since the last flush.
+    void flushIfNeeded() {
+        if (!flush_options.enabled || unflushed_bytes == 0) return;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        bool flush_now = false;
+        switch (flush_options.policy) {
+            case ApiDumpFlushPolicy::Call:
+                flush_now = true;
+                break;
+            case ApiDumpFlushPolicy::Interval:
+                flush_now = now - last_flush >= flush_options.interval;
+                break;
+            case ApiDumpFlushPolicy::Bytes:
+                flush_now = unflushed_bytes >= flush_options.bytes;
+                break;
+            case ApiDumpFlushPolicy::Frame:
+                flush_now = unflushed_frame;
+                break;
+        }
+        if (flush_now) {
+            output.flush();
+            unflushed_bytes = 0;
+            unflushed_frame = false;
+            last_flush = now;
+        }
+    }
+
+    void run() {
+        std::vector<RecordQueue *> known_queues;
+        std::map<uint64_t, Record> pending;
+        std::vector<std::string> spares;
+        uint64_t next_to_write = 0;
+
+        for (;;) {
+            bool stopping = stop_requested.load(std::memory_order_acquire);
+            uint64_t drain_request = drain_requests.load(std::memory_order_acquire);
+            bool draining = drain_request != drained;
+            collect(known_queues, pending, spares);
+
+            // Records may arrive out of order, only write them once all earlier records are in.
+            // Records that were skipped over while draining are written as soon as they arrive.
+            bool wrote = false;
+            while (!pending.empty() && (pending.begin()->first <= next_to_write || stopping || draining)) {
+                next_to_write = std::max(next_to_write, pending.begin()->first + 1);
+                std::string &text = pending.begin()->second.text;
+                write(pending.begin()->second);
+                // Strings that grew for an unusually large record are not worth keeping
+                if (text.capacity() <= RECYCLED_CAPACITY && spares.size() < QUEUE_SIZE) {
+                    text.clear();
+                    spares.push_back(std::move(text));
+                }
+                pending.erase(pending.begin());
+                wrote = true;
+            }
+            flushIfNeeded();
+
+            if (draining) {
+                output.flush();
+                std::lock_guard<std::mutex> lg(wake_mutex);
+                drained = drain_request;
+                drained_condition.notify_all();
+            }
+            if (stopping) break;
+            if (!wrote) {
+                std::unique_lock<std::mutex> lock(wake_mutex);
+                writer_sleeping.store(true, std::memory_order_relaxed);
+                wake_condition.wait_for(lock, std::chrono::milliseconds(10));
+                writer_sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+        output.flush();
+
+        // Nothing is left to wait for
+        std::lock_guard<std::mutex> lg(wake_mutex);
+        drained = UINT64_MAX;
+        drained_condition.notify_all();
+    }
+
+    std::ostream &output;
+    bool separates_json_calls;
+    ApiDumpFlushOptions flush_options;
+    ApiDumpSegmentedOutput *segments;
+    bool json_call_on_frame = false;
+    size_t unflushed_bytes = 0;
+    bool unflushed_frame = false;
+    std::chrono::steady_clock::time_point last_flush;
+
+    std::atomic<uint64_t> next_sequence;
+    std::atomic<bool> stop_requested;
+    std::atomic<bool> writer_sleeping;
+    std::mutex wake_mutex;
+    std::condition_variable wake_condition;
+    std::atomic<uint64_t> drain_requests;
+    uint64_t drained;  // Only written by the writer thread, under wake_mutex
+    std::condition_variable drained_condition;
+
+    std::mutex queues_mutex;
+    std::vector<RecordQueue *> queues;
+    std::thread writer;
+};
+
+// Records that do not belong to a thread, like the header and footer of the document.
+static const uint64_t API_DUMP_NO_THREAD = UINT64_MAX;
+
+// Writes the output of every thread to a file of its own, so that threads never share a stream or
+// wait on each other. vk_apidump.txt is written as vk_apidump.0.txt, vk_apidump.1.txt, ... by
+// threads 0, 1, ..., and vk_apidump.txt itself only lists those files and holds the records that
+// do not belong to a thread. Every record is preceded by a line with its place in the order of all
+// records, its type, when it was completed in nanoseconds, and its length:
+//
+//     @@ <sequence> <call|frame> <time> <length>
+//
+// api_dump_merge.py puts the records of all threads back into a single document.
+class ApiDumpThreadOutput {
+   public:
+    ApiDumpThreadOutput(const std::string &filename, const char *format_name, std::ios_base::openmode mode,
+                        const ApiDumpFlushOptions &flush_options)
+        : mode(mode), flush_options(flush_options), start(std::chrono::steady_clock::now()), next_sequence(0), stopped(false) {
+        api_dump_split_filename(filename, file_base, file_extension);
+        shared_file.stream.open(filename, mode);
+        shared_file.stream << "@@ format " << format_name << '\n';
+    }
+
+    // The stream the calling thread should write its current record to.
+    inline std::ostream &stream() { return threadState().stream; }
+
+    inline void beginRecord() { threadState().buffer.clear(); }
+
+    // Writes the calling thread's current record to the file of the given thread.
+    void endRecord(ApiDumpRecordType type, uint64_t thread) {
+        ThreadState &state = threadState();
+        ThreadFile *file = &shared_file;
+        if (thread != API_DUMP_NO_THREAD && !stopped.load(std::memory_order_relaxed)) {
+            if (state.file == nullptr) state.file = openFile(thread);
+            file = state.file;
+        } else if (thread != API_DUMP_NO_THREAD) {
+            file = openFile(thread);
+        }
+        const std::string &text = state.buffer.str();
+        std::chrono::nanoseconds time =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        {
+            // Numbered under the file's lock, so that every file is in order
+            std::lock_guard<std::mutex> lg(file->mutex);
+            uint64_t sequence = next_sequence.fetch_add(1, std::memory_order_relaxed);
+            dump_write_uint(file->stream << "@@ ", sequence);
+            file->stream << (type == ApiDumpRecordType::Call ? " call " : " frame ");
+            dump_write_uint(file->stream, time.count()) << ' ';
+            dump_write_uint(file->stream, text.size()) << '\n';
+            file->stream.write(text.data(), text.size());
+            if (flush_options.enabled && flush_options.policy == ApiDumpFlushPolicy::Call) file->stream.flush();
+        }
+        if (type == ApiDumpRecordType::Frame && flush_options.enabled && flush_options.policy == ApiDumpFlushPolicy::Frame)
+            flush();
+    }
+
+    // Flushes the files of all threads.
+    void flush() {
+        std::lock_guard<std::mutex> lg(files_mutex);
+        for (const auto &file : files) {
+            std::lock_guard<std::mutex> file_lg(file.second->mutex);
+            file.second->stream.flush();
+        }
+        std::lock_guard<std::mutex> shared_lg(shared_file.mutex);
+        shared_file.stream.flush();
+    }
+
+    // The locals of the thread that exits the process are gone by the time the layer writes its
+    // last records, those are formatted in a buffer of its own instead.
+    void stop() { stopped.store(true, std::memory_order_relaxed); }
+
+   private:
+    struct ThreadFile {
+        std::mutex mutex;
+        std::vector<char> buffer;
+        std::ofstream stream;
+    };
+
+    struct ThreadState {
+        ThreadState() : stream(&buffer), file(nullptr) {}
+
+        ApiDumpRecordBuffer buffer;
+        std::ostream stream;
+        ThreadFile *file;
+    };
+
+    inline ThreadState &threadState() {
+        if (stopped.load(std::memory_order_relaxed)) return exit_state;
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    // A thread that took over the number of one that exited continues its file.
+    ThreadFile *openFile(uint64_t thread) {
+        {
+            std::lock_guard<std::mutex> lg(files_mutex);
+            auto it = files.find(thread);
+            if (it != files.end()) return it->second.get();
+        }
+        std::string filename = file_base + "." + std::to_string(thread) + file_extension;
+        ThreadFile *file = new ThreadFile();
+        // The file buffer only writes out once it is full, which flushes every flush_bytes bytes
+        if (flush_options.enabled && flush_options.policy == ApiDumpFlushPolicy::Bytes) {
+            file->buffer.resize(flush_options.bytes);
+            file->stream.rdbuf()->pubsetbuf(file->buffer.data(), file->buffer.size());
+        }
+        file->stream.open(filename, mode);
+        {
+            std::lock_guard<std::mutex> lg(files_mutex);
+            files[thread].reset(file);
+        }
+        std::lock_guard<std::mutex> lg(shared_file.mutex);
+        dump_write_uint(shared_file.stream << "@@ thread ", thread) << ' ' << api_dump_file_name(filename) << '\n';
+        shared_file.stream.flush();
+        return file;
+    }
+
+    std::string file_base;
+    std::string file_extension;
+    std::ios_base::openmode mode;
+    ApiDumpFlushOptions flush_options;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<uint64_t> next_sequence;
+    std::atomic<bool> stopped;
+    ThreadState exit_state;
+
+    ThreadFile shared_file;
+    std::mutex files_mutex;
+    std::map<uint64_t, std::unique_ptr<ThreadFile>> files;
+};
+
+// Which failing API calls make the flight recorder write out what it holds.
+enum class ApiDumpFlightRecorderResultTrigger {
+    None,
+    DeviceLost,  // VK_ERROR_DEVICE_LOST
+    Error,       // Any VkResult error code
+};
+
+struct ApiDumpFlightRecorderOptions {
+    bool enabled;
+    uint64_t frames;  // Number of most recent frames kept, 0 keeps as many as fit in bytes
+    size_t bytes;
+    ApiDumpFlightRecorderResultTrigger result_trigger;
+    std::string trigger_file;
+};
+
+// Keeps the output of the most recent API calls in memory instead of writing it, and only writes
+// it out when triggered. Each thread encodes its records into a private buffer, like the
+// asynchronous writer does, and the finished records go into a ring that drops the oldest frames
+// once it holds more than the configured number of frames or bytes. The records are always in the
+// binary format, which api_dump_convert.py turns into text, html or json once written out.
+class ApiDumpFlightRecorder {
+   public:
+    ApiDumpFlightRecorder(std::ostream &output, const ApiDumpFlightRecorderOptions &options)
+        : output(output), options(options), current_frame(0), held_bytes(0), trigger_requested(false) {}
+
+    // The stream the calling thread should write its current record to.
+    inline std::ostream &stream() { return threadState().stream; }
+
+    inline void beginRecord() { threadState().buffer.clear(); }
+
+    void endRecord(ApiDumpRecordType type) {
+        ThreadState &state = threadState();
+        {
+            std::lock_guard<std::mutex> lg(ring_mutex);
+            if (type == ApiDumpRecordType::Frame) {
+                current_frame++;
+                if (options.frames > 0) {
+                    while (!ring.empty() && ring.front().frame + options.frames <= current_frame) drop();
+                }
+            }
+            ring.push_back(Record());
+            ring.back().frame = current_frame;
+            state.buffer.swap(ring.back().text);
+            held_bytes += ring.back().text.size();
+            while (held_bytes > options.bytes && ring.size() > 1) drop();
+        }
+
+        if (type == ApiDumpRecordType::Frame && !options.trigger_file.empty()) {
+            // Only look for the trigger file once a frame, the application may be presenting quickly
+            FILE *trigger = fopen(options.trigger_file.c_str(), "r");
+            if (trigger != NULL) {
+                fclose(trigger);
+                remove(options.trigger_file.c_str());
+                write("the trigger file");
+            }
+        }
+        writeIfRequested();
+    }
+
+    inline bool isTriggeredBy(VkResult result) const {
+        switch (options.result_trigger) {
+            case ApiDumpFlightRecorderResultTrigger::DeviceLost:
+                return result == VK_ERROR_DEVICE_LOST;
+            case ApiDumpFlightRecorderResultTrigger::Error:
+                return result < 0;
+            default:
+                return false;
+        }
+    }
+
+    // Asks for the recording to be written out at the end of the next record. Safe to call from a
+    // signal handler.
+    inline void requestWrite() { trigger_requested.store(true); }
+
+    inline void writeIfRequested() {
+        if (trigger_requested.load(std::memory_order_relaxed) && trigger_requested.exchange(false)) write("a signal");
+    }
+
+    // Writes out and empties the recording.
+    void write(const char *reason) {
+        std::lock_guard<std::mutex> lg(ring_mutex);
+        writeLocked(reason);
+    }
+
+    // Writes out the recording without waiting for other threads, for when the process is about
+    // to go down. If another thread holds the ring, it may be changing it, so nothing is written.
+    void writeNow(const char *reason) {
+        std::unique_lock<std::mutex> lock(ring_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+#ifdef ANDROID
+            __android_log_print(ANDROID_LOG_WARN, "api_dump", "Skipped writing the flight recorder, it is in use");
+#else
+            fprintf(stderr, "api_dump: skipped writing the flight recorder triggered by %s, it is in use\n", reason);
+#endif
+            return;
+        }
+        writeLocked(reason);
+    }
+
+   private:
+    struct Record {
+        uint64_t frame;
+        std::string text;
+    };
+
+    struct ThreadState {
+        ThreadState() : stream(&buffer) {}
+
+        ApiDumpRecordBuffer buffer;
+        std::ostream stream;
+    };
+
+    static inline ThreadState &threadState() {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    void drop() {
+        held_bytes -= ring.front().text.size();
+        ring.pop_front();
+    }
+
+    void writeLocked(const char *reason) {
+#ifdef ANDROID
+        __android_log_print(ANDROID_LOG_INFO, "api_dump", "Writing the flight recorder, triggered by %s", reason);
+#else
+        fprintf(stderr, "api_dump: writing the flight recorder, triggered by %s\n", reason);
+#endif
+        for (const Record &record : ring) output.write(record.text.data(), record.text.size());
+        output.flush();
+        ring.clear();
+        held_bytes = 0;
+    }
+
+    std::ostream &output;
+    ApiDumpFlightRecorderOptions options;
+
+    std::mutex ring_mutex;
+    std::deque<Record> ring;
+    uint64_t current_frame;
+    size_t held_bytes;
+    std::atomic<bool> trigger_requested;
+};
+
+// Call count and time spent in the driver for one function, with a histogram of the call
+// durations. Below 4ns every nanosecond has its own bucket, above that each power of two is split
+// into 4 buckets, so a percentile read from the histogram is within 12.5% of the real value.
+struct ApiDumpFunctionStats {
+    static const size_t BUCKET_COUNT = 184;
+
+    ApiDumpFunctionStats() : calls(0), total_ns(0), buckets() {}
+
+    inline void add(uint64_t ns) {
+        calls++;
+        total_ns += ns;
+        buckets[bucket(ns)]++;
+    }
+
+    void merge(const ApiDumpFunctionStats &other) {
+        calls += other.calls;
+        total_ns += other.total_ns;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) buckets[i] += other.buckets[i];
+    }
+
+    // The middle of the bucket holding the call at the given fraction of the calls.
+    uint64_t percentile(double fraction) const {
+        uint64_t rank = std::max<uint64_t>((uint64_t)std::ceil(fraction * calls), 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) return (bucketStart(i) + bucketStart(i + 1) - 1) / 2;
+        }
+        return 0;
+    }
+
+    static inline size_t bucket(uint64_t ns) {
+        if (ns < 4) return (size_t)ns;
+        unsigned power = floorLog2(ns);
+        return std::min<size_t>(4 * (power - 1) + ((ns >> (power - 2)) & 3), BUCKET_COUNT - 1);
+    }
+
+    static inline uint64_t bucketStart(size_t bucket) {
+        if (bucket < 4) return bucket;
+        return (uint64_t)(4 + bucket % 4) << (bucket / 4 - 1);
+    }
+
+    static inline unsigned floorLog2(uint64_t value) {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(value);
+#else
+        unsigned power = 0;
+        while (value >>= 1) power++;
+        return power;
+#endif
+    }
+
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t buckets[BUCKET_COUNT];
+};
+
+// Collects the ApiDumpFunctionStats of every call for ApiDumpFormat::Stats. Each thread counts its
+// calls in its own table, which the presenting thread merges at the end of every frame, so calls
+// only ever take their own thread's lock.
+class ApiDumpCallStats {
+   public:
+    ApiDumpCallStats() : function_count(0), summary_frames(0), summary_first_frame(0) {
+        while (api_dump_function_names[function_count] != NULL) function_count++;
+    }
+
+    inline void beginCall() { threadStats().call_start = std::chrono::steady_clock::now(); }
+
+    inline void endCall(uint32_t function) {
+        std::chrono::steady_clock::time_point call_end = std::chrono::steady_clock::now();
+        ThreadStats &stats = threadStats();
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(call_end - stats.call_start).count();
+        std::lock_guard<std::mutex> lg(stats.mutex);
+        if (!stats.functions[function]) stats.functions[function].reset(new ApiDumpFunctionStats());
+        stats.functions[function]->add(ns);
+    }
+
+    // Merges the calls made during the frame, and writes the summary once it covers
+    // frames_per_summary frames.
+    void endFrame(uint64_t frame, uint32_t frames_per_summary, std::ostream &output) {
+        mergeThreads();
+        if (++summary_frames >= frames_per_summary) writeSummary(frame, output);
+    }
+
+    // Writes out the calls made since the last summary, if there were any.
+    void writeSummary(uint64_t last_frame, std::ostream &output) {
+        mergeThreads();
+        std::vector<uint32_t> order;
+        uint64_t calls = 0;
+        uint64_t total_ns = 0;
+        for (uint32_t i = 0; i < summary.size(); ++i) {
+            if (!summary[i] || summary[i]->calls == 0) continue;
+            order.push_back(i);
+            calls += summary[i]->calls;
+            total_ns += summary[i]->total_ns;
+        }
+
+        if (calls > 0) {
+            std::sort(order.begin(), order.end(),
+                      [this](uint32_t a, uint32_t b) { return summary[a]->total_ns > summary[b]->total_ns; });
+            int name_width = 8;
+            for (uint32_t function : order) name_width = std::max(name_width, (int)strlen(api_dump_function_names[function]));
+
+            char line[512];
+            if (last_frame == summary_first_frame)
+                snprintf(line, sizeof(line), "Frame %" PRIu64 ": ", last_frame);
+            else
+                snprintf(line, sizeof(line), "Frames %" PRIu64 "-%" PRIu64 ": ", summary_first_frame, last_frame);
+            output << line;
+            snprintf(line, sizeof(line), "%" PRIu64 " calls, %.3f ms in the driver\n", calls, total_ns / 1e6);
+            output << line;
+            snprintf(line, sizeof(line), "    %-*s %10s %12s %10s %10s\n", name_width, "Function", "Calls", "Total ms",
+                     "p50 us", "p99 us");
+            output << line;
+            for (uint32_t function : order) {
+                const ApiDumpFunctionStats &stats = *summary[function];
+                snprintf(line, sizeof(line), "    %-*s %10" PRIu64 " %12.3f %10.2f %10.2f\n", name_width,
+                         api_dump_function_names[function], stats.calls, stats.total_ns / 1e6, stats.percentile(0.5) / 1e3,
+                         stats.percentile(0.99) / 1e3);
+                output << line;
+            }
+            output << "\n";
+        }
+
+        summary.clear();
+        summary_frames = 0;
+        summary_first_frame = last_frame + 1;
+    }
+
+   private:
+    struct ThreadStats {
+        std::mutex mutex;
+        std::chrono::steady_clock::time_point call_start;
+        std::vector<std::unique_ptr<ApiDumpFunctionStats>> functions;
+    };
+
+    // The table outlives its thread, so that the calls of a thread that exits mid-frame are still
+    // counted.
+    inline ThreadStats &threadStats() {
+        static thread_local std::shared_ptr<ThreadStats> stats;
+        if (!stats) {
+            stats = std::make_shared<ThreadStats>();
+            stats->functions.resize(function_count);
+            std::lock_guard<std::mutex> lg(threads_mutex);
+            threads.push_back(stats);
+        }
+        return *stats;
+    }
+
+    void mergeThreads() {
+        std::lock_guard<std::mutex> lg(threads_mutex);
+        if (summary.size() < function_count) summary.resize(function_count);
+        for (const std::shared_ptr<ThreadStats> &thread : threads) {
+            std::lock_guard<std::mutex> thread_lg(thread->mutex);
+            for (size_t i = 0; i < function_count; ++i) {
+                if (!thread->functions[i] || thread->functions[i]->calls == 0) continue;
+                if (!summary[i]) summary[i].reset(new ApiDumpFunctionStats());
+                summary[i]->merge(*thread->functions[i]);
+                *thread->functions[i] = ApiDumpFunctionStats();
+            }
+        }
+        // Drop the tables of threads that have exited, now that their calls are merged
+        threads.erase(std::remove_if(threads.begin(), threads.end(),
+                                     [](const std::shared_ptr<ThreadStats> &thread) { return thread.use_count() == 1; }),
+                      threads.end());
+    }
+
+    size_t function_count;
+    std::mutex threads_mutex;
+    std::vector<std::shared_ptr<ThreadStats>> threads;
+    std::vector<std::unique_ptr<ApiDumpFunctionStats>> summary;
+    uint32_t summary_frames;
+    uint64_t summary_first_frame;
+};
+
+// MurmurHash3 x64 128 by Austin Appleby, placed in the public domain. Fast enough to hash every
+// payload the blob store sees, and wide enough that two different blobs never share a name.
+inline uint64_t api_dump_hash_fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+inline uint64_t api_dump_hash_rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline void api_dump_hash128(const void *data, size_t size, uint64_t hash[2]) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    const size_t block_count = size / 16;
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+
+    for (size_t i = 0; i < block_count; ++i) {
+        uint64_t k1, k2;
+        memcpy(&k1, bytes + i * 16, 8);
+        memcpy(&k2, bytes + i * 16 + 8, 8);
+        h1 ^= api_dump_hash_rotl(k1 * c1, 31) * c2;
+        h1 = (api_dump_hash_rotl(h1, 27) + h2) * 5 + 0x52dce729;
+        h2 ^= api_dump_hash_rotl(k2 * c2, 33) * c1;
+        h2 = (api_dump_hash_rotl(h2, 31) + h1) * 5 + 0x38495ab5;
+    }
+
+    const uint8_t *tail = bytes + block_count * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    switch (size & 15) {
+        case 15: k2 ^= (uint64_t)tail[14] << 48;
+        case 14: k2 ^= (uint64_t)tail[13] << 40;
+        case 13: k2 ^= (uint64_t)tail[12] << 32;
+        case 12: k2 ^= (uint64_t)tail[11] << 24;
+        case 11: k2 ^= (uint64_t)tail[10] << 16;
+        case 10: k2 ^= (uint64_t)tail[9] << 8;
+        case 9:
+            k2 ^= (uint64_t)tail[8];
+            h2 ^= api_dump_hash_rotl(k2 * c2, 33) * c1;
+        case 8: k1 ^= (uint64_t)tail[7] << 56;
+        case 7: k1 ^= (uint64_t)tail[6] << 48;
+        case 6: k1 ^= (uint64_t)tail[5] << 40;
+        case 5: k1 ^= (uint64_t)tail[4] << 32;
+        case 4: k1 ^= (uint64_t)tail[3] << 24;
+        case 3: k1 ^= (uint64_t)tail[2] << 16;
+        case 2: k1 ^= (uint64_t)tail[1] << 8;
+        case 1:
+            k1 ^= (uint64_t)tail[0];
+            h1 ^= api_dump_hash_rotl(k1 * c1, 31) * c2;
+    }
+
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = api_dump_hash_fmix(h1);
+    h2 = api_dump_hash_fmix(h2);
+    h1 += h2;
+    h2 += h1;
+    hash[0] = h1;
+    hash[1] = h2;
+}
 
-// Defines for utilized environment variables.
-#define API_DUMP_ENV_VAR_LOG_FILE "VK_APIDUMP_LOG_FILENAME"
-#define API_DUMP_ENV_VAR_OUTPUT_FMT "VK_APIDUMP_OUTPUT_FORMAT"
-#define API_DUMP_ENV_VAR_DETAILED_OUTPUT "VK_APIDUMP_DETAILED"
-#define API_DUMP_ENV_VAR_NO_ADDRESSES "VK_APIDUMP_NO_ADDR"
-#define API_DUMP_ENV_VAR_FLUSH_FILE "VK_APIDUMP_FLUSH"
-#define API_DUMP_ENV_VAR_OUTPUT_RANGE "VK_APIDUMP_OUTPUT_RANGE"
-#define API_DUMP_ENV_VAR_TIMESTAMP "VK_APIDUMP_TIMESTAMP"
+// Writes shader code and other large payloads to files next to the output, named after a hash of
+// their contents, so that a payload the application passes again and again is only written once.
+// Files left by an earlier run are reused, since the same name means the same contents.
+class ApiDumpBlobStore {
+   public:
+    ApiDumpBlobStore(const std::string &directory, size_t min_size) : directory(directory), min_size(min_size) {}
+
+    // Returns the name of the file holding the payload, or an empty string if the payload is
+    // smaller than the minimum blob size and should be written inline instead.
+    std::string store(const void *data, size_t size) {
+        if (size < min_size) return std::string();
+
+        uint64_t hash[2];
+        api_dump_hash128(data, size, hash);
+        char name[64];
+        char *end = name + sizeof(name);
+        memcpy(end - 5, ".bin", 5);
+        format_hex(hash[1], end - 5, 16, false);
+        format_hex(hash[0], end - 21, 16, false);
+        memcpy(end - 42, "blob_", 5);
+        std::string file_name(end - 42);
+
+        bool first_use;
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            first_use = written.insert(std::make_pair(hash[0], hash[1])).second;
+        }
+        if (first_use) {
+            const std::string path = directory + file_name;
+            FILE *file = fopen(path.c_str(), "rb");
+            if (file != NULL) {
+                fclose(file);
+            } else if ((file = fopen(path.c_str(), "wb")) != NULL) {
+                fwrite(data, 1, size, file);
+                fclose(file);
+            }
+        }
+        return file_name;
+    }
 
-enum class ApiDumpFormat {
-    Text,
-    Html,
-    Json,
+   private:
+    std::string directory;
+    size_t min_size;
+    std::mutex mutex;
+    std::set<std::pair<uint64_t, uint64_t>> written;
 };
 
-static const uint64_t OUTPUT_RANGE_UNLIMITED = 0;
-static const uint64_t OUTPUT_RANGE_INTERVAL_DEFAULT = 1;
+// Holds back the API calls that are identical to the matching call of the previous frame, for the
+// delta output mode. Each call is formatted into a per-thread buffer, and only the part after its
+// head, the result and the parameters, is compared. Calls recorded into a command buffer match the
+// call at the same position in the previous recording of that command buffer, other calls the call
+// at the same position among those their thread made in the previous frame. A thread that takes
+// over the number of one that exited continues its history.
+class ApiDumpDeltaFilter {
+   public:
+    ApiDumpDeltaFilter()
+        : begin_command_buffer(UINT32_MAX), frame(0), identical_calls(0), json_call_on_frame(false), stopped(false) {
+        for (uint32_t i = 0; api_dump_function_names[i] != NULL; ++i) {
+            if (strcmp(api_dump_function_names[i], "vkBeginCommandBuffer") == 0) begin_command_buffer = i;
+        }
+    }
 
-struct FrameRange {
-    uint64_t start_frame;  // The range begins on this frame, inclusive.
-    uint64_t frame_count;  // If value is OUTPUT_RANGE_UNLIMITED, dump continues without limit.
-    uint64_t interval;     // Rate at which frames are dumped. A value of 3 will dump every third frame.
-};
+    // The stream the calling thread should write its current call to, NULL outside of a call.
+    inline std::ostream *recordingStream() {
+        ThreadState &state = threadState();
+        return state.recording ? &state.stream : NULL;
+    }
 
-class ConditionalFrameOutput {
-    bool use_conditional_output = false;
-    std::set<uint64_t> frames;
-    std::vector<FrameRange> ranges;
+    inline void beginCall() {
+        ThreadState &state = threadState();
+        state.buffer.clear();
+        state.body_start = 0;
+        state.function = UINT32_MAX;
+        state.command_buffer = 0;
+        state.recording = true;
+    }
 
-    struct NumberToken {
-        uint64_t value;
-        uint32_t length;
-    };
+    // Marks where the result and the parameters of the current call start. Takes a generated
+    // function id, and the command buffer the call records into, if any.
+    inline void beginBody(uint32_t function, uint64_t command_buffer) {
+        ThreadState &state = threadState();
+        state.body_start = state.buffer.size();
+        state.function = function;
+        state.command_buffer = command_buffer;
+    }
 
-    inline NumberToken parseNumber(std::string str, uint32_t current_char) {
-        uint32_t length = 0;
-        while (current_char + length < str.size() && str[current_char + length] >= '0' && str[current_char + length] <= '9') {
-            length++;
-        }
-        if (length > 0) {
-            uint64_t value = std::atol(&str[current_char]);
-            return NumberToken{value, length};
+    // Ends the current call of the given thread, and returns true if it is identical to the matching
+    // call of the previous frame and should not be written.
+    bool endCall(uint64_t thread) {
+        ThreadState &state = threadState();
+        state.recording = false;
+        const std::string &text = state.buffer.str();
+        uint64_t hash[2];
+        api_dump_hash128(text.data() + state.body_start, text.size() - state.body_start, hash);
+        hash[0] ^= (uint64_t)state.function * 0x9e3779b97f4a7c15ULL;
+
+        bool identical;
+        if (state.command_buffer != 0) {
+            const bool begins = state.function == begin_command_buffer;
+            command_buffers.update(state.command_buffer, [&](CallHashes &calls) {
+                if (begins) {
+                    calls.previous.swap(calls.current);
+                    calls.current.clear();
+                }
+                identical = matches(calls, hash[0]);
+            });
         } else {
-            return NumberToken{0, 0};
+            if (state.thread_calls == NULL) {
+                std::lock_guard<std::mutex> lg(threads_mutex);
+                state.thread_calls = &threads[thread];
+            }
+            ThreadCalls &thread_calls = *state.thread_calls;
+            uint64_t current_frame = frame.load(std::memory_order_relaxed);
+            if (thread_calls.frame != current_frame) {
+                // Calls made frames ago are not compared against
+                if (thread_calls.frame + 1 == current_frame)
+                    thread_calls.calls.previous.swap(thread_calls.calls.current);
+                else
+                    thread_calls.calls.previous.clear();
+                thread_calls.calls.current.clear();
+                thread_calls.frame = current_frame;
+            }
+            identical = matches(thread_calls.calls, hash[0]);
         }
+        if (identical) identical_calls.fetch_add(1, std::memory_order_relaxed);
+        return identical;
     }
 
-    inline void printErrorMsg(const char *msg) {
-#ifdef ANDROID
-        __android_log_print(ANDROID_LOG_DEBUG, "api_dump", "%s", msg);
-#else
-        fprintf(stderr, "%s", msg);
-#endif
+    // The output of the last call, once it ended.
+    inline const std::string &text() { return threadState().buffer.str(); }
+
+    // Called at every frame boundary, returns the number of calls held back in the frame that ended.
+    inline uint64_t endFrame() {
+        frame.fetch_add(1, std::memory_order_relaxed);
+        json_call_on_frame.store(false, std::memory_order_relaxed);
+        return identical_calls.exchange(0);
+    }
+
+    // True if a json call written out needs a separator from the one before it in its frame.
+    inline bool separateJsonCall() { return json_call_on_frame.exchange(true, std::memory_order_relaxed); }
+
+    // Forgets the recordings of command buffers that were freed.
+    void eraseCommandBuffer(uint64_t command_buffer) { command_buffers.erase(command_buffer); }
+
+    // The locals of the thread that exits the process are gone by the time the layer writes its
+    // last records, any call after this is formatted in a buffer of its own instead.
+    void stop() { stopped.store(true, std::memory_order_relaxed); }
+
+   private:
+    struct CallHashes {
+        std::vector<uint64_t> previous;
+        std::vector<uint64_t> current;
+    };
+
+    struct ThreadCalls {
+        ThreadCalls() : frame(0) {}
+
+        uint64_t frame;
+        CallHashes calls;
+    };
+
+    struct ThreadState {
+        ThreadState()
+            : stream(&buffer), recording(false), body_start(0), function(UINT32_MAX), command_buffer(0), thread_calls(NULL) {}
+
+        ApiDumpRecordBuffer buffer;
+        std::ostream stream;
+        bool recording;
+        size_t body_start;
+        uint32_t function;
+        uint64_t command_buffer;
+        ThreadCalls *thread_calls;
+    };
+
+    inline ThreadState &threadState() {
+        if (stopped.load(std::memory_order_relaxed)) return exit_state;
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    static inline bool matches(CallHashes &calls, uint64_t hash) {
+        size_t position = calls.current.size();
+        calls.current.push_back(hash);
+        return position < calls.previous.size() && calls.previous[position] == hash;
     }
 
+    uint32_t begin_command_buffer;
+    std::atomic<uint64_t> frame;
+    std::atomic<uint64_t> identical_calls;
+    std::atomic<bool> json_call_on_frame;
+    std::atomic<bool> stopped;
+    ThreadState exit_state;
+
+    std::mutex threads_mutex;
+    std::unordered_map<uint64_t, ThreadCalls> threads;
+    ApiDumpShardedMap<uint64_t, CallHashes> command_buffers;
+};
+
+// What was recorded into a command buffer since it was last begun, written with the vkQueueSubmit
+// that submits it when the command buffer summary mode is enabled.
+struct ApiDumpCmdBufferSummary {
+    enum Category { Draw, Dispatch, Copy, Barrier, DescriptorBind, PipelineBind, Other, CategoryCount };
+
+    ApiDumpCmdBufferSummary() : commandBuffer(VK_NULL_HANDLE), counts() {}
+
+    VkCommandBuffer commandBuffer;
+    uint64_t counts[CategoryCount];
+    std::vector<VkPipeline> pipelines;  // The distinct pipelines bound, in the order of their handles
+};
+
+static const char *const API_DUMP_CMD_BUFFER_SUMMARY_NAMES[ApiDumpCmdBufferSummary::CategoryCount] = {
+    "draws", "dispatches", "copies", "barriers", "descriptorBinds", "pipelineBinds", "otherCommands",
+};
+
+// Counts the commands recorded into each command buffer for the command buffer summary mode, in
+// which vkCmd* calls are not written one by one.
+class ApiDumpCmdBufferSummaries {
    public:
-    /* Parses a string for a comma seperated list of frames & frame ranges
-     * where frames are singular integers and frame ranges are of the following
-     * format: "S-C-I" with S is the start frame, C is the count of frames to dump,
-     * and I the interval between dumped frames.
-     * Valid range strings: "2,3,5", "4-4-2", "3-6, 10-2"
-     */
-    bool parseConditionalFrameRange(std::string range_str) {
-        uint32_t current_char = 0;
-
-        if (range_str.empty()) {
-            printErrorMsg("Conditional range error: format string was empty\n");
-            return false;
+    ApiDumpCmdBufferSummaries() {
+        for (size_t i = 0; api_dump_function_names[i] != NULL; ++i) actions.push_back(actionOf(api_dump_function_names[i]));
+    }
+
+    // Called with every call on a command buffer. Takes a generated function id, and the pipeline
+    // bound by vkCmdBindPipeline.
+    void addCall(VkCommandBuffer command_buffer, uint32_t function, uint64_t pipeline) {
+        int action = actions[function];
+        if (action == NONE) return;
+        if (action == RESET) {
+            command_buffers.erase(command_buffer);
+            return;
         }
+        command_buffers.update(command_buffer, [action, pipeline](Recording &recording) {
+            recording.counts[action]++;
+            if (pipeline != 0) recording.pipelines.insert(pipeline);
+        });
+    }
 
-        while (current_char < range_str.size()) {
-            NumberToken frame_number = parseNumber(range_str, current_char);
-            if (frame_number.length <= 0) {
-                printErrorMsg("Conditional range error: Invalid frame number\n");
-                return false;
+    // The summaries of the command buffers of a vkQueueSubmit, in the order they are submitted.
+    std::vector<ApiDumpCmdBufferSummary> summarize(uint32_t submit_count, const VkSubmitInfo *submits) {
+        std::vector<ApiDumpCmdBufferSummary> summaries;
+        for (uint32_t i = 0; i < submit_count && submits != NULL; ++i) {
+            for (uint32_t j = 0; j < submits[i].commandBufferCount && submits[i].pCommandBuffers != NULL; ++j) {
+                summaries.push_back(ApiDumpCmdBufferSummary());
+                ApiDumpCmdBufferSummary &summary = summaries.back();
+                summary.commandBuffer = submits[i].pCommandBuffers[j];
+                command_buffers.visit(summary.commandBuffer, [&summary](const Recording &recording) {
+                    std::copy(recording.counts, recording.counts + ApiDumpCmdBufferSummary::CategoryCount, summary.counts);
+                    for (uint64_t pipeline : recording.pipelines) summary.pipelines.push_back((VkPipeline)pipeline);
+                });
             }
-            current_char += frame_number.length;
-
-            // Range of frames
-            if (range_str[current_char] == '-') {
-                current_char++;
-                if (current_char >= range_str.size()) {
-                    printErrorMsg("Conditional range error: Must have number for frame count\n");
-                    return false;
-                }
-                NumberToken frame_count = parseNumber(range_str, current_char);
-                if (frame_count.length <= 0) {
-                    printErrorMsg("Conditional range error: Invalid frame count\n");
-                    return false;
-                }
-                current_char += frame_count.length;
+        }
+        return summaries;
+    }
 
-                if (current_char >= range_str.size()) {
-                    // Frame Range w/o interval
-                    ranges.push_back(FrameRange{frame_number.value, frame_count.value, 1l});
-                    use_conditional_output = true;
-                    return true;
-                }
+    void eraseCommandBuffer(VkCommandBuffer command_buffer) { command_buffers.erase(command_buffer); }
 
-                else if (range_str[current_char] == '-') {
-                    current_char++;
-                    if (current_char >= range_str.size()) {
-                        printErrorMsg("Conditional range error: Must have number for frame interval \n");
-                        return false;
-                    }
+   private:
+    static const int NONE = -1;
+    static const int RESET = -2;
 
-                    NumberToken frame_interval = parseNumber(range_str, current_char);
-                    if (frame_interval.length <= 0) {
-                        printErrorMsg("Conditional range error: Invalid interval\n");
-                        return false;
-                    }
+    struct Recording {
+        Recording() : counts() {}
 
-                    // Frame Range w/ interval
-                    ranges.push_back(FrameRange{frame_number.value, frame_count.value, frame_interval.value});
+        uint64_t counts[ApiDumpCmdBufferSummary::CategoryCount];
+        std::set<uint64_t> pipelines;
+    };
 
-                    current_char += frame_interval.length;
-                    if (current_char >= range_str.size()) {
-                        use_conditional_output = true;
-                        return true;
-                    }
-                } else {
-                    // Frame Range w/o interval
-                    ranges.push_back(FrameRange{frame_number.value, frame_count.value, 1l});
-                }
-            } else {
-                // Single frame capture
-                frames.insert(frame_number.value);
-            }
-            if (range_str[current_char] == ',') {
-                current_char++;
-            }
+    static int actionOf(const char *name) {
+        static const struct {
+            const char *prefix;
+            ApiDumpCmdBufferSummary::Category category;
+        } categories[] = {
+            {"vkCmdDraw", ApiDumpCmdBufferSummary::Draw},
+            {"vkCmdDispatch", ApiDumpCmdBufferSummary::Dispatch},
+            {"vkCmdCopy", ApiDumpCmdBufferSummary::Copy},
+            {"vkCmdBlit", ApiDumpCmdBufferSummary::Copy},
+            {"vkCmdResolve", ApiDumpCmdBufferSummary::Copy},
+            {"vkCmdUpdateBuffer", ApiDumpCmdBufferSummary::Copy},
+            {"vkCmdFillBuffer", ApiDumpCmdBufferSummary::Copy},
+            {"vkCmdPipelineBarrier", ApiDumpCmdBufferSummary::Barrier},
+            {"vkCmdWaitEvents", ApiDumpCmdBufferSummary::Barrier},
+            {"vkCmdBindDescriptorSets", ApiDumpCmdBufferSummary::DescriptorBind},
+            {"vkCmdPushDescriptorSet", ApiDumpCmdBufferSummary::DescriptorBind},
+            {"vkCmdBindPipeline", ApiDumpCmdBufferSummary::PipelineBind},
+            {"vkCmd", ApiDumpCmdBufferSummary::Other},
+        };
+        if (strcmp(name, "vkBeginCommandBuffer") == 0 || strcmp(name, "vkResetCommandBuffer") == 0) return RESET;
+        for (const auto &category : categories) {
+            if (strncmp(name, category.prefix, strlen(category.prefix)) == 0) return category.category;
         }
-        use_conditional_output = true;
-        return true;
+        return NONE;
     }
 
-    // Return true if either use_conditional_output is false or if frame_count is within
-    // the provided frame ranges
-    bool isFrameInRange(uint64_t frame_number) const {
-        if (!use_conditional_output) return true;
-        for (auto &range : ranges) {
-            if (range.start_frame <= frame_number) {
-                if (range.frame_count == OUTPUT_RANGE_UNLIMITED) {
-                    if (range.interval == OUTPUT_RANGE_INTERVAL_DEFAULT) {
-                        return true;
-                    } else {
-                        return (frame_number - range.start_frame) % range.interval == 0;
-                    }
+    std::vector<int> actions;
+    ApiDumpShardedMap<VkCommandBuffer, Recording> command_buffers;
+};
 
-                } else if (range.start_frame + range.frame_count > frame_number) {
-                    if (range.interval == OUTPUT_RANGE_INTERVAL_DEFAULT) {
-                        return true;
-                    } else {
-                        return (frame_number - range.start_frame) % range.interval == 0;
-                    }
-                }
+// Only dumps some of the calls to the sampled functions, every Nth call or each call with a fixed
+// probability, so that the cost of dumping does not grow with the number of draws in a frame. Each
+// thread counts its own calls and is the only one to write its counters, they are only added up at
+// frame boundaries to report how many calls of each function were sampled out of how many made.
+class ApiDumpSampler {
+   public:
+    struct Counts {
+        uint32_t function;
+        uint64_t sampled;
+        uint64_t total;
+    };
+
+    // Takes the functions to sample, indexed by generated function id. A rate below 1 samples calls
+    // at random with that probability, from a sequence seeded per thread, instead of every Nth call.
+    ApiDumpSampler(const std::vector<bool> &sampled_functions, uint64_t interval, double rate, uint64_t seed)
+        : sampled_functions(sampled_functions),
+          interval(std::max(interval, (uint64_t)1)),
+          rate(rate),
+          seed(seed),
+          last_totals(sampled_functions.size()),
+          last_sampled(sampled_functions.size()) {}
+
+    // Counts a call the calling thread makes and returns true if it is dumped. Takes the number of
+    // the thread and a generated function id.
+    inline bool sample(uint64_t thread, uint32_t function) {
+        if (!sampled_functions[function]) return true;
+        ThreadCounters &counters = threadCounters(thread);
+        uint64_t total = counters.totals[function].load(std::memory_order_relaxed);
+        counters.totals[function].store(total + 1, std::memory_order_relaxed);
+        bool dumped = rate < 1.0 ? nextRandom(counters.random) < rate : total % interval == 0;
+        if (dumped) {
+            uint64_t sampled = counters.sampled[function].load(std::memory_order_relaxed);
+            counters.sampled[function].store(sampled + 1, std::memory_order_relaxed);
+        }
+        return dumped;
+    }
+
+    // Called at every frame boundary, returns the counts of the functions called in the frame that
+    // ended. Calls made by other threads while the counters are read count towards either frame.
+    std::vector<Counts> endFrame() {
+        std::vector<Counts> frame_counts;
+        std::vector<uint64_t> totals(sampled_functions.size());
+        std::vector<uint64_t> sampled(sampled_functions.size());
+        std::lock_guard<std::mutex> lg(threads_mutex);
+        for (const auto &thread : threads) {
+            for (size_t i = 0; i < sampled_functions.size(); ++i) {
+                totals[i] += thread.second->totals[i].load(std::memory_order_relaxed);
+                sampled[i] += thread.second->sampled[i].load(std::memory_order_relaxed);
             }
         }
-        if (frames.count(frame_number) > 0) {
-            return true;
+        for (uint32_t i = 0; i < (uint32_t)sampled_functions.size(); ++i) {
+            if (totals[i] == last_totals[i]) continue;
+            Counts counts = {i, sampled[i] - last_sampled[i], totals[i] - last_totals[i]};
+            frame_counts.push_back(counts);
         }
-        return false;
+        last_totals.swap(totals);
+        last_sampled.swap(sampled);
+        return frame_counts;
+    }
+
+   private:
+    struct ThreadCounters {
+        ThreadCounters(size_t function_count, uint64_t random)
+            : totals(function_count), sampled(function_count), random(random) {}
+
+        std::vector<std::atomic<uint64_t>> totals;
+        std::vector<std::atomic<uint64_t>> sampled;
+        uint64_t random;
+    };
+
+    // A thread that takes over the number of one that exited continues its counts.
+    ThreadCounters &threadCounters(uint64_t thread) {
+        static thread_local ThreadCounters *counters = NULL;
+        if (counters != NULL) return *counters;
+        std::lock_guard<std::mutex> lg(threads_mutex);
+        std::unique_ptr<ThreadCounters> &slot = threads[thread];
+        if (!slot) slot.reset(new ThreadCounters(sampled_functions.size(), seed ^ (thread * 0x9E3779B97F4A7C15ull)));
+        counters = slot.get();
+        return *counters;
+    }
+
+    // A uniformly distributed number in [0, 1), from a splitmix64 sequence.
+    static inline double nextRandom(uint64_t &state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        return (double)(z >> 11) / 9007199254740992.0;
     }
+
+    std::vector<bool> sampled_functions;
+    uint64_t interval;
+    double rate;
+    uint64_t seed;
+    std::mutex threads_mutex;
+    std::map<uint64_t, std::unique_ptr<ThreadCounters>> threads;
+    std::vector<uint64_t> last_totals;
+    std::vector<uint64_t> last_sampled;
 };
 
 class ApiDumpSettings {
@@ -250,34 +2255,120 @@ class ApiDumpSettings {
         if (!env_value.empty()) {
             filename_string = env_value;
         }
+
+        // The format is needed before the file is opened, binary captures must not translate newlines.
+        output_format = readFormatOption("lunarg_api_dump.output_format", ApiDumpFormat::Text);
+        json_lines = ToLowerString(getLayerOption("lunarg_api_dump.output_format")) == "ndjson";
+        env_value = GetPlatformEnvVar(API_DUMP_ENV_VAR_OUTPUT_FMT);
+        if (!env_value.empty()) {
+            json_lines = ToLowerString(env_value) == "ndjson";
+            if (ToLowerString(env_value) == "html") {
+                output_format = ApiDumpFormat::Html;
+            } else if (ToLowerString(env_value) == "json" || json_lines) {
+                output_format = ApiDumpFormat::Json;
+            } else if (ToLowerString(env_value) == "binary") {
+                output_format = ApiDumpFormat::Binary;
+            } else if (ToLowerString(env_value) == "stats") {
+                output_format = ApiDumpFormat::Stats;
+            } else if (ToLowerString(env_value) == "trace") {
+                output_format = ApiDumpFormat::Trace;
+            } else {
+                output_format = ApiDumpFormat::Text;
+            }
+        }
+
+        // The flight recorder holds compact binary records, so that calls cost little more than
+        // copying their values while nothing is written. Statistics have no records to hold.
+        bool flight_recorder = readBoolOption("lunarg_api_dump.flight_recorder", false) && output_format != ApiDumpFormat::Stats;
+        if (flight_recorder) {
+            output_format = ApiDumpFormat::Binary;
+            json_lines = false;
+        }
+
+        // The flush policy is also needed before the file is opened, to size the file buffer.
+        flush_options.enabled = readBoolOption("lunarg_api_dump.flush", true);
+        env_value = GetPlatformEnvVar(API_DUMP_ENV_VAR_FLUSH_FILE);
+        if (!env_value.empty()) {
+            flush_options.enabled = !GetStringBooleanValue(env_value);
+        }
+        flush_options.policy = readFlushPolicyOption("lunarg_api_dump.flush_policy", ApiDumpFlushPolicy::Call);
+        flush_options.interval = std::chrono::milliseconds(std::max(readIntOption("lunarg_api_dump.flush_interval_ms", 100), 1));
+        int flush_bytes = readIntOption("lunarg_api_dump.flush_bytes", 65536);
+        flush_options.bytes = flush_bytes > 0 ? flush_bytes : 65536;
+
+        std::string compression = getLayerOption("lunarg_api_dump.compression");
+        env_value = GetPlatformEnvVar(API_DUMP_ENV_VAR_COMPRESSION);
+        if (!env_value.empty()) {
+            compression = env_value;
+        }
+        bool compress = ToLowerString(compression) == "gzip";
+
+        // Segments end at frame boundaries, which the statistics and the flight recorder do not write.
+        ApiDumpSegmentOptions segment_options;
+        segment_options.frames = std::max(readIntOption("lunarg_api_dump.segment_frames", 0), 0);
+        segment_options.bytes = (uint64_t)std::max(readIntOption("lunarg_api_dump.segment_size_mb", 0), 0) * 1024 * 1024;
+        bool segmented =
+            (segment_options.frames > 0 || segment_options.bytes > 0) && output_format != ApiDumpFormat::Stats && !flight_recorder;
+        // So does writing a file per thread, which takes the place of segments
+        bool per_thread =
+            readBoolOption("lunarg_api_dump.per_thread_output", false) && output_format != ApiDumpFormat::Stats && !flight_recorder;
+        if (per_thread) segmented = false;
+
         // If one of the above has set a filename, open the file as an output stream.
         if (!filename_string.empty()) {
             use_cout = false;
-            output_stream.open(filename_string, std::ofstream::out | std::ostream::trunc);
+            std::ios_base::openmode mode = std::ofstream::out | std::ostream::trunc;
+            if (output_format == ApiDumpFormat::Binary) mode |= std::ofstream::binary;
+            // The file buffer only writes out once it is full, which flushes every flush_bytes bytes.
+            size_t buffer_size = BUFSIZ;
+            if (flush_options.enabled && flush_options.policy == ApiDumpFlushPolicy::Bytes) buffer_size = flush_options.bytes;
+            if (per_thread) {
+                if (compress) warnCompressionIgnored("per-thread output is not compressed");
+                thread_output = new ApiDumpThreadOutput(filename_string, documentFormatName(), mode, flush_options);
+            } else if (segmented) {
+                if (compress) warnCompressionIgnored("segmented output is not compressed");
+                segmented_output = new ApiDumpSegmentedOutput(
+                    filename_string, documentFormatName(), mode, buffer_size, segment_options,
+                    [this](std::ostream &output) { writeHeader(output); }, [this](std::ostream &output) { writeFooter(output); });
+            } else {
+                // The extension follows the compression, vk_apidump.txt is written to vk_apidump.txt.gz
+                if (compress) {
+                    std::string gzip_filename = filename_string;
+                    const char *extension = ".gz";
+                    if (gzip_filename.size() < 3 || gzip_filename.compare(gzip_filename.size() - 3, 3, extension) != 0)
+                        gzip_filename += extension;
+                    compressed_output = api_dump_open_gzip_output(gzip_filename);
+                    if (compressed_output != NULL) {
+                        filename_string = gzip_filename;
+                        compressed_stream.rdbuf(compressed_output);
+                        // A flush waits for the compressor to write out everything so far, once a frame is
+                        // enough to keep compressing off of the application threads
+                        if (flush_options.policy == ApiDumpFlushPolicy::Call) flush_options.policy = ApiDumpFlushPolicy::Frame;
+                    } else {
+                        warnCompressionIgnored("the layer was built without zlib or the gzip file could not be opened");
+                    }
+                }
+                if (compressed_output == NULL) {
+                    if (buffer_size != BUFSIZ) {
+                        output_buffer.resize(buffer_size);
+                        output_stream.rdbuf()->pubsetbuf(output_buffer.data(), output_buffer.size());
+                    }
+                    output_stream.open(filename_string, mode);
+                }
+            }
             size_t last_slash_idx = filename_string.find_last_of("\\/");
             if (std::string::npos != last_slash_idx) {
                 output_dir = filename_string.substr(0, last_slash_idx + 1);
             }
         } else {
             // Otherwise, fallback to cout only
+            if (compress) warnCompressionIgnored("output to stdout is not compressed");
             use_cout = true;
         }
 
         // Get the remaining settings (some we also want to provide the ability to override
         // using environment variables).
 
-        output_format = readFormatOption("lunarg_api_dump.output_format", ApiDumpFormat::Text);
-        env_value = GetPlatformEnvVar(API_DUMP_ENV_VAR_OUTPUT_FMT);
-        if (!env_value.empty()) {
-            if (ToLowerString(env_value) == "html") {
-                output_format = ApiDumpFormat::Html;
-            } else if (ToLowerString(env_value) == "json") {
-                output_format = ApiDumpFormat::Json;
-            } else {
-                output_format = ApiDumpFormat::Text;
-            }
-        }
-
         show_params = readBoolOption("lunarg_api_dump.detailed", true);
         env_value = GetPlatformEnvVar(API_DUMP_ENV_VAR_DETAILED_OUTPUT);
         if (!env_value.empty()) {
@@ -290,12 +2381,6 @@ class ApiDumpSettings {
             show_address = !GetStringBooleanValue(env_value);
         }
 
-        should_flush = readBoolOption("lunarg_api_dump.flush", true);
-        env_value = GetPlatformEnvVar(API_DUMP_ENV_VAR_FLUSH_FILE);
-        if (!env_value.empty()) {
-            should_flush = !GetStringBooleanValue(env_value);
-        }
-
         show_timestamp = readBoolOption("lunarg_api_dump.show_timestamp", false);
         env_value = GetPlatformEnvVar(API_DUMP_ENV_VAR_TIMESTAMP);
         if (!env_value.empty()) {
@@ -307,8 +2392,39 @@ class ApiDumpSettings {
         name_size = std::max(readIntOption("lunarg_api_dump.name_size", 32), 0);
         type_size = std::max(readIntOption("lunarg_api_dump.type_size", 0), 0);
         use_spaces = readBoolOption("lunarg_api_dump.use_spaces", true);
+        // One call per line, without indentation or line breaks inside of it
+        if (json_lines) {
+            indent_size = 0;
+            use_spaces = true;
+            json_line_break = dump_no_line_break;
+        }
+        // Picked once, so that formatting a value does not look at these settings again
+        if (use_spaces)
+            name_type_formatter = show_type ? &ApiDumpSettings::formatNameTypeAs<true, true>
+                                            : &ApiDumpSettings::formatNameTypeAs<true, false>;
+        else
+            name_type_formatter = show_type ? &ApiDumpSettings::formatNameTypeAs<false, true>
+                                            : &ApiDumpSettings::formatNameTypeAs<false, false>;
         show_shader = readBoolOption("lunarg_api_dump.show_shader", false);
         show_thread_and_frame = readBoolOption("lunarg_api_dump.show_thread_and_frame", true);
+        bool async_output = readBoolOption("lunarg_api_dump.async_output", false);
+
+        ApiDumpFlightRecorderOptions flight_recorder_options;
+        flight_recorder_options.enabled = flight_recorder;
+        flight_recorder_options.frames = std::max(readIntOption("lunarg_api_dump.flight_recorder_frames", 3), 0);
+        int flight_recorder_size_mb = readIntOption("lunarg_api_dump.flight_recorder_size_mb", 64);
+        flight_recorder_options.bytes = (size_t)(flight_recorder_size_mb > 0 ? flight_recorder_size_mb : 64) * 1024 * 1024;
+        flight_recorder_options.result_trigger = readResultTriggerOption("lunarg_api_dump.flight_recorder_trigger_result",
+                                                                         ApiDumpFlightRecorderResultTrigger::DeviceLost);
+        flight_recorder_options.trigger_file = getLayerOption("lunarg_api_dump.flight_recorder_trigger_file");
+
+        // Statistics are written by the presenting thread, there are no records to buffer or hold back
+        stats_frames = std::max(readIntOption("lunarg_api_dump.stats_frames", 1), 1);
+        if (output_format == ApiDumpFormat::Stats) async_output = false;
+        // Names interned in one segment would be missing from the next
+        if (segmented_output != NULL) api_dump_binary_intern_names = false;
+        // Each thread already writes on its own
+        if (thread_output != NULL) async_output = false;
 
         std::string cond_range_string;
         env_value = GetPlatformEnvVar(API_DUMP_ENV_VAR_OUTPUT_RANGE);
@@ -321,17 +2437,130 @@ class ApiDumpSettings {
         if (cond_range_string == "" || cond_range_string == "0-0") {  //"0-0" is every frame, no need to check
             use_conditional_output = false;
         } else {
-            bool parsingStatus = condFrameOutput.parseConditionalFrameRange(cond_range_string);
-            if (!parsingStatus) {
-                use_conditional_output = false;
+            std::string error;
+            use_conditional_output = output_schedule.parse(cond_range_string, error);
+            if (!use_conditional_output) {
+#ifdef ANDROID
+                __android_log_print(ANDROID_LOG_DEBUG, "api_dump", "Conditional range error: %s\n", error.c_str());
+#else
+                fprintf(stderr, "Conditional range error: %s\n", error.c_str());
+#endif
             }
         }
+        if (use_conditional_output) output_cursor.reset(output_schedule);
+
+        std::string control_file = getLayerOption("lunarg_api_dump.control_file");
+        if (!control_file.empty()) capture_control = new CaptureControl(control_file, "api_dump");
+
+        // Only the formats that are read as text have calls worth comparing, binary captures are
+        // already compact and trace events hold the duration of each call
+        bool text_format =
+            output_format == ApiDumpFormat::Text || output_format == ApiDumpFormat::Html || output_format == ApiDumpFormat::Json;
+        if (readBoolOption("lunarg_api_dump.delta_output", false) && text_format) {
+            delta_filter = new ApiDumpDeltaFilter();
+        }
+
+        if (readBoolOption("lunarg_api_dump.command_buffer_summary", false) && text_format) {
+            cmd_buffer_summaries = new ApiDumpCmdBufferSummaries();
+        }
 
-        // Generate HTML heading if specified
+        if (readBoolOption("lunarg_api_dump.blob_store", false)) {
+            blob_store = new ApiDumpBlobStore(output_dir, std::max(readIntOption("lunarg_api_dump.blob_min_bytes", 256), 0));
+        }
+
+        object_filter.parseObjectList(getLayerOption("lunarg_api_dump.objects"));
+
+        size_t function_count = 0;
+        while (api_dump_function_names[function_count] != NULL) function_count++;
+        dumped_functions.reset(new std::atomic<bool>[function_count]);
+        setFunctionFilter(getLayerOption("lunarg_api_dump.functions"));
+
+        int sample_interval = readIntOption("lunarg_api_dump.sample_interval", 1);
+        double sample_rate = readFloatOption("lunarg_api_dump.sample_rate", 1.0);
+        FunctionFilter sample_filter;
+        sample_filter.parseFunctionList(getLayerOption("lunarg_api_dump.sample_functions"));
+        if ((sample_interval > 1 || sample_rate < 1.0) && text_format && !sample_filter.empty()) {
+            std::vector<bool> sampled_functions;
+            for (size_t i = 0; api_dump_function_names[i] != NULL; ++i)
+                sampled_functions.push_back(sample_filter.isFunctionDumped(api_dump_function_names[i]));
+            sampler = new ApiDumpSampler(sampled_functions, (uint64_t)std::max(sample_interval, 1), std::max(sample_rate, 0.0),
+                                         (uint64_t)readIntOption("lunarg_api_dump.sample_seed", 0));
+        }
+
+        if (thread_output != NULL) thread_output->beginRecord();
+        writeHeader(stream());
+        if (segmented_output != NULL) segmented_output->beginRecord(ApiDumpRecordType::Frame);
+
+        if (advanceOutputFrame(0)) {
+            setupInterFrameOutputFormatting(0);
+        }
+        if (segmented_output != NULL) segmented_output->endRecord(ApiDumpRecordType::Frame, 0);
+        if (thread_output != NULL) thread_output->endRecord(ApiDumpRecordType::Frame, API_DUMP_NO_THREAD);
+
+        // Everything written after this point goes into the flight recorder or through the writer thread
+        if (flight_recorder_options.enabled) {
+            api_dump_binary_intern_names = false;
+            flight_recorder = new ApiDumpFlightRecorder(stream(), flight_recorder_options);
+        } else if (async_output) {
+            async_writer = new ApiDumpAsyncWriter(stream(), separatesJsonCalls(), flush_options, segmented_output);
+        }
+    }
+
+    ~ApiDumpSettings() {
+        stopAsyncOutput();
+        if (blob_store != NULL) {
+            delete blob_store;
+            blob_store = NULL;
+        }
+        if (delta_filter != NULL) {
+            delete delta_filter;
+            delta_filter = NULL;
+        }
+        if (cmd_buffer_summaries != NULL) {
+            delete cmd_buffer_summaries;
+            cmd_buffer_summaries = NULL;
+        }
+        if (sampler != NULL) {
+            delete sampler;
+            sampler = NULL;
+        }
+        if (flight_recorder != NULL) {
+            delete flight_recorder;
+            flight_recorder = NULL;
+        }
+        if (capture_control != NULL) {
+            delete capture_control;
+            capture_control = NULL;
+        }
+        if (segmented_output != NULL) {
+            segmented_output->close();
+            delete segmented_output;
+            segmented_output = NULL;
+        } else if (thread_output != NULL) {
+            thread_output->beginRecord();
+            writeFooter(stream());
+            thread_output->endRecord(ApiDumpRecordType::Frame, API_DUMP_NO_THREAD);
+            delete thread_output;
+            thread_output = NULL;
+        } else {
+            writeFooter(stream());
+        }
+        if (compressed_output != NULL) {
+            // Writes the end of the gzip file
+            compressed_stream.rdbuf(NULL);
+            delete compressed_output;
+            compressed_output = NULL;
+        } else if (!use_cout) {
+            output_stream.close();
+        }
+    }
+
+    // The output that starts a document of the output format, and that of every segment.
+    void writeHeader(std::ostream &output) const {
         if (output_format == ApiDumpFormat::Html) {
             // clang-format off
             // Insert html heading
-            stream() <<
+            output <<
                 "<!doctype html>"
                 "<html>"
                     "<head>"
@@ -430,128 +2659,347 @@ class ApiDumpSettings {
                         "</div>"
                         "<div id='wrapper'>";
             // clang-format on
-        } else if (output_format == ApiDumpFormat::Json) {
-            stream() << "[\n";
-        }
-
-        if (isFrameInRange(0)) {
-            setupInterFrameOutputFormatting(0);
+        } else if (output_format == ApiDumpFormat::Json && !json_lines) {
+            output << "[\n";
+        } else if (output_format == ApiDumpFormat::Binary) {
+            uint64_t header_flags = 0;
+            if (show_address) header_flags |= API_DUMP_BINARY_SHOW_ADDRESS;
+            if (show_thread_and_frame) header_flags |= API_DUMP_BINARY_SHOW_THREAD_AND_FRAME;
+            if (show_timestamp) header_flags |= API_DUMP_BINARY_SHOW_TIMESTAMP;
+            if (show_params) header_flags |= API_DUMP_BINARY_SHOW_PARAMS;
+            output.write(API_DUMP_BINARY_MAGIC, sizeof(API_DUMP_BINARY_MAGIC));
+            dump_binary_varint(API_DUMP_BINARY_VERSION, output);
+            dump_binary_varint(header_flags, output);
+        } else if (output_format == ApiDumpFormat::Trace) {
+            dump_write_literal(output, API_DUMP_TRACE_HEADER);
         }
     }
 
-    ~ApiDumpSettings() {
+    void writeFooter(std::ostream &output) const {
         if (output_format == ApiDumpFormat::Html) {
             // Close off html
-            stream() << "</div></body></html>";
-        } else if (output_format == ApiDumpFormat::Json) {
+            output << "</div></body></html>";
+        } else if (output_format == ApiDumpFormat::Json && !json_lines) {
             // Close off json
-            stream() << "\n]" << std::endl;
+            output << "\n]" << std::endl;
+        } else if (output_format == ApiDumpFormat::Trace) {
+            dump_write_literal(output, API_DUMP_TRACE_FOOTER);
         }
-        if (!use_cout) output_stream.close();
     }
 
     void setupInterFrameOutputFormatting(uint64_t frame_count) const /*name change? */
     {
-        static bool hasPrintedAFrame = false;
+        if (frame_count > 0) endFrameOutput(frame_count - 1);
+        beginFrameOutput(frame_count);
+    }
+
+    // The output that closes a frame, if the frame was in range. In delta output mode it counts the
+    // calls of the frame that were held back, and when sampling, the calls sampled of each function.
+    void endFrameOutput(uint64_t frame) const {
+        uint64_t identical_calls = delta_filter != NULL ? delta_filter->endFrame() : 0;
+        std::vector<ApiDumpSampler::Counts> sampled_calls;
+        if (sampler != NULL) sampled_calls = sampler->endFrame();
+        if (!isFrameDumped(frame)) return;
         switch (format()) {
+            case (ApiDumpFormat::Text):
+                if (delta_filter != NULL) {
+                    stream() << "Frame ";
+                    dump_write_uint(stream(), frame) << ": ";
+                    dump_write_uint(stream(), identical_calls) << " calls identical to previous frame\n\n";
+                }
+                for (const ApiDumpSampler::Counts &counts : sampled_calls) {
+                    stream() << "Frame ";
+                    dump_write_uint(stream(), frame) << ": " << api_dump_function_names[counts.function] << " sampled ";
+                    dump_write_uint(stream(), counts.sampled) << " of ";
+                    dump_write_uint(stream(), counts.total) << " calls\n";
+                }
+                if (!sampled_calls.empty()) stream() << "\n";
+                break;
             case (ApiDumpFormat::Html):
-                if (frame_count > 0) {
-                    if (condFrameOutput.isFrameInRange(frame_count - 1)) stream() << "</details>";
+                if (delta_filter != NULL) {
+                    stream() << "<div class='var'>";
+                    dump_write_uint(stream(), identical_calls) << " calls identical to previous frame</div>";
                 }
-                if (condFrameOutput.isFrameInRange(frame_count)) {
-                    stream() << "<details class='frm'><summary>Frame ";
-                    if (show_thread_and_frame) {
-                        stream() << frame_count;
-                    }
-                    stream() << "</summary>";
+                for (const ApiDumpSampler::Counts &counts : sampled_calls) {
+                    stream() << "<div class='var'>" << api_dump_function_names[counts.function] << " sampled ";
+                    dump_write_uint(stream(), counts.sampled) << " of ";
+                    dump_write_uint(stream(), counts.total) << " calls</div>";
                 }
+                stream() << "</details>";
                 break;
-
-            case (ApiDumpFormat::Json):
-
-                if (frame_count > 0) {
-                    if (condFrameOutput.isFrameInRange(frame_count - 1)) stream() << "\n" << indentation(1) << "]\n}";
+            case (ApiDumpFormat::Json): {
+                // Calls written one per line are followed by a line for the frame, if there is anything to say about it
+                const char *quote = json_lines ? "" : "\"";
+                if (json_lines) {
+                    if (delta_filter == NULL && sampler == NULL) break;
+                    dump_write_uint(stream() << "{\"frame\" : ", frame);
+                } else {
+                    stream() << "\n" << indentation(1) << "]";
                 }
-                if (condFrameOutput.isFrameInRange(frame_count)) {
-                    if (!hasPrintedAFrame) {
-                        hasPrintedAFrame = true;
-                    } else {
-                        stream() << ",\n";
-                    }
-                    stream() << "{\n";
-                    if (show_thread_and_frame) {
-                        stream() << indentation(1) << "\"frameNumber\" : \"" << frame_count << "\",\n";
+                // Counts are plain numbers on lines meant for machine ingestion
+                if (delta_filter != NULL) {
+                    stream() << "," << json_line_break << indentation(1) << "\"identicalCalls\" : " << quote;
+                    dump_write_uint(stream(), identical_calls) << quote;
+                }
+                if (sampler != NULL) {
+                    stream() << "," << json_line_break << indentation(1) << "\"sampledCalls\" :" << json_line_break;
+                    stream() << indentation(1) << "[";
+                    for (size_t i = 0; i < sampled_calls.size(); ++i) {
+                        stream() << (i > 0 ? "," : "") << json_line_break << indentation(2) << "{" << json_line_break;
+                        const char *name = api_dump_function_names[sampled_calls[i].function];
+                        stream() << indentation(3) << "\"name\" : \"" << name << "\"," << json_line_break;
+                        stream() << indentation(3) << "\"sampled\" : " << quote;
+                        dump_write_uint(stream(), sampled_calls[i].sampled) << quote << "," << json_line_break;
+                        stream() << indentation(3) << "\"total\" : " << quote;
+                        dump_write_uint(stream(), sampled_calls[i].total) << quote << json_line_break;
+                        stream() << indentation(2) << "}";
                     }
-                    stream() << indentation(1) << "\"apiCalls\" :\n";
-                    stream() << indentation(1) << "[\n";
+                    stream() << json_line_break << indentation(1) << "]";
                 }
+                stream() << (json_lines ? "}\n" : "\n}");
                 break;
-            case (ApiDumpFormat::Text):
-                break;
+            }
             default:
                 break;
         }
     }
 
-    void closeFrameOutput() const {
+    // The output that opens a frame, if the frame is in range. A frame that starts a new segment
+    // is the first of its document.
+    void beginFrameOutput(uint64_t frame, bool starts_segment = false) const {
+        if (starts_segment) json_frame_written = false;
+        if (!isFrameDumped(frame)) return;
         switch (format()) {
             case (ApiDumpFormat::Html):
-                stream() << "</details>";
+                // Segments are opened from the frame page, at the frame that was clicked
+                if (segmented_output != NULL) {
+                    stream() << "<details class='frm' open id='frame-";
+                    dump_write_uint(stream(), frame) << "'><summary>Frame ";
+                } else {
+                    stream() << "<details class='frm'><summary>Frame ";
+                }
+                if (show_thread_and_frame) {
+                    dump_write_uint(stream(), frame);
+                }
+                stream() << "</summary>";
                 break;
             case (ApiDumpFormat::Json):
-                stream() << "\n" << indentation(1) << "]\n}";
+                // Calls written one per line carry their frame number themselves
+                if (json_lines) break;
+                if (json_frame_written) stream() << ",\n";
+                json_frame_written = true;
+                stream() << "{\n";
+                if (show_thread_and_frame) {
+                    stream() << indentation(1) << "\"frameNumber\" : \"";
+                    dump_write_uint(stream(), frame) << "\",\n";
+                }
+                stream() << indentation(1) << "\"apiCalls\" :\n";
+                stream() << indentation(1) << "[\n";
                 break;
-            case (ApiDumpFormat::Text):
+            case (ApiDumpFormat::Binary):
+                dump_binary_tag(ApiDumpBinaryTag::Frame, stream());
+                dump_binary_varint(frame, stream());
                 break;
             default:
                 break;
         }
     }
 
-    inline ApiDumpFormat format() const { return output_format; }
+    inline ApiDumpFormat format() const { return output_format; }
+
+    // Writes the indentation, name and type that start the line of a value in the text format.
+    inline std::ostream &formatNameType(std::ostream &stream, int indents, const char *name, const char *type) const {
+        return (this->*name_type_formatter)(stream, indents, name, type);
+    }
+
+    // Same output as stream << indentation(indents), without the strlen
+    inline void writeIndentation(std::ostream &stream, int indents) const {
+        if (use_spaces)
+            writeSpaces(stream, indents * indent_size);
+        else
+            writeTabs(stream, indents);
+    }
+
+    inline const char *indentation(int indents) const {
+        if (use_spaces)
+            return spaces(indents * indent_size);
+        else
+            return tabs(indents);
+    }
+
+    // True if the output is flushed after every API call.
+    inline bool shouldFlush() const { return flush_options.enabled && flush_options.policy == ApiDumpFlushPolicy::Call; }
+
+    inline bool shouldFlushOnFrame() const { return flush_options.enabled && flush_options.policy == ApiDumpFlushPolicy::Frame; }
+
+    // True if output may still be buffered after an API call returns, and so has to be flushed
+    // when the process exits or crashes.
+    inline bool needsFinalFlush() const { return flush_options.enabled && flush_options.policy != ApiDumpFlushPolicy::Call; }
+
+    inline const ApiDumpFlushOptions &flushOptions() const { return flush_options; }
+
+    // Flushes the file or stdout, and not the calling thread's buffer when writing asynchronously.
+    inline void flushOutput() const {
+        if (thread_output != NULL) {
+            thread_output->flush();
+            return;
+        }
+        std::ostream &output = segmented_output != NULL    ? segmented_output->stream()
+                               : compressed_output != NULL ? *(std::ostream *)&compressed_stream
+                               : use_cout                  ? std::cout
+                                                           : *(std::ofstream *)&output_stream;
+        output.flush();
+    }
+
+    // Also writes out the records still queued for the writer thread or held by the flight
+    // recorder, for when a signal came in. The writer thread is only stopped if the process is
+    // about to go down, an application that handles the signal keeps dumping its calls.
+    // Synchronous output must be flushed under outputMutex.
+    void flushAllOutput(bool process_ends) const {
+        if (flight_recorder != NULL) flight_recorder->writeNow("a signal");
+        if (async_writer != NULL) {
+            if (process_ends)
+                async_writer->stop();
+            else
+                async_writer->drain();
+        }
+        if (thread_output != NULL) {
+            thread_output->flush();
+            return;
+        }
+        flushOutput();
+    }
+
+    inline bool showAddress() const { return show_address; }
+
+    inline bool showParams() const { return show_params; }
+
+    inline bool showShader() const { return show_shader; }
+
+    inline bool showType() const { return show_type; }
+
+    inline bool showTimestamp() const { return show_timestamp; }
+
+    inline bool showThreadAndFrame() const { return show_thread_and_frame; }
+
+    inline std::ostream &stream() const {
+        if (delta_filter != NULL) {
+            std::ostream *call_stream = delta_filter->recordingStream();
+            if (call_stream != NULL) return *call_stream;
+        }
+        if (flight_recorder != NULL) return flight_recorder->stream();
+        if (async_writer != NULL) return async_writer->stream();
+        if (segmented_output != NULL) return segmented_output->stream();
+        if (thread_output != NULL) return thread_output->stream();
+        if (compressed_output != NULL) return *(std::ostream *)&compressed_stream;
+        return use_cout ? std::cout : *(std::ofstream *)&output_stream;
+    }
+
+    inline bool useCout() const { return use_cout; }
+
+    inline bool asyncOutput() const { return async_writer != NULL; }
+
+    inline bool perThreadOutput() const { return thread_output != NULL; }
+
+    inline ApiDumpThreadOutput &threadOutput() const { return *thread_output; }
 
-    std::ostream &formatNameType(std::ostream &stream, int indents, const char *name, const char *type) const {
-        stream << indentation(indents) << name << ": ";
+    // True if each thread formats its records into a buffer of its own, and records are written out
+    // in the order they are completed rather than the order they are started. Separators between
+    // json calls are then only known once a record is written.
+    inline bool writesRecordsOnCompletion() const { return async_writer != NULL || thread_output != NULL; }
 
-        if (use_spaces)
-            stream << spaces(name_size - (int)strlen(name) - 2);
-        else
-            stream << tabs((name_size - (int)strlen(name) - 3 + indent_size) / indent_size);
+    // True if json calls are written one per line, see json_lines.
+    inline bool jsonLines() const { return json_lines; }
 
-        if (show_type && use_spaces)
-            stream << type << spaces(type_size - (int)strlen(type));
-        else if (show_type && !use_spaces)
-            stream << type << tabs((type_size - (int)strlen(type) - 1 + indent_size) / indent_size);
+    // Ends a line of json output, nothing when calls are written one per line. A manipulator
+    // rather than a string, so that the line break is written without the cost of an insertion.
+    inline ApiDumpStreamManipulator jsonLineBreak() const { return json_line_break; }
 
-        return stream << " = ";
-    }
+    // True if json calls are elements of an array, which need commas between them.
+    inline bool separatesJsonCalls() const { return output_format == ApiDumpFormat::Json && !json_lines; }
 
-    inline const char *indentation(int indents) const {
-        if (use_spaces)
-            return spaces(indents * indent_size);
-        else
-            return tabs(indents);
-    }
+    // True if the separators between json calls are added as each call is written out, rather
+    // than when it is formatted.
+    inline bool separatesJsonCallsOnWrite() const { return writesRecordsOnCompletion() || delta_filter != NULL; }
 
-    inline bool shouldFlush() const { return should_flush; }
+    inline ApiDumpAsyncWriter &asyncWriter() const { return *async_writer; }
 
-    inline bool showAddress() const { return show_address; }
+    inline bool flightRecorderEnabled() const { return flight_recorder != NULL; }
 
-    inline bool showParams() const { return show_params; }
+    inline ApiDumpFlightRecorder &flightRecorder() const { return *flight_recorder; }
 
-    inline bool showShader() const { return show_shader; }
+    inline bool segmented() const { return segmented_output != NULL; }
 
-    inline bool showType() const { return show_type; }
+    inline ApiDumpSegmentedOutput &segments() const { return *segmented_output; }
 
-    inline bool showTimestamp() const { return show_timestamp; }
+    inline bool deltaOutput() const { return delta_filter != NULL; }
 
-    inline bool showThreadAndFrame() const { return show_thread_and_frame; }
+    inline ApiDumpDeltaFilter &deltaFilter() const { return *delta_filter; }
 
-    inline std::ostream &stream() const { return use_cout ? std::cout : *(std::ofstream *)&output_stream; }
+    inline bool summarizesCmdBuffers() const { return cmd_buffer_summaries != NULL; }
+
+    inline ApiDumpCmdBufferSummaries &cmdBufferSummaries() const { return *cmd_buffer_summaries; }
+
+    inline bool samplesCalls() const { return sampler != NULL; }
+
+    inline ApiDumpSampler &callSampler() const { return *sampler; }
+
+    // Waits for the writer thread to finish, any output after this is written directly. Output
+    // written per thread and the delta filter no longer use the exiting thread's locals.
+    void stopAsyncOutput() {
+        if (async_writer != NULL) {
+            delete async_writer;
+            async_writer = NULL;
+        }
+        if (thread_output != NULL) thread_output->stop();
+        if (delta_filter != NULL) delta_filter->stop();
+    }
 
     inline std::string directory() const { return output_dir; }
 
-    inline bool isFrameInRange(uint64_t frame) const { return condFrameOutput.isFrameInRange(frame); }
+    inline bool storesBlobs() const { return blob_store != NULL; }
+
+    inline ApiDumpBlobStore &blobStore() const { return *blob_store; }
+
+    // Called once per frame, in order, to decide whether the frame is dumped. Frames between two dumped frames only
+    // take a comparison, unless the commands of a control file have to be read.
+    inline bool advanceOutputFrame(uint64_t frame) const {
+        bool dumped = !use_conditional_output || output_cursor.advance(output_schedule, frame);
+        if (capture_control != NULL) {
+            std::vector<CaptureCommand> commands;
+            dumped = capture_control->nextFrame(dumped, commands);
+            for (const CaptureCommand &command : commands) {
+                if (command.type == CaptureCommandType::SetFilter) setFunctionFilter(command.argument);
+            }
+        }
+        frames_dumped[frame & 1] = dumped;
+        return dumped;
+    }
+
+    // Whether the frame being closed or the one being opened is dumped
+    inline bool isFrameDumped(uint64_t frame) const { return frames_dumped[frame & 1]; }
+
+    // Decides which functions are dumped, so that each call only has to look up a flag. The control file can replace
+    // the list while other threads are dumping calls.
+    void setFunctionFilter(const std::string &list) const {
+        FunctionFilter function_filter;
+        function_filter.parseFunctionList(list);
+        for (size_t i = 0; api_dump_function_names[i] != NULL; ++i) {
+            // Commands are only counted when they are summarized at submit time
+            bool summarized = cmd_buffer_summaries != NULL && strncmp(api_dump_function_names[i], "vkCmd", 5) == 0;
+            bool dumped = !summarized && function_filter.isFunctionDumped(api_dump_function_names[i]);
+            dumped_functions[i].store(dumped, std::memory_order_relaxed);
+        }
+    }
+
+    // Takes a generated function id
+    inline bool isFunctionDumped(uint32_t function) const { return dumped_functions[function].load(std::memory_order_relaxed); }
+
+    inline bool filtersObjects() const { return !object_filter.empty(); }
+
+    inline bool isObjectDumped(uint64_t handle, const char *name) const { return object_filter.isObjectDumped(handle, name); }
+
+    inline uint32_t statsFrames() const { return stats_frames; }
 
    private:
     // Utility member to enable easier comparison by forcing a string to all lower-case
@@ -630,6 +3078,25 @@ class ApiDumpSettings {
         }
     }
 
+    inline static double readFloatOption(const char *option, double default_value) {
+        const char *string_option = getLayerOption(option);
+        double value;
+        if (sscanf(string_option, "%lf", &value) != 1) {
+            return default_value;
+        } else {
+            return value;
+        }
+    }
+
+    // Compression only applies to a single output file
+    static void warnCompressionIgnored(const char *reason) {
+#ifdef ANDROID
+        __android_log_print(ANDROID_LOG_WARN, "api_dump", "Compression requested but ignored, %s", reason);
+#else
+        fprintf(stderr, "api_dump: compression requested but ignored, %s\n", reason);
+#endif
+    }
+
     inline static ApiDumpFormat readFormatOption(const char *option, ApiDumpFormat default_value) {
         const char *string_option = getLayerOption(option);
         std::string lowered_option = ToLowerString(std::string(string_option));
@@ -637,8 +3104,63 @@ class ApiDumpSettings {
             return ApiDumpFormat::Text;
         else if (lowered_option == "html")
             return ApiDumpFormat::Html;
-        else if (lowered_option == "json")
+        else if (lowered_option == "json" || lowered_option == "ndjson")
             return ApiDumpFormat::Json;
+        else if (lowered_option == "binary")
+            return ApiDumpFormat::Binary;
+        else if (lowered_option == "stats")
+            return ApiDumpFormat::Stats;
+        else if (lowered_option == "trace")
+            return ApiDumpFormat::Trace;
+        else
+            return default_value;
+    }
+
+    // The format recorded next to segmented and per-thread output, for the scripts that read them.
+    inline const char *documentFormatName() const { return json_lines ? "ndjson" : formatName(output_format); }
+
+    inline static const char *formatName(ApiDumpFormat format) {
+        switch (format) {
+            case ApiDumpFormat::Html:
+                return "html";
+            case ApiDumpFormat::Json:
+                return "json";
+            case ApiDumpFormat::Binary:
+                return "binary";
+            case ApiDumpFormat::Stats:
+                return "stats";
+            case ApiDumpFormat::Trace:
+                return "trace";
+            default:
+                return "text";
+        }
+    }
+
+    inline static ApiDumpFlushPolicy readFlushPolicyOption(const char *option, ApiDumpFlushPolicy default_value) {
+        const char *string_option = getLayerOption(option);
+        std::string lowered_option = ToLowerString(std::string(string_option));
+        if (lowered_option == "call")
+            return ApiDumpFlushPolicy::Call;
+        else if (lowered_option == "interval")
+            return ApiDumpFlushPolicy::Interval;
+        else if (lowered_option == "bytes")
+            return ApiDumpFlushPolicy::Bytes;
+        else if (lowered_option == "frame")
+            return ApiDumpFlushPolicy::Frame;
+        else
+            return default_value;
+    }
+
+    inline static ApiDumpFlightRecorderResultTrigger readResultTriggerOption(const char *option,
+                                                                             ApiDumpFlightRecorderResultTrigger default_value) {
+        const char *string_option = getLayerOption(option);
+        std::string lowered_option = ToLowerString(std::string(string_option));
+        if (lowered_option == "none")
+            return ApiDumpFlightRecorderResultTrigger::None;
+        else if (lowered_option == "device_lost")
+            return ApiDumpFlightRecorderResultTrigger::DeviceLost;
+        else if (lowered_option == "error")
+            return ApiDumpFlightRecorderResultTrigger::Error;
         else
             return default_value;
     }
@@ -647,13 +3169,91 @@ class ApiDumpSettings {
 
     inline static const char *tabs(int count) { return TABS + (MAX_TABS - std::max(count, 0)); }
 
+    typedef std::ostream &(ApiDumpSettings::*NameTypeFormatter)(std::ostream &, int, const char *, const char *) const;
+
+    // The longest name and type formatNameTypeAs puts together on the stack, beyond which it
+    // writes each part to the stream on its own
+    static const size_t MAX_NAME_TYPE_LENGTH = 256;
+
+    // formatNameType for one combination of the use_spaces and show_type settings. The line is put
+    // together on the stack and written at once, as each write to the stream sets up a sentry.
+    template <bool UseSpaces, bool ShowType>
+    std::ostream &formatNameTypeAs(std::ostream &stream, int indents, const char *name, const char *type) const {
+        const int name_length = (int)strlen(name);
+        const int type_length = ShowType ? (int)strlen(type) : 0;
+        if (name_length + type_length > (int)MAX_NAME_TYPE_LENGTH) return formatNameTypeUnbuffered(stream, indents, name, type);
+
+        char line[MAX_NAME_TYPE_LENGTH + 3 * MAX_SPACES + 5];
+        char *end = line;
+        end = appendPadding<UseSpaces>(end, UseSpaces ? indents * indent_size : indents);
+        memcpy(end, name, name_length);
+        end += name_length;
+        memcpy(end, ": ", 2);
+        end += 2;
+        end = appendPadding<UseSpaces>(
+            end, UseSpaces ? name_size - name_length - 2 : (name_size - name_length - 3 + indent_size) / indent_size);
+        if (ShowType) {
+            memcpy(end, type, type_length);
+            end += type_length;
+            end = appendPadding<UseSpaces>(end, UseSpaces ? type_size - type_length
+                                                          : (type_size - type_length - 1 + indent_size) / indent_size);
+        }
+        memcpy(end, " = ", 3);
+        end += 3;
+        return stream.write(line, end - line);
+    }
+
+    // Same output as writeSpaces or writeTabs, into a buffer.
+    template <bool UseSpaces>
+    static inline char *appendPadding(char *buffer, int count) {
+        count = std::min(std::max(count, 0), UseSpaces ? MAX_SPACES : MAX_TABS);
+        memset(buffer, UseSpaces ? ' ' : '\t', count);
+        return buffer + count;
+    }
+
+    std::ostream &formatNameTypeUnbuffered(std::ostream &stream, int indents, const char *name, const char *type) const {
+        const int name_length = (int)strlen(name);
+        writeIndentation(stream, indents);
+        stream.write(name, name_length);
+        stream.write(": ", 2);
+
+        if (use_spaces)
+            writeSpaces(stream, name_size - name_length - 2);
+        else
+            writeTabs(stream, (name_size - name_length - 3 + indent_size) / indent_size);
+
+        if (show_type) {
+            const int type_length = (int)strlen(type);
+            stream.write(type, type_length);
+            if (use_spaces)
+                writeSpaces(stream, type_size - type_length);
+            else
+                writeTabs(stream, (type_size - type_length - 1 + indent_size) / indent_size);
+        }
+
+        return stream.write(" = ", 3);
+    }
+
+    inline static void writeSpaces(std::ostream &stream, int count) {
+        count = std::min(std::max(count, 0), MAX_SPACES);
+        stream.write(SPACES + (MAX_SPACES - count), count);
+    }
+
+    inline static void writeTabs(std::ostream &stream, int count) {
+        count = std::min(std::max(count, 0), MAX_TABS);
+        stream.write(TABS + (MAX_TABS - count), count);
+    }
+
     bool use_cout;
     std::string output_dir = "";
+    std::vector<char> output_buffer;
     std::ofstream output_stream;
+    std::streambuf *compressed_output = NULL;
+    std::ostream compressed_stream{NULL};
     ApiDumpFormat output_format;
     bool show_params;
     bool show_address;
-    bool should_flush;
+    ApiDumpFlushOptions flush_options;
     bool show_timestamp;
 
     bool show_type;
@@ -661,11 +3261,33 @@ class ApiDumpSettings {
     int name_size;
     int type_size;
     bool use_spaces;
+    NameTypeFormatter name_type_formatter;
     bool show_shader;
     bool show_thread_and_frame;
+    // Each call is a json object of its own line, rather than an element of its frame's array
+    bool json_lines = false;
+    ApiDumpStreamManipulator json_line_break = dump_line_break;
 
     bool use_conditional_output = false;
-    ConditionalFrameOutput condFrameOutput;
+    FrameSchedule output_schedule;
+    mutable FrameScheduleCursor output_cursor;
+    CaptureControl *capture_control = NULL;
+    mutable bool frames_dumped[2] = {true, true};
+    // Whether a frame was written to the current json document, which the next frame is separated from
+    mutable bool json_frame_written = false;
+
+    std::unique_ptr<std::atomic<bool>[]> dumped_functions;
+    ObjectFilter object_filter;
+    uint32_t stats_frames;
+
+    ApiDumpAsyncWriter *async_writer = NULL;
+    ApiDumpFlightRecorder *flight_recorder = NULL;
+    ApiDumpBlobStore *blob_store = NULL;
+    ApiDumpSegmentedOutput *segmented_output = NULL;
+    ApiDumpThreadOutput *thread_output = NULL;
+    ApiDumpDeltaFilter *delta_filter = NULL;
+    ApiDumpCmdBufferSummaries *cmd_buffer_summaries = NULL;
+    ApiDumpSampler *sampler = NULL;
 
     static const char *const SPACES;
     static const int MAX_SPACES = 144;
@@ -679,14 +3301,44 @@ const char *const ApiDumpSettings::SPACES =
     "                  ";
 const char *const ApiDumpSettings::TABS = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
 
+#if !defined(_WIN32)
+// Signals that end the process, after which any buffered output is written out.
+static const int API_DUMP_FLUSH_SIGNALS[] = {
+    SIGABRT, SIGFPE, SIGILL, SIGINT, SIGSEGV, SIGTERM,
+#if defined(SIGBUS)
+    SIGBUS,
+#endif
+};
+static const size_t API_DUMP_FLUSH_SIGNAL_COUNT = sizeof(API_DUMP_FLUSH_SIGNALS) / sizeof(API_DUMP_FLUSH_SIGNALS[0]);
+
+// How long a signal handler waits for the output to be written out before passing the signal on,
+// and how long of that the output may wait for a call in progress to finish.
+static const int API_DUMP_SIGNAL_FLUSH_TIMEOUT_MS = 5000;
+static const int API_DUMP_SIGNAL_OUTPUT_LOCK_TIMEOUT_MS = 1000;
+#endif
+
 class ApiDumpInstance {
    public:
-    inline ApiDumpInstance() : dump_settings(NULL), frame_count(0), thread_count(0) {
-        program_start = std::chrono::system_clock::now();
+    inline ApiDumpInstance() : dump_settings(NULL), frame_count(0) {
+        program_start = std::chrono::steady_clock::now();
     }
 
     inline ~ApiDumpInstance() {
-        if (!first_func_call_on_frame) settings().closeFrameOutput();
+        if (flush_timer != NULL) delete flush_timer;
+#if !defined(_WIN32)
+        restoreSignalHandlers();
+        if (signal_flusher != NULL) delete signal_flusher;
+#endif
+        if (dump_settings != NULL) {
+            dump_settings->stopAsyncOutput();
+            // The last frame is closed even if no calls were made in it, or it would be missing from the document
+            beginRecord(ApiDumpRecordType::FrameEnd);
+            dump_settings->endFrameOutput(frame_count);
+            endRecord(ApiDumpRecordType::FrameEnd);
+        }
+        // The calls made since the last present
+        if (dump_settings != NULL && dump_settings->format() == ApiDumpFormat::Stats)
+            call_stats.writeSummary(frame_count, dump_settings->stream());
 
         if (dump_settings != NULL) delete dump_settings;
     }
@@ -698,141 +3350,455 @@ class ApiDumpInstance {
     }
 
     inline void nextFrame() {
+        // Calls hold the output mutex while they read the frame count, so take it first
+        std::lock_guard<std::recursive_mutex> output_lg(output_mutex);
         std::lock_guard<std::recursive_mutex> lg(frame_mutex);
         ++frame_count;
 
-        should_dump_output = settings().isFrameInRange(frame_count);
-        settings().setupInterFrameOutputFormatting(frame_count);
+        should_dump_output = settings().advanceOutputFrame(frame_count);
+        if (settings().format() == ApiDumpFormat::Stats) {
+            call_stats.endFrame(frame_count - 1, settings().statsFrames(), settings().stream());
+            if (settings().flushOptions().enabled) settings().flushOutput();
+            return;
+        }
+        bool starts_segment = false;
+        if (settings().segmented()) {
+            // The end of the frame goes into its own record, so that the index points at the start of the next frame
+            starts_segment = settings().segments().endFrame();
+            ApiDumpRecordType type = starts_segment ? ApiDumpRecordType::Segment : ApiDumpRecordType::FrameEnd;
+            beginRecord(type);
+            settings().endFrameOutput(frame_count - 1);
+            endRecord(type);
+            beginRecord(ApiDumpRecordType::Frame);
+            settings().beginFrameOutput(frame_count, starts_segment);
+        } else {
+            beginRecord(ApiDumpRecordType::Frame);
+            settings().setupInterFrameOutputFormatting(frame_count);
+        }
+        if (settings().format() == ApiDumpFormat::Trace && should_dump_output)
+            dump_trace_frame(settings().stream(), frame_count, time_since_start(std::chrono::steady_clock::now()));
+        // The writer thread or the thread files apply the flush policy themselves
+        if (settings().shouldFlushOnFrame() && !settings().writesRecordsOnCompletion()) settings().flushOutput();
+        endRecord(ApiDumpRecordType::Frame);
         first_func_call_on_frame = true;
     }
 
-    inline bool shouldDumpOutput() {
-        if (!conditional_initialized) {
-            should_dump_output = settings().isFrameInRange(frame_count);
-            conditional_initialized = true;
+    inline bool shouldDumpOutput() { return should_dump_output.load(std::memory_order_relaxed); }
+
+    inline bool firstFunctionCallOnFrame() {
+        return first_func_call_on_frame.load(std::memory_order_relaxed) && first_func_call_on_frame.exchange(false);
+    }
+
+    inline std::recursive_mutex *outputMutex() { return &output_mutex; }
+
+    // Brackets the output of one record. Synchronous output holds outputMutex until the record is
+    // complete, while asynchronous output and the flight recorder collect it in a per-thread buffer.
+    // Formats that time the call into the driver must not hold outputMutex across it, see
+    // writeRecord. In delta output mode, calls are formatted on their own and only written out if
+    // they differ from the previous frame.
+    inline void beginRecord(ApiDumpRecordType type = ApiDumpRecordType::Call) {
+        if (type == ApiDumpRecordType::Call && settings().deltaOutput()) {
+            settings().deltaFilter().beginCall();
+        } else {
+            beginOutputRecord(type);
         }
-        return should_dump_output;
     }
 
-    inline bool firstFunctionCallOnFrame() {
-        if (first_func_call_on_frame) {
-            first_func_call_on_frame = false;
-            return true;
+    inline void endRecord(ApiDumpRecordType type = ApiDumpRecordType::Call) {
+        if (type == ApiDumpRecordType::Call && settings().deltaOutput()) {
+            if (!settings().deltaFilter().endCall(threadID())) writeDeltaRecord(settings().deltaFilter().text());
+        } else {
+            endOutputRecord(type);
         }
-        return false;
     }
 
-    inline std::recursive_mutex *outputMutex() { return &output_mutex; }
+    // Called with every call on a command buffer, see ApiDumpCmdBufferSummaries.
+    inline void trackCmdBufferCall(VkCommandBuffer cmd_buffer, uint32_t function, uint64_t pipeline) {
+        if (settings().summarizesCmdBuffers()) settings().cmdBufferSummaries().addCall(cmd_buffer, function, pipeline);
+    }
 
-    inline const ApiDumpSettings &settings() {
-        if (dump_settings == NULL) dump_settings = new ApiDumpSettings();
+    // Called between the head and the body of every call that is dumped, see ApiDumpDeltaFilter.
+    inline void beginRecordBody(uint32_t function, uint64_t command_buffer) {
+        if (settings().deltaOutput()) settings().deltaFilter().beginBody(function, command_buffer);
+    }
 
-        return *dump_settings;
+    inline void beginOutputRecord(ApiDumpRecordType type) {
+        if (settings().flightRecorderEnabled()) {
+            settings().flightRecorder().beginRecord();
+        } else if (settings().asyncOutput()) {
+            settings().asyncWriter().beginRecord();
+        } else if (settings().perThreadOutput()) {
+            settings().threadOutput().beginRecord();
+        } else if (!timesCalls() || type != ApiDumpRecordType::Call) {
+            output_mutex.lock();
+            if (settings().segmented()) settings().segments().beginRecord(type);
+        }
     }
 
-    uint64_t threadID() {
-        if (thread_id != UINT64_MAX) {
-            return thread_id;
+    inline void endOutputRecord(ApiDumpRecordType type) {
+        if (settings().flightRecorderEnabled()) {
+            settings().flightRecorder().endRecord(type);
+        } else if (settings().asyncOutput()) {
+            settings().asyncWriter().endRecord(type, settings().segmented() ? threadID() : 0);
+        } else if (settings().perThreadOutput()) {
+            settings().threadOutput().endRecord(type, threadID());
+        } else if (!timesCalls() || type != ApiDumpRecordType::Call) {
+            if (settings().segmented()) settings().segments().endRecord(type, threadID());
+            output_mutex.unlock();
         }
-        std::thread::id this_id = std::this_thread::get_id();
-        std::lock_guard<std::recursive_mutex> lg(thread_mutex);
+    }
 
-        for (uint32_t i = 0; i < thread_count; ++i) {
-            if (thread_map[i] == this_id) {
-                return i;
-            }
+    // Writes out a call that the delta filter let through. The writer thread and api_dump_merge.py
+    // separate json calls themselves, otherwise the separator is only known now.
+    void writeDeltaRecord(const std::string &record) {
+        const bool direct = !settings().flightRecorderEnabled() && !settings().writesRecordsOnCompletion();
+        beginOutputRecord(ApiDumpRecordType::Call);
+        if (settings().separatesJsonCalls() && !settings().writesRecordsOnCompletion() &&
+            settings().deltaFilter().separateJsonCall())
+            settings().stream() << ",\n";
+        settings().stream().write(record.data(), record.size());
+        if (direct && settings().shouldFlush()) settings().flushOutput();
+        endOutputRecord(ApiDumpRecordType::Call);
+    }
+
+    // Writes out a record formatted once the call returned, from within beginRecord and endRecord.
+    inline void writeRecord(const std::string &record) {
+        if (settings().flightRecorderEnabled() || settings().writesRecordsOnCompletion()) {
+            settings().stream().write(record.data(), record.size());
+            return;
+        }
+        std::lock_guard<std::recursive_mutex> lg(output_mutex);
+        if (settings().segmented()) settings().segments().beginRecord(ApiDumpRecordType::Call);
+        settings().stream().write(record.data(), record.size());
+        if (settings().segmented()) settings().segments().endRecord(ApiDumpRecordType::Call, threadID());
+        if (settings().shouldFlush()) settings().flushOutput();
+    }
+
+    inline bool timesCalls() { return settings().format() == ApiDumpFormat::Stats || settings().format() == ApiDumpFormat::Trace; }
+
+    inline ApiDumpCallStats &callStats() { return call_stats; }
+
+    // Called with the result of every API call that returns a VkResult.
+    inline void checkResult(VkResult result) {
+        if (result < 0 && settings().flightRecorderEnabled() && settings().flightRecorder().isTriggeredBy(result))
+            settings().flightRecorder().write("a failed API call");
+    }
+
+    // Naming an object again replaces its name, like the driver does.
+    inline void setObjectName(uint64_t object, const char *name) {
+        if (name != NULL)
+            object_names.assign(object, std::string(name));
+        else
+            object_names.erase(object);
+        object_name_generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Decides whether a call on the given dispatchable handle is dumped, before its head is
+    // formatted. Each thread remembers the decision for the last handle it called with until an
+    // object is named, so that the name is rarely looked up. Calls without a dispatchable handle
+    // are always dumped.
+    inline bool isObjectDumped(uint64_t handle) {
+        CallDecision &decision = callDecision();
+        if (!settings().filtersObjects() || handle == 0) {
+            decision.dumped = true;
+            return true;
+        }
+        uint64_t generation = object_name_generation.load(std::memory_order_relaxed);
+        if (decision.handle != handle || decision.generation != generation) {
+            std::string name;
+            bool named = getObjectName(handle, name);
+            decision.handle = handle;
+            decision.generation = generation;
+            decision.dumped = settings().isObjectDumped(handle, named ? name.c_str() : NULL);
+        }
+        return decision.dumped;
+    }
+
+    // Decides whether a call that passed the other filters is sampled, before its head is formatted.
+    // Takes a generated function id.
+    inline bool isCallSampled(uint32_t function) {
+        CallDecision &decision = callDecision();
+        decision.sampled = !settings().samplesCalls() || settings().callSampler().sample(threadID(), function);
+        return decision.sampled;
+    }
+
+    // Decides once, in the head of a call, whether the call is dumped, from its function, the
+    // current frame, its object and sampling. Every head overwrites the decision of the previous
+    // call on the thread.
+    inline bool decideCall(uint32_t function, uint64_t handle) {
+        CallDecision &decision = callDecision();
+        decision.recorded = settings().isFunctionDumped(function) && shouldDumpOutput() && isObjectDumped(handle) &&
+                            isCallSampled(function);
+        return decision.recorded;
+    }
+
+    // Whether the head of the calling thread's current call began a record, which its body then
+    // ends, even if the frame, the function filter or the object's name changed since.
+    inline bool wasCallDumped() { return callDecision().recorded; }
+
+    inline bool getObjectName(uint64_t object, std::string &name) { return object_names.find(object, name); }
+
+    inline const ApiDumpSettings &settings() {
+        if (dump_settings == NULL) {
+            dump_settings = new ApiDumpSettings();
+            should_dump_output = dump_settings->isFrameDumped(frame_count);
+            if (dump_settings->needsFinalFlush() || dump_settings->flightRecorderEnabled()) setupFinalFlush();
         }
 
-        uint32_t new_index = thread_count;
-        thread_map[thread_count++] = this_id;
-        assert(thread_count < MAX_THREADS);
-        return new_index;
+        return *dump_settings;
+    }
+
+    // Threads are numbered in the order they first call into the layer, a thread that reuses the
+    // id of one that exited gets its number. Each thread only looks its number up once.
+    uint64_t threadID() {
+        static thread_local uint64_t this_thread_id = UINT64_MAX;
+        if (this_thread_id != UINT64_MAX) return this_thread_id;
+
+        std::lock_guard<std::mutex> lg(thread_mutex);
+        auto it = thread_ids.find(std::this_thread::get_id());
+        if (it == thread_ids.end()) it = thread_ids.insert(std::make_pair(std::this_thread::get_id(), thread_ids.size())).first;
+        this_thread_id = it->second;
+        return this_thread_id;
     }
 
+    // Called by every vkBeginCommandBuffer, which only locks the shard of its command buffer.
     inline VkCommandBufferLevel getCmdBufferLevel(VkCommandBuffer cmd_buffer) {
-        std::lock_guard<std::recursive_mutex> lg(cmd_buffer_state_mutex);
-        const auto level_iter = cmd_buffer_level.find(cmd_buffer);
-        assert(level_iter != cmd_buffer_level.end());
-        const auto level = level_iter->second;
+        VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        const bool found = cmd_buffer_level.find(cmd_buffer, level);
+        assert(found);
+        (void)found;
         return level;
     }
 
     inline void eraseCmdBuffers(VkDevice device, VkCommandPool cmd_pool, std::vector<VkCommandBuffer> cmd_buffers) {
         cmd_buffers.erase(std::remove(cmd_buffers.begin(), cmd_buffers.end(), nullptr), cmd_buffers.end());
         if (!cmd_buffers.empty()) {
-            std::lock_guard<std::recursive_mutex> lg(cmd_buffer_state_mutex);
+            std::lock_guard<std::mutex> lg(cmd_buffer_pools_mutex);
 
             const auto pool_cmd_buffers_iter = cmd_buffer_pools.find(std::make_pair(device, cmd_pool));
             assert(pool_cmd_buffers_iter != cmd_buffer_pools.end());
 
             for (const auto cmd_buffer : cmd_buffers) {
                 pool_cmd_buffers_iter->second.erase(cmd_buffer);
-
-                assert(cmd_buffer_level.count(cmd_buffer) > 0);
-                cmd_buffer_level.erase(cmd_buffer);
+                eraseCmdBufferState(cmd_buffer);
             }
         }
     }
 
     inline void addCmdBuffers(VkDevice device, VkCommandPool cmd_pool, std::vector<VkCommandBuffer> cmd_buffers,
                               VkCommandBufferLevel level) {
-        std::lock_guard<std::recursive_mutex> lg(cmd_buffer_state_mutex);
+        std::lock_guard<std::mutex> lg(cmd_buffer_pools_mutex);
         auto &pool_cmd_buffers = cmd_buffer_pools[std::make_pair(device, cmd_pool)];
         pool_cmd_buffers.insert(cmd_buffers.begin(), cmd_buffers.end());
 
-        for (const auto cmd_buffer : cmd_buffers) {
-            assert(cmd_buffer_level.count(cmd_buffer) == 0);
-            cmd_buffer_level[cmd_buffer] = level;
-        }
+        for (const auto cmd_buffer : cmd_buffers) cmd_buffer_level.assign(cmd_buffer, level);
     }
 
     inline void eraseCmdBufferPool(VkDevice device, VkCommandPool cmd_pool) {
         if (cmd_pool != VK_NULL_HANDLE) {
-            std::lock_guard<std::recursive_mutex> lg(cmd_buffer_state_mutex);
+            std::lock_guard<std::mutex> lg(cmd_buffer_pools_mutex);
 
             const auto cmd_buffers_iter = cmd_buffer_pools.find(std::make_pair(device, cmd_pool));
             if (cmd_buffers_iter != cmd_buffer_pools.end()) {
-                for (const auto cmd_buffer : cmd_buffers_iter->second) {
-                    assert(cmd_buffer_level.count(cmd_buffer) > 0);
-                    cmd_buffer_level.erase(cmd_buffer);
-                }
+                for (const auto cmd_buffer : cmd_buffers_iter->second) eraseCmdBufferState(cmd_buffer);
                 cmd_buffers_iter->second.clear();
             }
         }
     }
 
+    // Forgets everything tracked about a command buffer that was freed.
+    inline void eraseCmdBufferState(VkCommandBuffer cmd_buffer) {
+        if (settings().deltaOutput()) settings().deltaFilter().eraseCommandBuffer((uint64_t)cmd_buffer);
+        if (settings().summarizesCmdBuffers()) settings().cmdBufferSummaries().eraseCommandBuffer(cmd_buffer);
+        cmd_buffer_level.erase(cmd_buffer);
+    }
+
     inline std::chrono::microseconds current_time_since_start() {
-        std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
         return std::chrono::duration_cast<std::chrono::microseconds>(now - program_start);
     }
 
-    static inline ApiDumpInstance &current() { return current_instance; }
+    inline std::chrono::nanoseconds time_since_start(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time - program_start);
+    }
 
-    std::unordered_map<uint64_t, std::string> object_name_map;
+    static inline ApiDumpInstance &current() { return current_instance; }
 
    private:
+    struct CallDecision {
+        CallDecision() : handle(0), generation(UINT64_MAX), dumped(true), sampled(true), recorded(false) {}
+
+        uint64_t handle;
+        uint64_t generation;
+        bool dumped;  // for the handle
+        bool sampled;
+        bool recorded;  // the current call has a record open
+    };
+
+    static inline CallDecision &callDecision() {
+        static thread_local CallDecision decision;
+        return decision;
+    }
+
+    // When output is not flushed after every call, make sure that whatever is still buffered is
+    // written out when the process exits or is killed, so that the output of a crashing
+    // application is complete. Signals also trigger the flight recorder.
+    void setupFinalFlush() {
+        if (dump_settings->flushOptions().policy == ApiDumpFlushPolicy::Interval && !dump_settings->asyncOutput()) {
+            flush_timer = new ApiDumpIntervalTimer(dump_settings->flushOptions().interval, [this]() {
+                std::lock_guard<std::recursive_mutex> lg(output_mutex);
+                dump_settings->flushOutput();
+            });
+        }
+
+        std::atexit(flushOutputAtExit);
+#if !defined(_WIN32)
+        signal_flusher = new ApiDumpSignalFlusher([this](bool process_ends) { flushOutputForSignal(process_ends); });
+        struct sigaction action = {};
+        action.sa_sigaction = flushOutputOnSignal;
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        for (size_t i = 0; i < API_DUMP_FLUSH_SIGNAL_COUNT; ++i) {
+            signal_handler_installed[i] = false;
+            if (sigaction(API_DUMP_FLUSH_SIGNALS[i], NULL, &previous_signal_actions[i]) != 0) continue;
+            // Leave signals the application ignores alone
+            if (!(previous_signal_actions[i].sa_flags & SA_SIGINFO) && previous_signal_actions[i].sa_handler == SIG_IGN) continue;
+            signal_handler_installed[i] = sigaction(API_DUMP_FLUSH_SIGNALS[i], &action, NULL) == 0;
+        }
+#if defined(SIGUSR1)
+        // Lets a running application write out its flight recorder with "kill -USR1 <pid>". An
+        // application that uses SIGUSR1 itself still gets it, and its blocking calls are restarted.
+        if (dump_settings->flightRecorderEnabled()) {
+            struct sigaction usr1_action = {};
+            usr1_action.sa_sigaction = requestFlightRecorderWrite;
+            usr1_action.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+            sigemptyset(&usr1_action.sa_mask);
+            usr1_handler_installed = sigaction(SIGUSR1, &usr1_action, &previous_usr1_action) == 0;
+        }
+#endif
+        signal_handlers_installed = true;
+#endif
+    }
+
+    static void flushOutputAtExit() {
+        ApiDumpInstance &instance = current_instance;
+        if (instance.dump_settings == NULL) return;
+        // A write requested since the last record would otherwise be lost
+        if (instance.dump_settings->flightRecorderEnabled()) instance.dump_settings->flightRecorder().writeIfRequested();
+        // The asynchronous writer flushes everything it has left when it is stopped
+        if (instance.dump_settings->asyncOutput()) return;
+        std::lock_guard<std::recursive_mutex> lg(instance.output_mutex);
+        instance.dump_settings->flushOutput();
+    }
+
+#if !defined(_WIN32)
+    void restoreSignalHandlers() {
+        if (!signal_handlers_installed) return;
+        for (size_t i = 0; i < API_DUMP_FLUSH_SIGNAL_COUNT; ++i) {
+            if (signal_handler_installed[i]) sigaction(API_DUMP_FLUSH_SIGNALS[i], &previous_signal_actions[i], NULL);
+        }
+#if defined(SIGUSR1)
+        if (usr1_handler_installed) sigaction(SIGUSR1, &previous_usr1_action, NULL);
+#endif
+        signal_handlers_installed = false;
+    }
+
+#if defined(SIGUSR1)
+    static void requestFlightRecorderWrite(int signal, siginfo_t *info, void *context) {
+        ApiDumpInstance &instance = current_instance;
+        if (instance.dump_settings != NULL) instance.dump_settings->flightRecorder().requestWrite();
+        // The default action would end the process
+        const struct sigaction &previous = instance.previous_usr1_action;
+        if ((previous.sa_flags & SA_SIGINFO) || (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN))
+            callPreviousHandler(previous, signal, info, context);
+    }
+#endif
+
+    // Runs on the thread of signal_flusher while the thread that got the signal waits for it.
+    // Synchronous output holds outputMutex from the head of a call to its body, so a crash in the
+    // driver leaves it locked by the crashed thread. Once that has been waited out, the output is
+    // flushed without it, as the other threads that write are then waiting for it.
+    void flushOutputForSignal(bool process_ends) {
+        std::unique_lock<std::recursive_mutex> lock(output_mutex, std::defer_lock);
+        for (int waited_ms = 0; waited_ms < API_DUMP_SIGNAL_OUTPUT_LOCK_TIMEOUT_MS && !lock.try_lock(); waited_ms += 10)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        dump_settings->flushAllOutput(process_ends);
+    }
+
+    // Only does what is async-signal-safe: the output is written out by signal_flusher, then the
+    // signal is handed on to whoever handled it before, with the same arguments. The process only
+    // goes down by itself if nobody handled the signal before, an application's own handler may
+    // keep it running.
+    static void flushOutputOnSignal(int signal, siginfo_t *info, void *context) {
+        int saved_errno = errno;
+        ApiDumpInstance &instance = current_instance;
+        for (size_t i = 0; i < API_DUMP_FLUSH_SIGNAL_COUNT; ++i) {
+            if (API_DUMP_FLUSH_SIGNALS[i] != signal) continue;
+            const struct sigaction &previous = instance.previous_signal_actions[i];
+            bool process_ends = !(previous.sa_flags & SA_SIGINFO) && previous.sa_handler == SIG_DFL;
+            if (instance.signal_flusher != NULL) instance.signal_flusher->flushAndWait(API_DUMP_SIGNAL_FLUSH_TIMEOUT_MS, process_ends);
+            errno = saved_errno;
+            if (previous.sa_flags & SA_SIGINFO) {
+                callPreviousHandler(previous, signal, info, context);
+            } else if (previous.sa_handler == SIG_DFL) {
+                // The signal is blocked until this handler returns, and then ends the process
+                sigaction(signal, &previous, NULL);
+                raise(signal);
+            } else if (previous.sa_handler != SIG_IGN) {
+                callPreviousHandler(previous, signal, info, context);
+            }
+            errno = saved_errno;
+            return;
+        }
+    }
+
+    static void callPreviousHandler(const struct sigaction &previous, int signal, siginfo_t *info, void *context) {
+        sigset_t mask;
+        pthread_sigmask(SIG_BLOCK, &previous.sa_mask, &mask);
+        if (previous.sa_flags & SA_SIGINFO) {
+            previous.sa_sigaction(signal, info, context);
+        } else {
+            previous.sa_handler(signal);
+        }
+        pthread_sigmask(SIG_SETMASK, &mask, NULL);
+    }
+#endif
+
     static ApiDumpInstance current_instance;
 
     ApiDumpSettings *dump_settings;
     std::recursive_mutex output_mutex;
+    ApiDumpIntervalTimer *flush_timer = NULL;
+#if !defined(_WIN32)
+    ApiDumpSignalFlusher *signal_flusher = NULL;
+    bool signal_handlers_installed = false;
+    bool signal_handler_installed[API_DUMP_FLUSH_SIGNAL_COUNT];
+    struct sigaction previous_signal_actions[API_DUMP_FLUSH_SIGNAL_COUNT];
+    bool usr1_handler_installed = false;
+    struct sigaction previous_usr1_action;
+#endif
     std::recursive_mutex frame_mutex;
     uint64_t frame_count;
 
-    static const size_t MAX_THREADS = 513;
-    std::recursive_mutex thread_mutex;
-    std::thread::id thread_map[MAX_THREADS];
-    uint32_t thread_count;
-    uint64_t thread_id = UINT64_MAX;
+    ApiDumpCallStats call_stats;
+
+    std::mutex thread_mutex;
+    std::unordered_map<std::thread::id, uint64_t> thread_ids;
 
-    std::recursive_mutex cmd_buffer_state_mutex;
+    // Only changed when command buffers are allocated or freed
+    std::mutex cmd_buffer_pools_mutex;
     std::map<std::pair<VkDevice, VkCommandPool>, std::unordered_set<VkCommandBuffer> > cmd_buffer_pools;
-    std::unordered_map<VkCommandBuffer, VkCommandBufferLevel> cmd_buffer_level;
+    ApiDumpShardedMap<VkCommandBuffer, VkCommandBufferLevel> cmd_buffer_level;
 
-    bool conditional_initialized = false;
-    bool should_dump_output = true;
-    bool first_func_call_on_frame = false;
+    ApiDumpShardedMap<uint64_t, std::string> object_names;
+    // Changes whenever an object is named, see isObjectDumped
+    std::atomic<uint64_t> object_name_generation{0};
 
-    std::chrono::system_clock::time_point program_start;
+    // Read by every call, and flipped at frame boundaries by the output range and the control file
+    std::atomic<bool> should_dump_output{true};
+    std::atomic<bool> first_func_call_on_frame{false};
+
+    std::chrono::steady_clock::time_point program_start;
 };
 
 // Utility to output an address.
@@ -844,119 +3810,110 @@ void OutputAddress(const ApiDumpSettings &settings, const void *addr, bool quote
         if (addr == NULL)
             settings.stream() << "NULL";
         else
-            settings.stream() << addr;
+            dump_write_pointer(settings.stream(), addr);
     else
         settings.stream() << "address";
     if (quotes) settings.stream() << "\"";
 }
 
+// Describes a payload that goes through the blob store: the blob holding it, or its bytes in hex
+// if it is too small for a blob. Used for text, html, and json output.
+void OutputPayload(const ApiDumpSettings &settings, const void *data, size_t size) {
+    dump_write_uint(settings.stream(), size);
+    std::string blob = settings.blobStore().store(data, size);
+    if (!blob.empty()) {
+        settings.stream() << " bytes in " << blob;
+        return;
+    }
+    settings.stream() << " bytes: ";
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        char pair[2];
+        format_hex(bytes[i], pair + 2, 2, false);
+        settings.stream().write(pair, 2);
+    }
+}
+
+// An entry point the layer intercepts, for vkGetInstanceProcAddr and vkGetDeviceProcAddr.
+struct ApiDumpProcEntry {
+    const char *name;
+    PFN_vkVoidFunction proc;
+};
+
+// Binary searches a table of entry points sorted by name, returns NULL if name is not in it.
+template <size_t N>
+inline PFN_vkVoidFunction find_proc_address(const ApiDumpProcEntry (&procs)[N], const char *name) {
+    size_t first = 0;
+    size_t last = N;
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        int order = strcmp(procs[middle].name, name);
+        if (order == 0) return procs[middle].proc;
+        if (order < 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return NULL;
+}
+
+// Builds the "name[i]" element names of an array in one reused string.
+class ArrayIndexName {
+   public:
+    explicit ArrayIndexName(const char *prefix) : text(prefix), prefix_length(text.size()) {}
+
+    const char *get(size_t index) {
+        char buffer[API_DUMP_NUMBER_BUFFER_SIZE];
+        char *end = buffer + sizeof(buffer);
+        char *begin = format_decimal(index, end);
+        text.resize(prefix_length);
+        text += '[';
+        text.append(begin, end - begin);
+        text += ']';
+        return text.c_str();
+    }
+
+   private:
+    std::string text;
+    size_t prefix_length;
+};
+
 ApiDumpInstance ApiDumpInstance::current_instance;
 
 //==================================== Text Backend Helpers ======================================//
 
-template <typename T, typename... Args>
-inline void dump_text_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
-                            const char *child_type, const char *name, int indents,
-                            std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
+// Writes the line an array starts with, false if the array is NULL.
+inline bool dump_text_array_head(const void *array, const ApiDumpSettings &settings, const char *type_string, const char *name,
+                                 int indents) {
     settings.formatNameType(settings.stream(), indents, name, type_string);
     if (array == NULL) {
         settings.stream() << "NULL\n";
-        return;
+        return false;
     }
     OutputAddress(settings, array, false);
     settings.stream() << "\n";
-    for (size_t i = 0; i < len && array != NULL; ++i) {
-        std::stringstream stream;
-        stream << name << '[' << i << ']';
-        std::string indexName = stream.str();
-        dump_text_value(array[i], settings, child_type, indexName.c_str(), indents + 1, dump, args...);
-    }
+    return true;
 }
 
 template <typename T, typename... Args>
 inline void dump_text_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
                             const char *child_type, const char *name, int indents,
-                            std::ostream &(*dump)(const T &, const ApiDumpSettings &, int, Args... args), Args... args) {
-    settings.formatNameType(settings.stream(), indents, name, type_string);
-    if (array == NULL) {
-        settings.stream() << "NULL\n";
-        return;
-    }
-    OutputAddress(settings, array, false);
-    settings.stream() << "\n";
+                            std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
+    if (!dump_text_array_head(array, settings, type_string, name, indents)) return;
+    ArrayIndexName indexName(name);
     for (size_t i = 0; i < len && array != NULL; ++i) {
-        std::stringstream stream;
-        stream << name << '[' << i << ']';
-        std::string indexName = stream.str();
-        dump_text_value(array[i], settings, child_type, indexName.c_str(), indents + 1, dump, args...);
-    }
-}
-
-template <typename T, typename... Args>
-inline void dump_text_array_hex(const uint32_t *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
-                                const char *child_type, const char *name, int indents,
-                                std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
-    settings.formatNameType(settings.stream(), indents, name, type_string);
-    if (array == NULL) {
-        settings.stream() << "NULL\n";
-        return;
-    }
-    OutputAddress(settings, array, false);
-    std::stringstream stream;
-    const uint8_t *arraybyte = reinterpret_cast<const uint8_t *>(array);
-    for (size_t i = 0; i < (len * 4) && array != NULL; ++i) {
-        stream << std::hex << std::setw(2) << std::setfill('0') << (int)arraybyte[i] << " ";
-        if (i % 32 == 31) {
-            stream << "\n";
-        }
-    }
-
-    if (settings.stream().rdbuf() == std::cout.rdbuf()) {
-        settings.stream() << "\n" << stream.str() << "\n";
-    } else {
-        static uint64_t shaderDumpIndex = 0;
-        std::stringstream shaderDumpFileName;
-        shaderDumpFileName << settings.directory() << "shader_" << shaderDumpIndex << ".hex";
-        settings.stream() << " (" << shaderDumpFileName.str() << ")\n";
-        ++shaderDumpIndex;
-        std::ofstream shaderDumpFile;
-        shaderDumpFile.open(shaderDumpFileName.str(), std::ofstream::out | std::ostream::trunc);
-        shaderDumpFile << stream.str() << "\n";
-        shaderDumpFile.close();
+        dump_text_value(array[i], settings, child_type, indexName.get(i), indents + 1, dump, args...);
     }
 }
 
 template <typename T, typename... Args>
-inline void dump_text_array_hex(const uint32_t *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
-                                const char *child_type, const char *name, int indents,
-                                std::ostream &(*dump)(const T &, const ApiDumpSettings &, int, Args... args), Args... args) {
-    settings.formatNameType(settings.stream(), indents, name, type_string);
-    if (array == NULL) {
-        settings.stream() << "NULL\n";
-        return;
-    }
-    OutputAddress(settings, array, false);
-    std::stringstream stream;
-    const uint8_t *arraybyte = reinterpret_cast<const uint8_t *>(array);
-    for (size_t i = 0; i < (len * 4) && array != NULL; ++i) {
-        stream << std::hex << std::setw(2) << std::setfill('0') << (int)arraybyte[i] << " ";
-        if (i % 32 == 31) {
-            stream << "\n";
-        }
-    }
-
-    if (settings.stream().rdbuf() == std::cout.rdbuf()) {
-        settings.stream() << "\n" << stream.str() << "\n";
-    } else {
-        static uint64_t shaderDumpIndex = 0;
-        std::stringstream shaderDumpFileName;
-        shaderDumpFileName << settings.directory() << "shader_" << shaderDumpIndex << ".hex";
-        settings.stream() << " (" << shaderDumpFileName.str() << ")\n";
-        ++shaderDumpIndex;
-        std::ofstream shaderDumpFile;
-        shaderDumpFile.open(shaderDumpFileName.str(), std::ofstream::out | std::ostream::trunc);
-        shaderDumpFile << stream.str() << "\n";
-        shaderDumpFile.close();
+inline void dump_text_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
+                            const char *child_type, const char *name, int indents,
+                            std::ostream &(*dump)(const T &, const ApiDumpSettings &, int, Args... args), Args... args) {
+    if (!dump_text_array_head(array, settings, type_string, name, indents)) return;
+    ArrayIndexName indexName(name);
+    for (size_t i = 0; i < len && array != NULL; ++i) {
+        dump_text_value(array[i], settings, child_type, indexName.get(i), indents + 1, dump, args...);
     }
 }
 
@@ -1005,7 +3962,7 @@ inline void dump_text_special(const char *text, const ApiDumpSettings &settings,
     settings.stream() << text << "\n";
 }
 
-inline bool dump_text_bitmaskOption(const std::string &option, std::ostream &stream, bool isFirst) {
+inline bool dump_text_bitmaskOption(const char *option, std::ostream &stream, bool isFirst) {
     if (isFirst)
         stream << " (";
     else
@@ -1014,6 +3971,21 @@ inline bool dump_text_bitmaskOption(const std::string &option, std::ostream &str
     return false;
 }
 
+inline std::ostream &dump_text_enum(const char *option, int64_t value, const ApiDumpSettings &settings) {
+    settings.stream() << (option != NULL ? option : "UNKNOWN") << " (";
+    return dump_write_int(settings.stream(), value) << ")";
+}
+
+inline std::ostream &dump_text_bitmask(const ApiDumpBitmaskOption *options, uint64_t value, const ApiDumpSettings &settings) {
+    bool is_first = true;
+    dump_write_uint(settings.stream(), value);
+    for (const ApiDumpBitmaskOption *option = options; option->name != NULL; ++option) {
+        if (dump_bitmask_option_set(*option, value)) is_first = dump_text_bitmaskOption(option->name, settings.stream(), is_first);
+    }
+    if (!is_first) settings.stream() << ")";
+    return settings.stream();
+}
+
 inline std::ostream &dump_text_cstring(const char *object, const ApiDumpSettings &settings, int indents) {
     if (object == NULL)
         return settings.stream() << "NULL";
@@ -1027,7 +3999,23 @@ inline std::ostream &dump_text_void(const void *object, const ApiDumpSettings &s
     return settings.stream();
 }
 
-inline std::ostream &dump_text_int(int object, const ApiDumpSettings &settings, int indents) { return settings.stream() << object; }
+// Shader code and void pointers with a length, which go through the blob store when it is enabled.
+inline void dump_text_payload(const void *data, size_t size, const ApiDumpSettings &settings, const char *type_string,
+                              const char *name, int indents) {
+    if (!settings.storesBlobs() || data == NULL) {
+        dump_text_value<const void *>(data, settings, type_string, name, indents, dump_text_void);
+        return;
+    }
+    settings.formatNameType(settings.stream(), indents, name, type_string);
+    OutputAddress(settings, data, false);
+    settings.stream() << " (";
+    OutputPayload(settings, data, size);
+    settings.stream() << ")\n";
+}
+
+inline std::ostream &dump_text_int(int object, const ApiDumpSettings &settings, int indents) {
+    return dump_write_int(settings.stream(), object);
+}
 
 template <typename T, typename... Args>
 inline void dump_text_pNext(const T *object, const ApiDumpSettings &settings, const char *type_string, int indents,
@@ -1041,6 +4029,59 @@ inline void dump_text_pNext(const T *object, const ApiDumpSettings &settings, co
         settings.stream() << "address";
 }
 
+std::ostream &dump_text_type(uint32_t type_id, const void *object, const ApiDumpSettings &settings, int indents);
+std::ostream &dump_text_pNext_trampoline(const void *object, const ApiDumpSettings &settings, int indents);
+std::ostream &dump_text_pNext_struct_name(const void *object, const ApiDumpSettings &settings, int indents);
+
+inline void dump_text_typed_value(uint32_t type_id, const void *object, const ApiDumpSettings &settings, const char *type_string,
+                                  const char *name, int indents) {
+    settings.formatNameType(settings.stream(), indents, name, type_string);
+    dump_text_type(type_id, object, settings, indents);
+    if (api_dump_types[type_id].kind == ApiDumpTypeKind::Value) settings.stream() << "\n";
+}
+
+inline std::ostream &dump_text_struct(const ApiDumpMemberInfo *members, const void *object, const ApiDumpSettings &settings,
+                                      int indents) {
+    if (settings.showAddress())
+        dump_write_pointer(settings.stream(), object) << ":\n";
+    else
+        settings.stream() << "address:\n";
+
+    const void *pNext = NULL;
+    for (const ApiDumpMemberInfo *member = members; member->name != NULL; ++member) {
+        const char *field = static_cast<const char *>(object) + member->offset;
+        if (member->flags & API_DUMP_MEMBER_PNEXT) {
+            pNext = *reinterpret_cast<const void *const *>(field);
+            // The chain itself is written after the other members
+            if (pNext != NULL) {
+                dump_text_pNext_struct_name(pNext, settings, indents + 1);
+                continue;
+            }
+        }
+        if (member->flags & API_DUMP_MEMBER_PAYLOAD) {
+            dump_text_payload(*reinterpret_cast<const void *const *>(field), dump_member_count(members, *member, object), settings,
+                              member->type, member->name, indents + 1);
+        } else if (member->flags & API_DUMP_MEMBER_ARRAY) {
+            const char *array = static_cast<const char *>(dump_member_pointer(field, member->flags));
+            if (!dump_text_array_head(array, settings, member->type, member->name, indents + 1)) continue;
+            size_t count = dump_member_count(members, *member, object);
+            size_t size = api_dump_types[member->type_id].size;
+            ArrayIndexName indexName(member->name);
+            for (size_t i = 0; i < count; ++i)
+                dump_text_typed_value(member->type_id, array + i * size, settings, member->child_type, indexName.get(i), indents + 2);
+        } else {
+            const void *decayed;
+            const void *value = dump_member_value(field, member->flags, decayed);
+            if (value == NULL)
+                dump_text_special("NULL", settings, member->type, member->name, indents + 1);
+            else
+                dump_text_typed_value(member->type_id, value, settings, member->type, member->name, indents + 1);
+        }
+    }
+    if (pNext != NULL) dump_text_pNext_trampoline(pNext, settings, indents < 2 ? indents + 1 : indents);
+    return settings.stream();
+}
+
 //==================================== Html Backend Helpers ======================================//
 
 inline std::ostream &dump_html_nametype(std::ostream &stream, bool showType, const char *name, const char *type) {
@@ -1051,28 +4092,29 @@ inline std::ostream &dump_html_nametype(std::ostream &stream, bool showType, con
     return stream;
 }
 
-template <typename T, typename... Args>
-inline void dump_html_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
-                            const char *child_type, const char *name, int indents,
-                            std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
-    if (array == NULL) {
-        settings.stream() << "<details class='data'><summary>";
-        dump_html_nametype(settings.stream(), settings.showType(), name, type_string);
-        settings.stream() << "<div class='val'>";
-        settings.stream() << "NULL</div></summary></details>";
-        return;
-    }
+// Writes the summary of an array, false if the array is NULL.
+inline bool dump_html_array_head(const void *array, const ApiDumpSettings &settings, const char *type_string, const char *name) {
     settings.stream() << "<details class='data'><summary>";
     dump_html_nametype(settings.stream(), settings.showType(), name, type_string);
     settings.stream() << "<div class='val'>";
+    if (array == NULL) {
+        settings.stream() << "NULL</div></summary></details>";
+        return false;
+    }
     OutputAddress(settings, array, false);
     settings.stream() << "\n";
     settings.stream() << "</div></summary>";
+    return true;
+}
+
+template <typename T, typename... Args>
+inline void dump_html_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
+                            const char *child_type, const char *name, int indents,
+                            std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
+    if (!dump_html_array_head(array, settings, type_string, name)) return;
+    ArrayIndexName indexName(name);
     for (size_t i = 0; i < len && array != NULL; ++i) {
-        std::stringstream stream;
-        stream << name << '[' << i << ']';
-        std::string indexName = stream.str();
-        dump_html_value(array[i], settings, child_type, indexName.c_str(), indents + 1, dump, args...);
+        dump_html_value(array[i], settings, child_type, indexName.get(i), indents + 1, dump, args...);
     }
     settings.stream() << "</details>";
 }
@@ -1081,24 +4123,10 @@ template <typename T, typename... Args>
 inline void dump_html_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
                             const char *child_type, const char *name, int indents,
                             std::ostream &(*dump)(const T &, const ApiDumpSettings &, int, Args... args), Args... args) {
-    if (array == NULL) {
-        settings.stream() << "<details class='data'><summary>";
-        dump_html_nametype(settings.stream(), settings.showType(), name, type_string);
-        settings.stream() << "<div class='val'>";
-        settings.stream() << "NULL</div></summary></details>";
-        return;
-    }
-    settings.stream() << "<details class='data'><summary>";
-    dump_html_nametype(settings.stream(), settings.showType(), name, type_string);
-    settings.stream() << "<div class='val'>";
-    OutputAddress(settings, array, false);
-    settings.stream() << "\n";
-    settings.stream() << "</div></summary>";
+    if (!dump_html_array_head(array, settings, type_string, name)) return;
+    ArrayIndexName indexName(name);
     for (size_t i = 0; i < len && array != NULL; ++i) {
-        std::stringstream stream;
-        stream << name << '[' << i << ']';
-        std::string indexName = stream.str();
-        dump_html_value(array[i], settings, child_type, indexName.c_str(), indents + 1, dump, args...);
+        dump_html_value(array[i], settings, child_type, indexName.get(i), indents + 1, dump, args...);
     }
     settings.stream() << "</details>";
 }
@@ -1155,7 +4183,7 @@ inline void dump_html_special(const char *text, const ApiDumpSettings &settings,
     settings.stream() << "<div class='val'>" << text << "</div></summary></details>";
 }
 
-inline bool dump_html_bitmaskOption(const std::string &option, std::ostream &stream, bool isFirst) {
+inline bool dump_html_bitmaskOption(const char *option, std::ostream &stream, bool isFirst) {
     if (isFirst)
         stream << " (";
     else
@@ -1164,6 +4192,22 @@ inline bool dump_html_bitmaskOption(const std::string &option, std::ostream &str
     return false;
 }
 
+inline std::ostream &dump_html_enum(const char *option, int64_t value, const ApiDumpSettings &settings) {
+    settings.stream() << "<div class='val'>" << (option != NULL ? option : "UNKNOWN") << " (";
+    return dump_write_int(settings.stream(), value) << ")</div></summary>";
+}
+
+inline std::ostream &dump_html_bitmask(const ApiDumpBitmaskOption *options, uint64_t value, const ApiDumpSettings &settings) {
+    settings.stream() << "<div class='val'>";
+    bool is_first = true;
+    dump_write_uint(settings.stream(), value);
+    for (const ApiDumpBitmaskOption *option = options; option->name != NULL; ++option) {
+        if (dump_bitmask_option_set(*option, value)) is_first = dump_html_bitmaskOption(option->name, settings.stream(), is_first);
+    }
+    if (!is_first) settings.stream() << ")";
+    return settings.stream() << "</div></summary>";
+}
+
 inline std::ostream &dump_html_cstring(const char *object, const ApiDumpSettings &settings, int indents) {
     settings.stream() << "<div class='val'>";
     if (object == NULL)
@@ -1179,9 +4223,24 @@ inline std::ostream &dump_html_void(const void *object, const ApiDumpSettings &s
     return settings.stream() << "</div>";
 }
 
+inline void dump_html_payload(const void *data, size_t size, const ApiDumpSettings &settings, const char *type_string,
+                              const char *name, int indents) {
+    if (!settings.storesBlobs() || data == NULL) {
+        dump_html_value<const void *>(data, settings, type_string, name, indents, dump_html_void);
+        return;
+    }
+    settings.stream() << "<details class='data'><summary>";
+    dump_html_nametype(settings.stream(), settings.showType(), name, type_string);
+    settings.stream() << "<div class='val'>";
+    OutputAddress(settings, data, false);
+    settings.stream() << " (";
+    OutputPayload(settings, data, size);
+    settings.stream() << ")</div></summary></details>";
+}
+
 inline std::ostream &dump_html_int(int object, const ApiDumpSettings &settings, int indents) {
     settings.stream() << "<div class='val'>";
-    settings.stream() << object;
+    dump_write_int(settings.stream(), object);
     return settings.stream() << "</div>";
 }
 
@@ -1197,79 +4256,163 @@ inline void dump_html_pNext(const T *object, const ApiDumpSettings &settings, co
     }
 }
 
+std::ostream &dump_html_type(uint32_t type_id, const void *object, const ApiDumpSettings &settings, int indents);
+std::ostream &dump_html_pNext_trampoline(const void *object, const ApiDumpSettings &settings, int indents);
+
+inline void dump_html_typed_value(uint32_t type_id, const void *object, const ApiDumpSettings &settings, const char *type_string,
+                                  const char *name, int indents) {
+    settings.stream() << "<details class='data'><summary>";
+    dump_html_nametype(settings.stream(), settings.showType(), name, type_string);
+    dump_html_type(type_id, object, settings, indents);
+    settings.stream() << "</details>";
+}
+
+inline std::ostream &dump_html_struct(const ApiDumpMemberInfo *members, const void *object, const ApiDumpSettings &settings,
+                                      int indents) {
+    settings.stream() << "<div class='val'>";
+    if (settings.showAddress())
+        dump_write_pointer(settings.stream(), object) << "\n";
+    else
+        settings.stream() << "address\n";
+    settings.stream() << "</div></summary>";
+
+    for (const ApiDumpMemberInfo *member = members; member->name != NULL; ++member) {
+        const char *field = static_cast<const char *>(object) + member->offset;
+        if ((member->flags & API_DUMP_MEMBER_PNEXT) && *reinterpret_cast<const void *const *>(field) != NULL) {
+            dump_html_pNext_trampoline(*reinterpret_cast<const void *const *>(field), settings, indents + 1);
+        } else if (member->flags & API_DUMP_MEMBER_PAYLOAD) {
+            dump_html_payload(*reinterpret_cast<const void *const *>(field), dump_member_count(members, *member, object), settings,
+                              member->type, member->name, indents + 1);
+        } else if (member->flags & API_DUMP_MEMBER_ARRAY) {
+            const char *array = static_cast<const char *>(dump_member_pointer(field, member->flags));
+            if (!dump_html_array_head(array, settings, member->type, member->name)) continue;
+            size_t count = dump_member_count(members, *member, object);
+            size_t size = api_dump_types[member->type_id].size;
+            ArrayIndexName indexName(member->name);
+            for (size_t i = 0; i < count; ++i)
+                dump_html_typed_value(member->type_id, array + i * size, settings, member->child_type, indexName.get(i), indents + 2);
+            settings.stream() << "</details>";
+        } else {
+            const void *decayed;
+            const void *value = dump_member_value(field, member->flags, decayed);
+            if (value == NULL)
+                dump_html_special("NULL", settings, member->type, member->name, indents + 1);
+            else
+                dump_html_typed_value(member->type_id, value, settings, member->type, member->name, indents + 1);
+        }
+    }
+    return settings.stream();
+}
+
 //==================================== Json Backend Helpers ======================================//
 
-template <typename T, typename... Args>
-inline void dump_json_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
-                            const char *child_type, const char *name, int indents,
-                            std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
+// How the json backend writes a value of type T, the generated code specializes this for every
+// struct and union so that dump_json_value does not have to look the type name up.
+template <typename T>
+struct ApiDumpTypeTraits {
+    static const ApiDumpTypeKind kind = ApiDumpTypeKind::Value;
+};
+
+template <>
+struct ApiDumpTypeTraits<ApiDumpCmdBufferSummary> {
+    static const ApiDumpTypeKind kind = ApiDumpTypeKind::Struct;
+};
+
+// Writes a value up to where its dump function writes its value or members, false if it has neither.
+inline bool dump_json_value_head(ApiDumpTypeKind kind, const void *pObject, const ApiDumpSettings &settings, const char *type_string,
+                                 const char *name, int indents) {
+    bool isPnext = !strcmp(name, "pNext") | !strcmp(name, "pUserData");
+    const char *star = (isPnext && !strstr(type_string, "void")) ? "*" : "";
+    settings.stream() << settings.indentation(indents) << "{" << settings.jsonLineBreak();
+    if (kind == ApiDumpTypeKind::Union)
+        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << star << " (Union)\","
+                          << settings.jsonLineBreak();
+    else
+        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << star << "\","
+                          << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\"";
+    if (isPnext || (strchr(type_string, '*') && strcmp(type_string, "const char*") && strcmp(type_string, "const char* const"))) {
+        // Print pointers, except for char string pointers
+        settings.stream() << "," << settings.jsonLineBreak() << settings.indentation(indents + 1) << "\"address\" : ";
+        OutputAddress(settings, pObject, true);
+    }
+    if (isPnext && pObject == nullptr) return false;
+    settings.stream() << "," << settings.jsonLineBreak();
+    if (kind != ApiDumpTypeKind::Value)
+        settings.stream() << settings.indentation(indents + 1) << "\"members\" :" << settings.jsonLineBreak();
+    else
+        settings.stream() << settings.indentation(indents + 1) << "\"value\" : ";
+    return true;
+}
+
+inline void dump_json_value_tail(const ApiDumpSettings &settings, int indents) {
+    settings.stream() << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents) << "}";
+}
+
+inline void dump_json_null(const ApiDumpSettings &settings, const char *type_string, const char *name, int indents) {
+    settings.stream() << settings.indentation(indents) << "{" << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\"," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\"," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
+    OutputAddress(settings, NULL, true);
+    settings.stream() << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents) << "}";
+}
+
+// Writes an array up to its first element, or the whole array and false if it has no elements.
+inline bool dump_json_array_head(const void *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
+                                 const char *name, int indents) {
+    settings.stream() << settings.indentation(indents) << "{" << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\"," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\"," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
+    OutputAddress(settings, array, true);
     if (len == 0 || array == NULL) {
-        settings.stream() << settings.indentation(indents) << "{\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
-        OutputAddress(settings, array, true);
-        settings.stream() << "\n";
+        settings.stream() << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents) << "}";
-        return;
+        return false;
     }
-    settings.stream() << settings.indentation(indents) << "{\n";
+    settings.stream() << "," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"elements\" :" << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "[" << settings.jsonLineBreak();
+    return true;
+}
 
-    if (len > 0 && array != NULL) {
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
-        OutputAddress(settings, array, true);
-        settings.stream() << ",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"elements\" :\n";
-        settings.stream() << settings.indentation(indents + 1) << "[\n";
-        for (size_t i = 0; i < len && array != NULL; ++i) {
-            std::stringstream stream;
-            stream << "[" << i << "]";
-            std::string indexName = stream.str();
-            dump_json_value(array[i], &array[i], settings, child_type, indexName.c_str(), indents + 2, dump, args...);
-            if (i < len - 1) settings.stream() << ',';
-            settings.stream() << "\n";
-        }
-        settings.stream() << settings.indentation(indents + 1) << "]";
+inline void dump_json_array_separator(size_t index, size_t len, const ApiDumpSettings &settings) {
+    if (index < len - 1) settings.stream() << ',';
+    settings.stream() << settings.jsonLineBreak();
+}
+
+inline void dump_json_array_tail(const ApiDumpSettings &settings, int indents) {
+    settings.stream() << settings.indentation(indents + 1) << "]";
+    settings.stream() << settings.jsonLineBreak() << settings.indentation(indents) << "}";
+}
+
+template <typename T, typename... Args>
+inline void dump_json_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
+                            const char *child_type, const char *name, int indents,
+                            std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
+    if (!dump_json_array_head(array, len, settings, type_string, name, indents)) return;
+    ArrayIndexName indexName("");
+    for (size_t i = 0; i < len; ++i) {
+        dump_json_value(array[i], &array[i], settings, child_type, indexName.get(i), indents + 2, dump, args...);
+        dump_json_array_separator(i, len, settings);
     }
-    settings.stream() << "\n" << settings.indentation(indents) << "}";
+    dump_json_array_tail(settings, indents);
 }
 
 template <typename T, typename... Args>
 inline void dump_json_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
                             const char *child_type, const char *name, int indents,
                             std::ostream &(*dump)(const T &, const ApiDumpSettings &, int, Args... args), Args... args) {
-    if (len == 0 || array == NULL) {
-        settings.stream() << settings.indentation(indents) << "{\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
-        OutputAddress(settings, array, true);
-        settings.stream() << "\n";
-        settings.stream() << settings.indentation(indents) << "}";
-        return;
-    }
-    settings.stream() << settings.indentation(indents) << "{\n";
-    if (len > 0 && array != NULL) {
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
-        OutputAddress(settings, array, true);
-        settings.stream() << ",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"elements\" :\n";
-        settings.stream() << settings.indentation(indents + 1) << "[\n";
-        for (size_t i = 0; i < len && array != NULL; ++i) {
-            std::stringstream stream;
-            stream << "[" << i << "]";
-            std::string indexName = stream.str();
-            dump_json_value(array[i], &array[i], settings, child_type, indexName.c_str(), indents + 2, dump, args...);
-            if (i < len - 1) settings.stream() << ',';
-            settings.stream() << "\n";
-        }
-        settings.stream() << settings.indentation(indents + 1) << "]";
+    if (!dump_json_array_head(array, len, settings, type_string, name, indents)) return;
+    ArrayIndexName indexName("");
+    for (size_t i = 0; i < len; ++i) {
+        dump_json_value(array[i], &array[i], settings, child_type, indexName.get(i), indents + 2, dump, args...);
+        dump_json_array_separator(i, len, settings);
     }
-    settings.stream() << "\n" << settings.indentation(indents) << "}";
+    dump_json_array_tail(settings, indents);
 }
 
 template <typename T, typename... Args>
@@ -1277,13 +4420,7 @@ inline void dump_json_pointer(const T *pointer, const ApiDumpSettings &settings,
                               int indents, std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args),
                               Args... args) {
     if (pointer == NULL) {
-        settings.stream() << settings.indentation(indents) << "{\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
-        OutputAddress(settings, NULL, true);
-        settings.stream() << "\n";
-        settings.stream() << settings.indentation(indents) << "}";
+        dump_json_null(settings, type_string, name, indents);
     } else {
         dump_json_value(*pointer, pointer, settings, type_string, name, indents, dump, args...);
     }
@@ -1294,93 +4431,44 @@ inline void dump_json_pointer(const T *pointer, const ApiDumpSettings &settings,
                               int indents, std::ostream &(*dump)(const T &, const ApiDumpSettings &, int, Args... args),
                               Args... args) {
     if (pointer == NULL) {
-        settings.stream() << settings.indentation(indents) << "{\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\",\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
-        OutputAddress(settings, NULL, true);
-        settings.stream() << "\n";
-        settings.stream() << settings.indentation(indents) << "}";
+        dump_json_null(settings, type_string, name, indents);
     } else {
         dump_json_value(*pointer, pointer, settings, type_string, name, indents, dump, args...);
     }
 }
 
-extern bool is_union(const char *t);
-extern bool is_struct(const char *t);
-
 template <typename T, typename... Args>
 inline void dump_json_value(const T object, const void *pObject, const ApiDumpSettings &settings, const char *type_string,
                             const char *name, int indents,
                             std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
-    bool isPnext = !strcmp(name, "pNext") | !strcmp(name, "pUserData");
-    const char *star = (isPnext && !strstr(type_string, "void")) ? "*" : "";
-    settings.stream() << settings.indentation(indents) << "{\n";
-    if (is_union(type_string))
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << star << " (Union)\",\n";
-    else
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << star << "\",\n";
-    settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\"";
-    if (isPnext || (strchr(type_string, '*') && strcmp(type_string, "const char*") && strcmp(type_string, "const char* const"))) {
-        // Print pointers, except for char string pointers
-        settings.stream() << ",\n" << settings.indentation(indents + 1) << "\"address\" : ";
-        OutputAddress(settings, pObject, true);
-    }
-    if (!isPnext || (isPnext && pObject != nullptr)) {
-        settings.stream() << ",\n";
-        if (is_union(type_string) || is_struct(type_string))
-            settings.stream() << settings.indentation(indents + 1) << "\"members\" :\n";
-        else
-            settings.stream() << settings.indentation(indents + 1) << "\"value\" : ";
-        dump(object, settings, indents + 1, args...);
-    }
-    settings.stream() << "\n";
-    settings.stream() << settings.indentation(indents) << "}";
+    const ApiDumpTypeKind kind = ApiDumpTypeTraits<typename std::remove_cv<T>::type>::kind;
+    if (dump_json_value_head(kind, pObject, settings, type_string, name, indents)) dump(object, settings, indents + 1, args...);
+    dump_json_value_tail(settings, indents);
 }
 
 template <typename T, typename... Args>
 inline void dump_json_value(const T &object, const void *pObject, const ApiDumpSettings &settings, const char *type_string,
                             const char *name, int indents,
                             std::ostream &(*dump)(const T &, const ApiDumpSettings &, int, Args... args), Args... args) {
-    bool isPnext = !strcmp(name, "pNext") | !strcmp(name, "pUserData");
-    const char *star = (isPnext && !strstr(type_string, "void")) ? "*" : "";
-    settings.stream() << settings.indentation(indents) << "{\n";
-    if (is_union(type_string))
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << star << " (Union)\",\n";
-    else
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << star << "\",\n";
-    settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\"";
-    if (isPnext || (strchr(type_string, '*') && strcmp(type_string, "const char*") && strcmp(type_string, "const char* const"))) {
-        // Print pointers, except for char string pointers
-        settings.stream() << ",\n" << settings.indentation(indents + 1) << "\"address\" : ";
-        OutputAddress(settings, pObject, true);
-    }
-    if (!isPnext || (isPnext && pObject != nullptr)) {
-        settings.stream() << ",\n";
-        if (is_union(type_string) || is_struct(type_string))
-            settings.stream() << settings.indentation(indents + 1) << "\"members\" :\n";
-        else
-            settings.stream() << settings.indentation(indents + 1) << "\"value\" : ";
-        dump(object, settings, indents + 1, args...);
-    }
-    settings.stream() << "\n";
-    settings.stream() << settings.indentation(indents) << "}";
+    const ApiDumpTypeKind kind = ApiDumpTypeTraits<typename std::remove_cv<T>::type>::kind;
+    if (dump_json_value_head(kind, pObject, settings, type_string, name, indents)) dump(object, settings, indents + 1, args...);
+    dump_json_value_tail(settings, indents);
 }
 
 inline void dump_json_special(const char *text, const ApiDumpSettings &settings, const char *type_string, const char *name,
                               int indents) {
-    settings.stream() << settings.indentation(indents) << "{\n";
-    settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\",\n";
-    settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\",\n";
+    settings.stream() << settings.indentation(indents) << "{" << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\"," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\"," << settings.jsonLineBreak();
     settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
     OutputAddress(settings, text, true);
-    settings.stream() << ",\n";
+    settings.stream() << "," << settings.jsonLineBreak();
     settings.stream() << settings.indentation(indents + 1) << "\"value\" : ";
-    settings.stream() << "\"" << text << "\"\n";
+    settings.stream() << "\"" << text << "\"" << settings.jsonLineBreak();
     settings.stream() << settings.indentation(indents) << "}";
 }
 
-inline bool dump_json_bitmaskOption(const std::string &option, std::ostream &stream, bool isFirst) {
+inline bool dump_json_bitmaskOption(const char *option, std::ostream &stream, bool isFirst) {
     if (isFirst)
         stream << "(";
     else
@@ -1389,6 +4477,23 @@ inline bool dump_json_bitmaskOption(const std::string &option, std::ostream &str
     return false;
 }
 
+inline std::ostream &dump_json_enum(const char *option, int64_t value, const ApiDumpSettings &settings) {
+    if (option != NULL) return settings.stream() << "\"" << option << "\"";
+    settings.stream() << "\"UNKNOWN (";
+    return dump_write_int(settings.stream(), value) << ")\"";
+}
+
+inline std::ostream &dump_json_bitmask(const ApiDumpBitmaskOption *options, uint64_t value, const ApiDumpSettings &settings) {
+    bool is_first = true;
+    dump_write_uint(settings.stream() << '"', value);
+    if (value) settings.stream() << ' ';
+    for (const ApiDumpBitmaskOption *option = options; option->name != NULL; ++option) {
+        if (dump_bitmask_option_set(*option, value)) is_first = dump_json_bitmaskOption(option->name, settings.stream(), is_first);
+    }
+    if (!is_first) settings.stream() << ')';
+    return settings.stream() << "\"";
+}
+
 inline std::ostream &dump_json_cstring(const char *object, const ApiDumpSettings &settings, int indents) {
     if (object == NULL)
         settings.stream() << "\"\"";
@@ -1399,13 +4504,32 @@ inline std::ostream &dump_json_cstring(const char *object, const ApiDumpSettings
 
 inline std::ostream &dump_json_void(const void *object, const ApiDumpSettings &settings, int indents) {
     OutputAddress(settings, object, true);
-    settings.stream() << "\n";
+    settings.stream() << settings.jsonLineBreak();
     return settings.stream();
 }
 
+inline void dump_json_payload(const void *data, size_t size, const ApiDumpSettings &settings, const char *type_string,
+                              const char *name, int indents) {
+    if (!settings.storesBlobs() || data == NULL) {
+        dump_json_value<const void *>(data, NULL, settings, type_string, name, indents, dump_json_void);
+        return;
+    }
+    settings.stream() << settings.indentation(indents) << "{" << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "\"," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"name\" : \"" << name << "\"," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
+    OutputAddress(settings, data, true);
+    settings.stream() << "," << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents + 1) << "\"value\" : \"";
+    OutputPayload(settings, data, size);
+    settings.stream() << "\"" << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(indents) << "}";
+}
+
 inline std::ostream &dump_json_int(int object, const ApiDumpSettings &settings, int indents) {
     settings.stream() << settings.indentation(indents) << "\"value\" : ";
-    settings.stream() << '"' << object << "\"";
+    settings.stream() << '"';
+    dump_write_int(settings.stream(), object) << "\"";
     return settings.stream();
 }
 
@@ -1413,14 +4537,15 @@ template <typename T, typename... Args>
 inline void dump_json_pNext(const T *object, const ApiDumpSettings &settings, const char *type_string, int indents,
                             std::ostream &(*dump)(const T, const ApiDumpSettings &, int, Args... args), Args... args) {
     if (object == NULL) {
-        settings.stream() << settings.indentation(indents) << "{\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "*\",\n";
+        settings.stream() << settings.indentation(indents) << "{" << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "*\","
+                          << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents + 1) << "\"name\" : \""
                           << "pNext"
-                          << "\",\n";
+                          << "\"," << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
         OutputAddress(settings, NULL, true);
-        settings.stream() << ",\n";
+        settings.stream() << "," << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents) << "}";
     } else {
         dump_json_value(*object, object, settings, type_string, "pNext", indents, dump, args...);
@@ -1431,16 +4556,274 @@ template <typename T, typename... Args>
 inline void dump_json_pNext(const T *object, const ApiDumpSettings &settings, const char *type_string, int indents,
                             std::ostream &(*dump)(const T &, const ApiDumpSettings &, int, Args... args), Args... args) {
     if (object == NULL) {
-        settings.stream() << settings.indentation(indents) << "{\n";
-        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "*\",\n";
+        settings.stream() << settings.indentation(indents) << "{" << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents + 1) << "\"type\" : \"" << type_string << "*\","
+                          << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents + 1) << "\"name\" : \""
                           << "pNext"
-                          << "\",\n";
+                          << "\"," << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents + 1) << "\"address\" : ";
         OutputAddress(settings, NULL, true);
-        settings.stream() << ",\n";
+        settings.stream() << "," << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents) << "}";
     } else {
         dump_json_value(*object, object, settings, type_string, "pNext", indents, dump, args...);
     }
 }
+
+std::ostream &dump_json_type(uint32_t type_id, const void *object, const ApiDumpSettings &settings, int indents);
+std::ostream &dump_json_pNext_trampoline(const void *object, const ApiDumpSettings &settings, int indents);
+
+inline void dump_json_typed_value(uint32_t type_id, const void *object, const void *pObject, const ApiDumpSettings &settings,
+                                  const char *type_string, const char *name, int indents) {
+    if (dump_json_value_head(api_dump_types[type_id].kind, pObject, settings, type_string, name, indents))
+        dump_json_type(type_id, object, settings, indents + 1);
+    dump_json_value_tail(settings, indents);
+}
+
+inline std::ostream &dump_json_struct(const ApiDumpMemberInfo *members, const void *object, const ApiDumpSettings &settings,
+                                      int indents) {
+    settings.stream() << settings.indentation(indents) << "[" << settings.jsonLineBreak();
+
+    for (const ApiDumpMemberInfo *member = members; member->name != NULL; ++member) {
+        if (member != members) settings.stream() << "," << settings.jsonLineBreak();
+        const char *field = static_cast<const char *>(object) + member->offset;
+        if ((member->flags & API_DUMP_MEMBER_PNEXT) && *reinterpret_cast<const void *const *>(field) != NULL) {
+            dump_json_pNext_trampoline(*reinterpret_cast<const void *const *>(field), settings, indents + 1);
+        } else if (member->flags & API_DUMP_MEMBER_PAYLOAD) {
+            dump_json_payload(*reinterpret_cast<const void *const *>(field), dump_member_count(members, *member, object), settings,
+                              member->type, member->name, indents + 1);
+        } else if (member->flags & API_DUMP_MEMBER_ARRAY) {
+            const char *array = static_cast<const char *>(dump_member_pointer(field, member->flags));
+            size_t count = dump_member_count(members, *member, object);
+            if (!dump_json_array_head(array, count, settings, member->type, member->name, indents + 1)) continue;
+            size_t size = api_dump_types[member->type_id].size;
+            ArrayIndexName indexName("");
+            for (size_t i = 0; i < count; ++i) {
+                const char *element = array + i * size;
+                dump_json_typed_value(member->type_id, element, element, settings, member->child_type, indexName.get(i), indents + 3);
+                dump_json_array_separator(i, count, settings);
+            }
+            dump_json_array_tail(settings, indents + 1);
+        } else {
+            const void *decayed;
+            const void *value = dump_member_value(field, member->flags, decayed);
+            if (value == NULL)
+                dump_json_null(settings, member->type, member->name, indents + 1);
+            else
+                dump_json_typed_value(member->type_id, value, member->flags & API_DUMP_MEMBER_POINTER ? value : NULL, settings,
+                                      member->type, member->name, indents + 1);
+        }
+    }
+    settings.stream() << settings.jsonLineBreak() << settings.indentation(indents) << "]";
+    return settings.stream();
+}
+
+//=================================== Binary Backend Helpers =====================================//
+
+inline void dump_binary_address(const void *addr, const ApiDumpSettings &settings) {
+    dump_binary_varint(settings.showAddress() ? (uint64_t)(uintptr_t)addr : 0, settings.stream());
+}
+
+// Every named value starts with its name, type and address, the dump function writes the payload.
+inline void dump_binary_node(const void *pObject, const ApiDumpSettings &settings, const char *type_string, const char *name) {
+    dump_binary_tag(ApiDumpBinaryTag::Value, settings.stream());
+    dump_binary_name(name, settings.stream());
+    dump_binary_name(type_string, settings.stream());
+    dump_binary_address(pObject, settings);
+}
+
+// Writes an array up to its first element, false if the array is NULL.
+inline bool dump_binary_array_head(const void *array, size_t len, size_t size, const ApiDumpSettings &settings,
+                                   const char *type_string, const char *child_type, const char *name) {
+    dump_binary_node(array, settings, type_string, name);
+    if (array == NULL) {
+        dump_binary_tag(ApiDumpBinaryTag::Null, settings.stream());
+        return false;
+    }
+    // Element addresses are implied by the array address and the element size
+    dump_binary_tag(ApiDumpBinaryTag::Array, settings.stream());
+    dump_binary_name(child_type, settings.stream());
+    dump_binary_varint(size, settings.stream());
+    dump_binary_varint(len, settings.stream());
+    return true;
+}
+
+template <typename T, typename... Args>
+inline void dump_binary_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
+                              const char *child_type, const char *name,
+                              std::ostream &(*dump)(const T, const ApiDumpSettings &, Args... args), Args... args) {
+    if (!dump_binary_array_head(array, len, sizeof(T), settings, type_string, child_type, name)) return;
+    for (size_t i = 0; i < len; ++i) dump(array[i], settings, args...);
+}
+
+template <typename T, typename... Args>
+inline void dump_binary_array(const T *array, size_t len, const ApiDumpSettings &settings, const char *type_string,
+                              const char *child_type, const char *name,
+                              std::ostream &(*dump)(const T &, const ApiDumpSettings &, Args... args), Args... args) {
+    if (!dump_binary_array_head(array, len, sizeof(T), settings, type_string, child_type, name)) return;
+    for (size_t i = 0; i < len; ++i) dump(array[i], settings, args...);
+}
+
+template <typename T, typename... Args>
+inline void dump_binary_value(const T object, const void *pObject, const ApiDumpSettings &settings, const char *type_string,
+                              const char *name, std::ostream &(*dump)(const T, const ApiDumpSettings &, Args... args),
+                              Args... args) {
+    dump_binary_node(pObject, settings, type_string, name);
+    dump(object, settings, args...);
+}
+
+template <typename T, typename... Args>
+inline void dump_binary_value(const T &object, const void *pObject, const ApiDumpSettings &settings, const char *type_string,
+                              const char *name, std::ostream &(*dump)(const T &, const ApiDumpSettings &, Args... args),
+                              Args... args) {
+    // Structs and unions are passed by reference, so their address is known even for members
+    dump_binary_node(pObject != NULL ? pObject : &object, settings, type_string, name);
+    dump(object, settings, args...);
+}
+
+template <typename T, typename... Args>
+inline void dump_binary_pointer(const T *pointer, const ApiDumpSettings &settings, const char *type_string, const char *name,
+                                std::ostream &(*dump)(const T, const ApiDumpSettings &, Args... args), Args... args) {
+    if (pointer == NULL) {
+        dump_binary_node(NULL, settings, type_string, name);
+        dump_binary_tag(ApiDumpBinaryTag::Null, settings.stream());
+    } else {
+        dump_binary_value(*pointer, pointer, settings, type_string, name, dump, args...);
+    }
+}
+
+template <typename T, typename... Args>
+inline void dump_binary_pointer(const T *pointer, const ApiDumpSettings &settings, const char *type_string, const char *name,
+                                std::ostream &(*dump)(const T &, const ApiDumpSettings &, Args... args), Args... args) {
+    if (pointer == NULL) {
+        dump_binary_node(NULL, settings, type_string, name);
+        dump_binary_tag(ApiDumpBinaryTag::Null, settings.stream());
+    } else {
+        dump_binary_value(*pointer, pointer, settings, type_string, name, dump, args...);
+    }
+}
+
+template <typename T, typename... Args>
+inline void dump_binary_pNext(const T *object, const ApiDumpSettings &settings, const char *type_string,
+                              std::ostream &(*dump)(const T &, const ApiDumpSettings &, Args... args), Args... args) {
+    dump_binary_pointer(object, settings, type_string, "pNext", dump, args...);
+}
+
+inline void dump_binary_special(const char *text, const ApiDumpSettings &settings, const char *type_string, const char *name) {
+    dump_binary_node(NULL, settings, type_string, name);
+    dump_binary_tag(ApiDumpBinaryTag::Special, settings.stream());
+    dump_binary_name(text, settings.stream());
+}
+
+// Raw bytes, used for data such as shader code where a value per element would be wasteful
+inline void dump_binary_blob(const void *data, size_t size, const ApiDumpSettings &settings, const char *type_string,
+                             const char *name) {
+    dump_binary_node(data, settings, type_string, name);
+    if (data == NULL) {
+        dump_binary_tag(ApiDumpBinaryTag::Null, settings.stream());
+        return;
+    }
+    dump_binary_tag(ApiDumpBinaryTag::Blob, settings.stream());
+    dump_binary_text(static_cast<const char *>(data), size, settings.stream());
+}
+
+inline std::ostream &dump_binary_enum(const char *option, int64_t value, const ApiDumpSettings &settings) {
+    dump_binary_tag(ApiDumpBinaryTag::Enum, settings.stream());
+    dump_binary_svarint(value, settings.stream());
+    dump_binary_name(option, settings.stream());
+    return settings.stream();
+}
+
+inline std::ostream &dump_binary_bitmask(const ApiDumpBitmaskOption *options, uint64_t value, const ApiDumpSettings &settings) {
+    dump_binary_tag(ApiDumpBinaryTag::Bitmask, settings.stream());
+    dump_binary_varint(value, settings.stream());
+    for (const ApiDumpBitmaskOption *option = options; option->name != NULL; ++option) {
+        if (dump_bitmask_option_set(*option, value)) dump_binary_name(option->name, settings.stream());
+    }
+    dump_binary_name(NULL, settings.stream());
+    return settings.stream();
+}
+
+template <typename T>
+inline std::ostream &dump_binary_scalar(T object, const ApiDumpSettings &settings) {
+    if (std::is_floating_point<T>::value) {
+        dump_binary_tag(ApiDumpBinaryTag::Float, settings.stream());
+        dump_binary_double((double)object, settings.stream());
+    } else if (std::is_signed<T>::value) {
+        dump_binary_tag(ApiDumpBinaryTag::Int, settings.stream());
+        dump_binary_svarint((int64_t)object, settings.stream());
+    } else {
+        dump_binary_tag(ApiDumpBinaryTag::Uint, settings.stream());
+        dump_binary_varint((uint64_t)object, settings.stream());
+    }
+    return settings.stream();
+}
+
+template <typename T>
+inline std::ostream &dump_binary_scalar(T *object, const ApiDumpSettings &settings) {
+    dump_binary_tag(ApiDumpBinaryTag::Pointer, settings.stream());
+    dump_binary_varint(settings.showAddress() ? (uint64_t)(uintptr_t)object : 0, settings.stream());
+    return settings.stream();
+}
+
+inline std::ostream &dump_binary_cstring(const char *object, const ApiDumpSettings &settings) {
+    if (object == NULL) {
+        dump_binary_tag(ApiDumpBinaryTag::Null, settings.stream());
+    } else {
+        dump_binary_tag(ApiDumpBinaryTag::String, settings.stream());
+        dump_binary_text(object, strlen(object), settings.stream());
+    }
+    return settings.stream();
+}
+
+inline std::ostream &dump_binary_void(const void *object, const ApiDumpSettings &settings) {
+    if (object == NULL) {
+        dump_binary_tag(ApiDumpBinaryTag::Null, settings.stream());
+        return settings.stream();
+    }
+    return dump_binary_scalar(object, settings);
+}
+
+inline std::ostream &dump_binary_int(int object, const ApiDumpSettings &settings) { return dump_binary_scalar(object, settings); }
+
+std::ostream &dump_binary_type(uint32_t type_id, const void *object, const ApiDumpSettings &settings);
+std::ostream &dump_binary_pNext_trampoline(const void *object, const ApiDumpSettings &settings);
+
+inline void dump_binary_typed_value(uint32_t type_id, const void *object, const void *pObject, const ApiDumpSettings &settings,
+                                    const char *type_string, const char *name) {
+    // Structs and unions are passed by reference, so their address is known even for members
+    if (pObject == NULL && api_dump_types[type_id].kind != ApiDumpTypeKind::Value) pObject = object;
+    dump_binary_node(pObject, settings, type_string, name);
+    dump_binary_type(type_id, object, settings);
+}
+
+// Array elements are written without a node, and payloads as the pointer to them, the same way the
+// generated dump functions do.
+inline std::ostream &dump_binary_struct(const ApiDumpMemberInfo *members, const void *object, const ApiDumpSettings &settings) {
+    dump_binary_tag(ApiDumpBinaryTag::Struct, settings.stream());
+    for (const ApiDumpMemberInfo *member = members; member->name != NULL; ++member) {
+        const char *field = static_cast<const char *>(object) + member->offset;
+        if ((member->flags & API_DUMP_MEMBER_PNEXT) && *reinterpret_cast<const void *const *>(field) != NULL) {
+            dump_binary_pNext_trampoline(*reinterpret_cast<const void *const *>(field), settings);
+        } else if (member->flags & API_DUMP_MEMBER_ARRAY) {
+            const char *array = static_cast<const char *>(dump_member_pointer(field, member->flags));
+            size_t count = dump_member_count(members, *member, object);
+            size_t size = api_dump_types[member->type_id].size;
+            if (!dump_binary_array_head(array, count, size, settings, member->type, member->child_type, member->name)) continue;
+            for (size_t i = 0; i < count; ++i) dump_binary_type(member->type_id, array + i * size, settings);
+        } else {
+            const void *decayed;
+            const void *value = dump_member_value(field, member->flags, decayed);
+            if (value == NULL) {
+                dump_binary_node(NULL, settings, member->type, member->name);
+                dump_binary_tag(ApiDumpBinaryTag::Null, settings.stream());
+            } else {
+                dump_binary_typed_value(member->type_id, value, member->flags & API_DUMP_MEMBER_POINTER ? value : NULL, settings,
+                                        member->type, member->name);
+            }
+        }
+    }
+    dump_binary_tag(ApiDumpBinaryTag::End, settings.stream());
+    return settings.stream();
+}
@@ -0,0 +1,552 @@
+#!/usr/bin/env python3
+
+# Python script to convert an apidump binary capture into the text, html or json output
+# that the layer writes directly. Binary captures are written when the layer's output
+# format is set to Binary, which is much cheaper for the application than formatting
+# every API call while it runs.
+#
+# Usage: api_dump_convert.py [-f text|html|json] [-o <outputfile>] <inputfile>
+#
+# Captures the layer compressed with gzip are read as they are, including those of an
+# application that exited before the capture was closed.
+# The converted output is written to stdout unless an output file is given.
+
+
+# Copyright (c) 2020 The Khronos Group Inc.
+# Copyright (c) 2020 Valve Corporation
+# Copyright (c) 2020 LunarG, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import argparse
+import html
+import json
+import struct
+import sys
+import zlib
+
+# These must match ApiDumpBinaryTag and the header flags in api_dump.h
+MAGIC = b'VKAPIDMP'
+GZIP_MAGIC = b'\x1f\x8b'
+VERSION = 1
+
+SHOW_ADDRESS = 0x1
+SHOW_THREAD_AND_FRAME = 0x2
+SHOW_TIMESTAMP = 0x4
+SHOW_PARAMS = 0x8
+
+TAG_CALL = ord('C')
+TAG_FRAME = ord('F')
+TAG_VALUE = ord('v')
+TAG_END = ord(')')
+TAG_NULL = ord('n')
+TAG_INT = ord('i')
+TAG_UINT = ord('u')
+TAG_FLOAT = ord('f')
+TAG_STRING = ord('s')
+TAG_POINTER = ord('p')
+TAG_HANDLE = ord('h')
+TAG_ENUM = ord('e')
+TAG_BITMASK = ord('b')
+TAG_STRUCT = ord('{')
+TAG_UNION = ord('U')
+TAG_ARRAY = ord('[')
+TAG_BLOB = ord('r')
+TAG_SPECIAL = ord('x')
+
+
+class Payload:
+    def __init__(self, tag, value=None, extra=None):
+        self.tag = tag
+        self.value = value
+        self.extra = extra
+
+
+class Node:
+    def __init__(self, name, type_name, address, payload):
+        self.name = name
+        self.type = type_name
+        self.address = address
+        self.payload = payload
+
+
+class Call:
+    def __init__(self, thread, frame, time, name, params, return_type):
+        self.thread = thread
+        self.frame = frame
+        self.time = time
+        self.name = name
+        self.params = params
+        self.return_type = return_type
+        self.result = None
+        self.args = []
+
+
+class Frame:
+    def __init__(self, number):
+        self.number = number
+
+
+class CaptureReader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+        self.strings = {}  # Interned strings are numbered separately for each thread
+        self.thread_strings = None
+        if data[0:8] != MAGIC:
+            raise ValueError('not an apidump binary capture')
+        self.pos = 8
+        version = self.varint()
+        if version != VERSION:
+            raise ValueError('unsupported capture version %d' % version)
+        self.flags = self.varint()
+
+    def byte(self):
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def varint(self):
+        result = 0
+        shift = 0
+        while True:
+            byte = self.byte()
+            result |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                return result
+
+    def svarint(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def text(self):
+        length = self.varint()
+        value = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return value.decode('utf-8', 'replace')
+
+    def name(self):
+        ref = self.varint()
+        if ref == 0:
+            return None
+        if ref & 1:
+            self.thread_strings[ref >> 1] = self.text()
+        return self.thread_strings[ref >> 1]
+
+    def payload(self):
+        tag = self.byte()
+        if tag == TAG_NULL:
+            return Payload(tag)
+        if tag in (TAG_UINT, TAG_POINTER):
+            return Payload(tag, self.varint())
+        if tag == TAG_INT:
+            return Payload(tag, self.svarint())
+        if tag == TAG_FLOAT:
+            value = struct.unpack('<d', self.data[self.pos:self.pos + 8])[0]
+            self.pos += 8
+            return Payload(tag, value)
+        if tag == TAG_STRING:
+            return Payload(tag, self.text())
+        if tag == TAG_BLOB:
+            length = self.varint()
+            value = self.data[self.pos:self.pos + length]
+            self.pos += length
+            return Payload(tag, value)
+        if tag == TAG_HANDLE:
+            address = self.varint()
+            return Payload(tag, address, self.text())
+        if tag == TAG_ENUM:
+            value = self.svarint()
+            return Payload(tag, value, self.name())
+        if tag == TAG_BITMASK:
+            value = self.varint()
+            options = []
+            option = self.name()
+            while option is not None:
+                options.append(option)
+                option = self.name()
+            return Payload(tag, value, options)
+        if tag in (TAG_STRUCT, TAG_UNION):
+            return Payload(tag, self.nodes())
+        if tag == TAG_ARRAY:
+            child_type = self.name()
+            element_size = self.varint()
+            count = self.varint()
+            elements = [self.payload() for i in range(count)]
+            return Payload(tag, elements, (child_type, element_size))
+        if tag == TAG_SPECIAL:
+            return Payload(tag, self.name())
+        raise ValueError('unknown value tag %r at offset %d' % (chr(tag), self.pos - 1))
+
+    def node(self):
+        name = self.name()
+        type_name = self.name()
+        address = self.varint()
+        return Node(name, type_name, address, self.payload())
+
+    def nodes(self):
+        values = []
+        while True:
+            tag = self.byte()
+            if tag == TAG_END:
+                return values
+            if tag != TAG_VALUE:
+                raise ValueError('unexpected tag %r at offset %d' % (chr(tag), self.pos - 1))
+            values.append(self.node())
+
+    def records(self):
+        while self.pos < len(self.data):
+            tag = self.byte()
+            if tag == TAG_FRAME:
+                yield Frame(self.varint())
+            elif tag == TAG_CALL:
+                thread = self.varint()
+                self.thread_strings = self.strings.setdefault(thread, {})
+                frame = self.varint()
+                time = self.varint()
+                call = Call(thread, frame, time, self.name(), self.name(), self.name())
+                if call.return_type != 'void':
+                    call.result = self.payload()
+                call.args = self.nodes()
+                yield call
+            else:
+                raise ValueError('unknown record tag %r at offset %d' % (chr(tag), self.pos - 1))
+
+
+class Formatter:
+    def __init__(self, flags):
+        self.flags = flags
+
+    def show(self, flag):
+        return (self.flags & flag) != 0
+
+    def address(self, address):
+        if not self.show(SHOW_ADDRESS):
+            return 'address'
+        if address == 0:
+            return 'NULL'
+        return '0x%x' % address
+
+    def scalar(self, payload):
+        tag = payload.tag
+        if tag == TAG_NULL:
+            return 'NULL'
+        if tag in (TAG_INT, TAG_UINT):
+            return str(payload.value)
+        if tag == TAG_FLOAT:
+            return '%g' % payload.value
+        if tag == TAG_STRING:
+            return payload.value
+        if tag == TAG_POINTER:
+            return self.address(payload.value)
+        if tag == TAG_HANDLE:
+            if not self.show(SHOW_ADDRESS):
+                return 'address'
+            text = '0x%x' % payload.value
+            if payload.extra:
+                text += ' [%s]' % payload.extra
+            return text
+        if tag == TAG_SPECIAL:
+            return payload.value
+        return ''
+
+    def enum_name(self, payload):
+        return payload.extra if payload.extra is not None else 'UNKNOWN (%d)' % payload.value
+
+    def bitmask(self, payload, separator):
+        if not payload.extra:
+            return str(payload.value)
+        return '%d%s(%s)' % (payload.value, separator, ' | '.join(payload.extra))
+
+    @staticmethod
+    def elements(node):
+        payload = node.payload
+        child_type, element_size = payload.extra
+        for i, element in enumerate(payload.value):
+            address = node.address + i * element_size if node.address else 0
+            yield i, Node(node.name, child_type, address, element)
+
+
+class TextWriter(Formatter):
+    def __init__(self, out, flags, indent_size=4, name_size=32, type_size=0):
+        Formatter.__init__(self, flags)
+        self.out = out
+        self.indent_size = indent_size
+        self.name_size = name_size
+        self.type_size = type_size
+
+    def begin(self):
+        pass
+
+    def end(self):
+        pass
+
+    def frame(self, frame):
+        pass
+
+    def value(self, payload):
+        if payload.tag == TAG_STRING:
+            return '"%s"' % payload.value
+        if payload.tag == TAG_ENUM:
+            return '%s (%d)' % (self.enum_name(payload), payload.value)
+        if payload.tag == TAG_BITMASK:
+            return self.bitmask(payload, ' ')
+        return self.scalar(payload)
+
+    def name_type(self, indents, name, type_name):
+        spaces = max(self.name_size - len(name) - 2, 0)
+        type_spaces = max(self.type_size - len(type_name), 0)
+        return '%s%s: %s%s%s = ' % (' ' * (indents * self.indent_size), name, ' ' * spaces, type_name, ' ' * type_spaces)
+
+    def node(self, node, indents):
+        out = self.out
+        payload = node.payload
+        out.write(self.name_type(indents, node.name, node.type))
+        if payload.tag in (TAG_STRUCT, TAG_UNION):
+            out.write(self.address(node.address))
+            out.write(' (Union):\n' if payload.tag == TAG_UNION else ':\n')
+            for member in payload.value:
+                self.node(member, indents + 1)
+        elif payload.tag == TAG_ARRAY:
+            out.write(self.address(node.address) + '\n')
+            for i, element in self.elements(node):
+                element.name = '%s[%d]' % (node.name, i)
+                self.node(element, indents + 1)
+        elif payload.tag == TAG_BLOB:
+            out.write(self.address(node.address) + '\n')
+            data = payload.value
+            for i in range(0, len(data), 32):
+                out.write(' '.join('%02x' % b for b in data[i:i + 32]) + ' \n')
+        else:
+            out.write(self.value(payload) + '\n')
+
+    def call(self, call):
+        out = self.out
+        header = []
+        if self.show(SHOW_THREAD_AND_FRAME):
+            header.append('Thread %d, Frame %d' % (call.thread, call.frame))
+        if self.show(SHOW_TIMESTAMP):
+            header.append('Time %d us' % call.time)
+        if header:
+            out.write(', '.join(header) + ':\n')
+        out.write('%s(%s) returns %s' % (call.name, call.params, call.return_type))
+        if call.result is not None:
+            out.write(' ' + self.value(call.result))
+        out.write(':\n')
+        for arg in call.args:
+            self.node(arg, 1)
+        out.write('\n')
+
+
+class JsonWriter(Formatter):
+    def __init__(self, out, flags):
+        Formatter.__init__(self, flags)
+        self.out = out
+        self.frames = []
+
+    def begin(self):
+        pass
+
+    def end(self):
+        json.dump(self.frames, self.out, indent=4, separators=(',', ' : '))
+        self.out.write('\n')
+
+    def frame(self, frame):
+        entry = {}
+        if self.show(SHOW_THREAD_AND_FRAME):
+            entry['frameNumber'] = str(frame.number)
+        entry['apiCalls'] = []
+        self.frames.append(entry)
+
+    def value(self, payload):
+        if payload.tag == TAG_NULL:
+            return ''
+        if payload.tag == TAG_ENUM:
+            return self.enum_name(payload)
+        if payload.tag == TAG_BITMASK:
+            return self.bitmask(payload, ' ')
+        return self.scalar(payload)
+
+    def node(self, node):
+        payload = node.payload
+        is_pnext = node.name in ('pNext', 'pUserData')
+        type_name = node.type
+        if is_pnext and 'void' not in type_name:
+            type_name += '*'
+        if payload.tag == TAG_UNION:
+            type_name += ' (Union)'
+        entry = {'type': type_name, 'name': node.name}
+        is_pointer = '*' in node.type and node.type not in ('const char*', 'const char* const')
+        if payload.tag == TAG_ARRAY:
+            entry['address'] = self.address(node.address)
+            if payload.value:
+                elements = []
+                for i, element in self.elements(node):
+                    element.name = '[%d]' % i
+                    elements.append(self.node(element))
+                entry['elements'] = elements
+            return entry
+        if payload.tag == TAG_SPECIAL and payload.value == 'UNUSED':
+            entry['address'] = 'UNUSED'
+        elif is_pnext or is_pointer or payload.tag in (TAG_BLOB, TAG_SPECIAL):
+            entry['address'] = self.address(node.address)
+        if payload.tag == TAG_NULL and (is_pnext or is_pointer):
+            return entry
+        if payload.tag in (TAG_STRUCT, TAG_UNION):
+            entry['members'] = [self.node(member) for member in payload.value]
+        elif payload.tag == TAG_BLOB:
+            entry['value'] = ' '.join('%02x' % b for b in payload.value)
+        else:
+            entry['value'] = self.value(payload)
+        return entry
+
+    def call(self, call):
+        if not self.frames:
+            self.frame(Frame(call.frame))
+        entry = {'name': call.name}
+        if self.show(SHOW_THREAD_AND_FRAME):
+            entry['thread'] = 'Thread %d' % call.thread
+        if self.show(SHOW_TIMESTAMP):
+            entry['time'] = '%d us' % call.time
+        entry['returnType'] = call.return_type
+        if call.result is not None:
+            entry['returnValue'] = self.value(call.result)
+        if self.show(SHOW_PARAMS):
+            entry['args'] = [self.node(arg) for arg in call.args]
+        self.frames[-1]['apiCalls'].append(entry)
+
+
+class HtmlWriter(Formatter):
+    STYLE = ('body {font-family: Consolas, monaco, monospace; font-size: 14px; line-height: 20px;'
+             ' color: #eee; background-color: #0b1e48;}'
+             'details>*:not(summary) {margin-left: 22px;}'
+             'summary:only-child {display: block; padding-left: 15px;}'
+             'details>summary:only-child::-webkit-details-marker {display: none; padding-left: 15px;}'
+             '.var, .type, .val {display: inline; margin: 0 6px;}'
+             '.type {color: #acf;}'
+             '.val {color: #afa; text-align: right;}'
+             '.thd {color: #888;}'
+             '.time {color: #888;}')
+
+    def __init__(self, out, flags):
+        Formatter.__init__(self, flags)
+        self.out = out
+        self.in_frame = False
+
+    def begin(self):
+        self.out.write("<!doctype html><html><head><title>Vulkan API Dump</title>"
+                       "<style type='text/css'>%s</style></head><body><h1>Vulkan API Dump</h1>" % self.STYLE)
+
+    def end(self):
+        if self.in_frame:
+            self.out.write('</details>')
+        self.out.write('</body></html>\n')
+
+    def frame(self, frame):
+        if self.in_frame:
+            self.out.write('</details>')
+        self.out.write("<details class='frm'><summary>Frame ")
+        if self.show(SHOW_THREAD_AND_FRAME):
+            self.out.write(str(frame.number))
+        self.out.write('</summary>')
+        self.in_frame = True
+
+    def value(self, payload):
+        if payload.tag == TAG_STRING:
+            return '"%s"' % payload.value
+        if payload.tag == TAG_ENUM:
+            return '%s (%d)' % (self.enum_name(payload), payload.value)
+        if payload.tag == TAG_BITMASK:
+            return self.bitmask(payload, ' ')
+        if payload.tag in (TAG_STRUCT, TAG_UNION, TAG_ARRAY, TAG_BLOB):
+            return ''
+        return self.scalar(payload)
+
+    def summary(self, name, type_name, value):
+        return ("<summary><div class='var'>%s</div><div class='type'>%s</div><div class='val'>%s</div></summary>" %
+                (html.escape(name), html.escape(type_name), html.escape(value)))
+
+    def node(self, node):
+        out = self.out
+        payload = node.payload
+        value = self.value(payload)
+        if payload.tag in (TAG_STRUCT, TAG_UNION, TAG_ARRAY, TAG_BLOB):
+            value = self.address(node.address)
+        out.write("<details class='data'>" + self.summary(node.name, node.type, value))
+        if payload.tag in (TAG_STRUCT, TAG_UNION):
+            for member in payload.value:
+                self.node(member)
+        elif payload.tag == TAG_ARRAY:
+            for i, element in self.elements(node):
+                element.name = '%s[%d]' % (node.name, i)
+                self.node(element)
+        elif payload.tag == TAG_BLOB:
+            out.write('<div>%s</div>' % ' '.join('%02x' % b for b in payload.value))
+        out.write('</details>')
+
+    def call(self, call):
+        out = self.out
+        if self.show(SHOW_THREAD_AND_FRAME):
+            out.write("<div class='thd'>Thread: %d</div>" % call.thread)
+        if self.show(SHOW_TIMESTAMP):
+            out.write("<div class='time'>Time: %d us</div>" % call.time)
+        result = self.value(call.result) if call.result is not None else ''
+        out.write("<details class='fn'>" + self.summary('%s(%s)' % (call.name, call.params), call.return_type, result))
+        for arg in call.args:
+            self.node(arg)
+        out.write('</details>\n')
+
+
+def convert(data, out, output_format):
+    reader = CaptureReader(data)
+    if output_format == 'json':
+        writer = JsonWriter(out, reader.flags)
+    elif output_format == 'html':
+        writer = HtmlWriter(out, reader.flags)
+    else:
+        writer = TextWriter(out, reader.flags)
+    writer.begin()
+    try:
+        for record in reader.records():
+            if isinstance(record, Frame):
+                writer.frame(record)
+            else:
+                writer.call(record)
+    except IndexError:
+        # The application was stopped in the middle of writing a record
+        sys.stderr.write('warning: capture is truncated, the last record was dropped\n')
+    writer.end()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert an apidump binary capture to text, html or json.')
+    parser.add_argument('-f', '--format', choices=['text', 'html', 'json'], default='text', help='output format')
+    parser.add_argument('-o', '--output', help='output file, stdout by default')
+    parser.add_argument('input', help='binary capture written by the api_dump layer')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as capture:
+        data = capture.read()
+    if data.startswith(GZIP_MAGIC):
+        # Unlike gzip.decompress, keeps what could be decompressed of a file that was never closed
+        data = zlib.decompressobj(16 + zlib.MAX_WBITS).decompress(data)
+    if args.output:
+        with open(args.output, 'w') as out:
+            convert(data, out, args.format)
+    else:
+        convert(data, sys.stdout, args.format)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+
+# Python script to merge the per-thread output of the apidump layer back into a single
+# document. When the layer's per_thread_output setting is enabled, every application
+# thread writes its API calls to a file of its own, and the output file only lists those
+# files. Each record in them carries its place in the order of all records, which this
+# script restores.
+#
+# Usage: api_dump_merge.py [-o <outputfile>] <outputfile of the layer>
+#
+# The merged output is written to stdout unless an output file is given.
+
+
+# Copyright (c) 2020 The Khronos Group Inc.
+# Copyright (c) 2020 Valve Corporation
+# Copyright (c) 2020 LunarG, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import argparse
+import os
+import sys
+
+# Must match ApiDumpThreadOutput in api_dump.h
+RECORD_MARK = b'@@ '
+
+
+class Record:
+    def __init__(self, sequence, kind, time, text):
+        self.sequence = sequence
+        self.kind = kind
+        self.time = time
+        self.text = text
+
+
+# Reads the records of one file, and the format and thread files listed in the shared file.
+def read_records(path, records, listed):
+    with open(path, 'rb') as data:
+        contents = data.read()
+    position = 0
+    while position < len(contents):
+        line_end = contents.find(b'\n', position)
+        if not contents.startswith(RECORD_MARK, position) or line_end < 0:
+            sys.stderr.write('%s: unexpected data at offset %d, ignoring the rest of the file\n' % (path, position))
+            return
+        fields = contents[position + len(RECORD_MARK):line_end].decode('utf-8').split(' ', 4)
+        position = line_end + 1
+        if fields[0] == 'format':
+            listed['format'] = fields[1]
+        elif fields[0] == 'thread':
+            listed['threads'].append(os.path.join(os.path.dirname(path), ' '.join(fields[2:])))
+        else:
+            length = int(fields[3])
+            if position + length > len(contents):
+                # The application did not exit cleanly while this record was written
+                sys.stderr.write('%s: the last record is incomplete, ignoring it\n' % path)
+                return
+            records.append(Record(int(fields[0]), fields[1], int(fields[2]), contents[position:position + length]))
+            position += length
+
+
+def merge(path, out):
+    records = []
+    listed = {'format': 'text', 'threads': []}
+    read_records(path, records, listed)
+    for thread_file in listed['threads']:
+        read_records(thread_file, records, listed)
+    records.sort(key=lambda record: record.sequence)
+
+    call_on_frame = False
+    for record in records:
+        if listed['format'] == 'json':
+            # The layer leaves the separators between json calls to be added here
+            if record.kind == 'call':
+                if call_on_frame:
+                    out.write(b',\n')
+                call_on_frame = True
+            else:
+                call_on_frame = False
+        out.write(record.text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Merge the per-thread output of the api_dump layer.')
+    parser.add_argument('-o', '--output', help='output file, stdout by default')
+    parser.add_argument('input', help='output file of the api_dump layer, which lists the files of each thread')
+    args = parser.parse_args()
+
+    if args.output:
+        with open(args.output, 'wb') as out:
+            merge(args.input, out)
+    else:
+        merge(args.input, sys.stdout.buffer)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+
+# Python script to read the segmented output of the apidump layer. When the layer's
+# segment_frames or segment_size_mb settings are set, the output is split into several
+# files at frame boundaries, next to an index file recording where each frame starts.
+# This script uses the index to list the segments, or to pull a range of frames out of
+# them as a single document, without reading the rest of the output.
+#
+# Usage: api_dump_segments.py [-l] [-b <first frame>] [-e <last frame>] [-t <thread>]
+#                             [-n <function pattern>] [-o <outputfile>] <indexfile>
+#
+# Function patterns use the syntax of the layer's functions setting. Filtering by
+# function or thread is supported for the text, json, ndjson and trace output formats.
+
+
+# Copyright (c) 2020 The Khronos Group Inc.
+# Copyright (c) 2020 Valve Corporation
+# Copyright (c) 2020 LunarG, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import argparse
+import fnmatch
+import json
+import os
+import re
+import sys
+
+FILTERED_FORMATS = ['text', 'json', 'ndjson', 'trace']
+
+
+class Segment:
+    def __init__(self, number, path):
+        self.number = number
+        self.path = path
+        self.frames = []
+        self.end = None
+
+
+class Index:
+    def __init__(self, path):
+        self.format = 'text'
+        self.segments = {}
+        self.frames = {}   # frame -> (segment, offset)
+        self.threads = {}  # frame -> {thread: (segment, offset)}
+        directory = os.path.dirname(path)
+        with open(path) as index:
+            for line in index:
+                fields = line.split()
+                if not fields:
+                    continue
+                if fields[0] == 'format':
+                    self.format = fields[1]
+                elif fields[0] == 'segment':
+                    number = int(fields[1])
+                    self.segments[number] = Segment(number, os.path.join(directory, line.split(None, 2)[2].rstrip('\n')))
+                elif fields[0] == 'frame':
+                    frame, segment, offset = int(fields[1]), int(fields[2]), int(fields[3])
+                    self.frames[frame] = (segment, offset)
+                    self.segments[segment].frames.append(frame)
+                elif fields[0] == 'thread':
+                    frame, thread, segment, offset = int(fields[1]), int(fields[2]), int(fields[3]), int(fields[4])
+                    self.threads.setdefault(frame, {})[thread] = (segment, offset)
+                elif fields[0] == 'end':
+                    self.segments[int(fields[1])].end = int(fields[2])
+
+    # The segment of a frame, and where the frame's output starts and ends in it.
+    def span(self, frame):
+        number, start = self.frames[frame]
+        segment = self.segments[number]
+        following = [self.frames[f][1] for f in segment.frames if f > frame]
+        if following:
+            end = min(following)
+        elif segment.end is not None:
+            end = segment.end
+        else:
+            # The application did not exit cleanly, the segment ends wherever the output stopped
+            end = os.path.getsize(segment.path)
+        return segment, start, end
+
+    # The output before the first frame of a segment, and after its last one.
+    def header_and_footer(self, segment):
+        with open(segment.path, 'rb') as data:
+            header = data.read(self.frames[min(segment.frames)][1]) if segment.frames else b''
+            footer = b''
+            if segment.end is not None:
+                data.seek(segment.end)
+                footer = data.read()
+        return header, footer
+
+
+def read_frame(index, frame):
+    segment, start, end = index.span(frame)
+    with open(segment.path, 'rb') as data:
+        data.seek(start)
+        return data.read(end - start)
+
+
+class FunctionFilter:
+    def __init__(self, patterns):
+        self.patterns = patterns
+        self.default = not any(not pattern.startswith('!') for pattern in patterns)
+
+    def matches(self, name):
+        result = self.default
+        for pattern in self.patterns:
+            if pattern.startswith('!'):
+                if fnmatch.fnmatchcase(name, pattern[1:]):
+                    result = False
+            elif fnmatch.fnmatchcase(name, pattern):
+                result = True
+        return result
+
+
+def filter_text(chunk, functions, thread):
+    # Every call starts on an unindented line after a blank line, its parameters are indented
+    calls = re.split(r'(?<=\n\n)(?=\S)', chunk.decode('utf-8'))
+    kept = []
+    for call in calls:
+        header = re.match(r'(?:Thread (\d+)[^\n]*:\n)?(?:[^\n]*:\n)?(vk\w+)\(', call)
+        if header is None:
+            continue
+        if thread is not None and (header.group(1) is None or int(header.group(1)) != thread):
+            continue
+        if not functions.matches(header.group(2)):
+            continue
+        kept.append(call)
+    return ''.join(kept).encode('utf-8')
+
+
+def filter_trace(chunk, functions, thread):
+    kept = []
+    for line in chunk.decode('utf-8').splitlines(True):
+        event = json.loads(line.rstrip().rstrip(','))
+        if event.get('cat') == 'vulkan':
+            if thread is not None and event.get('tid') != thread:
+                continue
+            if not functions.matches(event.get('name', '')):
+                continue
+        kept.append(line)
+    return ''.join(kept).encode('utf-8')
+
+
+def filter_ndjson(chunk, functions, thread):
+    # Every call is a line of its own, the lines without a name describe the frame
+    kept = []
+    for line in chunk.decode('utf-8').splitlines(True):
+        call = json.loads(line)
+        if 'name' in call:
+            if thread is not None and call.get('thread') != thread:
+                continue
+            if not functions.matches(call['name']):
+                continue
+        kept.append(line)
+    return ''.join(kept).encode('utf-8')
+
+
+def json_frames(chunks, functions, thread, filtered):
+    frames = []
+    for chunk in chunks:
+        text = chunk.decode('utf-8').strip().lstrip(',').strip()
+        if not text:
+            continue
+        if not filtered:
+            frames.append(text)
+            continue
+        frame = json.loads(text)
+        frame['apiCalls'] = [
+            call for call in frame.get('apiCalls', [])
+            if functions.matches(call.get('name', '')) and (thread is None or call.get('thread') == 'Thread %d' % thread)
+        ]
+        frames.append(json.dumps(frame, indent=4))
+    return frames
+
+
+def extract(index, first, last, functions, thread, out):
+    filtered = thread is not None or functions.patterns
+    if filtered and index.format not in FILTERED_FORMATS:
+        sys.exit('Filtering by function or thread is only supported for the %s output formats, not %s.' %
+                 (', '.join(FILTERED_FORMATS), index.format))
+
+    frames = sorted(f for f in index.frames if f >= first and (last is None or f <= last))
+    # The index knows which threads called into each frame
+    if thread is not None and index.threads:
+        frames = [f for f in frames if thread in index.threads.get(f, {})]
+    if not frames:
+        sys.exit('No frames in range.')
+
+    header, footer = index.header_and_footer(index.segments[index.frames[frames[0]][0]])
+    chunks = [read_frame(index, f) for f in frames]
+
+    out.write(header)
+    if index.format == 'json':
+        out.write(',\n'.join(json_frames(chunks, functions, thread, filtered)).encode('utf-8'))
+    else:
+        for chunk in chunks:
+            if filtered and index.format == 'text':
+                chunk = filter_text(chunk, functions, thread)
+            elif filtered and index.format == 'trace':
+                chunk = filter_trace(chunk, functions, thread)
+            elif filtered and index.format == 'ndjson':
+                chunk = filter_ndjson(chunk, functions, thread)
+            out.write(chunk)
+    out.write(footer)
+
+
+def list_segments(index, out):
+    for number in sorted(index.segments):
+        segment = index.segments[number]
+        size = os.path.getsize(segment.path) if os.path.exists(segment.path) else 0
+        if segment.frames:
+            frames = 'frames %d-%d' % (min(segment.frames), max(segment.frames))
+        else:
+            frames = 'no frames'
+        out.write(('%s: %s, %d bytes\n' % (segment.path, frames, size)).encode('utf-8'))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Extract frames from the segmented output of the api_dump layer.')
+    parser.add_argument('-l', '--list', action='store_true', help='list the segments and the frames they hold')
+    parser.add_argument('-b', '--begin', type=int, default=0, help='first frame to extract')
+    parser.add_argument('-e', '--end', type=int, help='last frame to extract, the last frame of the output by default')
+    parser.add_argument('-t', '--thread', type=int, help='only extract the calls of this thread')
+    parser.add_argument('-n', '--function', action='append', default=[],
+                        help='only extract the calls of functions matching this pattern, can be repeated')
+    parser.add_argument('-o', '--output', help='output file, stdout by default')
+    parser.add_argument('index', help='index file written next to the segments by the api_dump layer')
+    args = parser.parse_args()
+
+    index = Index(args.index)
+    out = open(args.output, 'wb') if args.output else sys.stdout.buffer
+    try:
+        if args.list:
+            list_segments(index, out)
+        else:
+            extract(index, args.begin, args.end, FunctionFilter(args.function), args.thread, out)
+    finally:
+        if args.output:
+            out.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+// Encodings of the binary capture format. Unsigned integers are little-endian base 128 varints,
+// signed integers are zigzag encoded first so that small negative values stay short, and doubles
+// are their 8 IEEE 754 bytes in little-endian order.
+
+inline void dump_binary_varint(uint64_t value, std::ostream &stream) {
+    char bytes[10];
+    int count = 0;
+    do {
+        bytes[count] = static_cast<char>(value & 0x7f);
+        value >>= 7;
+        if (value != 0) bytes[count] |= 0x80;
+        count++;
+    } while (value != 0);
+    stream.write(bytes, count);
+}
+
+inline void dump_binary_svarint(int64_t value, std::ostream &stream) {
+    dump_binary_varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63), stream);
+}
+
+inline void dump_binary_double(double value, std::ostream &stream) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    char bytes[8];
+    for (int i = 0; i < 8; ++i) bytes[i] = static_cast<char>((bits >> (i * 8)) & 0xff);
+    stream.write(bytes, 8);
+}
+
+inline void dump_binary_text(const char *text, size_t length, std::ostream &stream) {
+    dump_binary_varint(length, stream);
+    stream.write(text, length);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Matches text against a glob pattern, where '*' matches any run of characters and '?' matches
+// any single character.
+inline bool match_glob(const char *pattern, const char *text) {
+    const char *star = NULL;
+    const char *star_text = NULL;
+    while (*text != '\0') {
+        if (*pattern == '*') {
+            star = pattern++;
+            star_text = text;
+        } else if (*pattern == '?' || *pattern == *text) {
+            pattern++;
+            text++;
+        } else if (star != NULL) {
+            // Let the last '*' swallow one more character and try again
+            pattern = star + 1;
+            text = ++star_text;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return *pattern == '\0';
+}
+
+// Splits a comma separated list, dropping the blanks around each entry and empty entries.
+inline std::vector<std::string> split_filter_list(const std::string &list) {
+    std::vector<std::string> entries;
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        size_t first = list.find_first_not_of(" \t", start);
+        if (first < end) {
+            size_t last = list.find_last_not_of(" \t", end - 1);
+            entries.push_back(list.substr(first, last + 1 - first));
+        }
+        start = end + 1;
+    }
+    return entries;
+}
+
+class FunctionFilter {
+    struct Pattern {
+        std::string glob;
+        bool include;
+    };
+    std::vector<Pattern> patterns;
+    bool has_include = false;
+
+   public:
+    /* Parses a comma separated list of glob patterns naming the functions to dump, where a
+     * pattern starting with '!' names functions not to dump. The last pattern matching a function
+     * decides, functions matching none of them are dumped unless the list has a pattern without '!'.
+     * Valid function lists: "vkCmd*", "!vkGetFenceStatus, !vkGetQueryPoolResults", "vkCmd*, !vkCmdDraw*"
+     */
+    void parseFunctionList(const std::string &list) {
+        for (const std::string &entry : split_filter_list(list)) {
+            Pattern pattern;
+            pattern.include = entry[0] != '!';
+            pattern.glob = pattern.include ? entry : entry.substr(1);
+            has_include |= pattern.include;
+            patterns.push_back(pattern);
+        }
+    }
+
+    bool isFunctionDumped(const char *name) const {
+        bool dumped = !has_include;
+        for (const Pattern &pattern : patterns) {
+            if (match_glob(pattern.glob.c_str(), name)) dumped = pattern.include;
+        }
+        return dumped;
+    }
+
+    inline bool empty() const { return patterns.empty(); }
+};
+
+class ObjectFilter {
+    struct Pattern {
+        std::string glob;
+        uint64_t handle;
+        bool is_handle;
+        bool include;
+    };
+    std::vector<Pattern> patterns;
+    bool has_include = false;
+
+   public:
+    /* Parses a comma separated list of the objects whose calls are dumped, each either a handle
+     * value or a glob pattern matching the name the application gave the object with
+     * vkSetDebugUtilsObjectNameEXT or vkDebugMarkerSetObjectNameEXT. As for functions, a '!' in
+     * front excludes objects and the last entry matching an object decides.
+     * Valid object lists: "0x55d0c2a8f0", "ShadowPass*", "!Upload*"
+     */
+    void parseObjectList(const std::string &list) {
+        for (const std::string &entry : split_filter_list(list)) {
+            Pattern pattern;
+            pattern.include = entry[0] != '!';
+            pattern.glob = pattern.include ? entry : entry.substr(1);
+            char *end = NULL;
+            pattern.handle = strtoull(pattern.glob.c_str(), &end, 0);
+            pattern.is_handle = !pattern.glob.empty() && isdigit((unsigned char)pattern.glob[0]) && *end == '\0';
+            has_include |= pattern.include;
+            patterns.push_back(pattern);
+        }
+    }
+
+    inline bool empty() const { return patterns.empty(); }
+
+    // Takes the name of the object, NULL if it has none.
+    bool isObjectDumped(uint64_t handle, const char *name) const {
+        bool dumped = !has_include;
+        for (const Pattern &pattern : patterns) {
+            bool matches = pattern.is_handle ? pattern.handle == handle : name != NULL && match_glob(pattern.glob.c_str(), name);
+            if (matches) dumped = pattern.include;
+        }
+        return dumped;
+    }
+};
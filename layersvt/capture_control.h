@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "frame_schedule.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef ANDROID
+#include <android/log.h>
+#endif
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+enum class CaptureCommandType {
+    Start,          // Capture every frame until stopped
+    Stop,           // Capture nothing until started again
+    DumpNext,       // Capture the next frames, then stop
+    ScreenshotNow,  // Take a screenshot of the frame being presented
+    SetFilter,      // Replace the function filter of api_dump
+};
+
+struct CaptureCommand {
+    CaptureCommandType type;
+    uint64_t frames;       // For DumpNext
+    std::string argument;  // For SetFilter
+};
+
+// Lets a capture be started and stopped while the application runs, by appending commands to a control file that the
+// layer claims, reads and deletes once a frame, the same way the flight recorder of api_dump looks for its trigger
+// file. One command goes on each line:
+//
+//     start
+//     stop
+//     dump-next <N> [frames]
+//     screenshot-now
+//     set-filter <function list>
+//
+// A "%p" in the path is replaced with the id of the process, so that each process gets a control file of its own.
+// Until the first start, stop or dump-next, the frames captured are those of the layer's own frame schedule. The layer
+// calls nextFrame() once per frame, holding the lock it keeps its frame state under.
+class CaptureControl {
+   public:
+    CaptureControl(const std::string &path_pattern, const char *layer_name) : layer_name(layer_name) {
+#ifdef _WIN32
+        const std::string process_id = std::to_string(_getpid());
+#else
+        const std::string process_id = std::to_string(getpid());
+#endif
+        for (size_t i = 0; i < path_pattern.size(); ++i) {
+            if (path_pattern[i] == '%' && i + 1 < path_pattern.size() && path_pattern[i + 1] == 'p') {
+                path += process_id;
+                ++i;
+            } else {
+                path += path_pattern[i];
+            }
+        }
+        claimed_path = path + "." + process_id + ".reading";
+    }
+
+    inline const std::string &controlFile() const { return path; }
+
+    // Parses one line of the control file. Returns false for empty lines and comments without touching error.
+    static bool parseCommand(const std::string &line, CaptureCommand &command, std::string &error) {
+        std::istringstream words(line);
+        std::string name;
+        if (!(words >> name) || name[0] == '#') return false;
+
+        command.frames = 0;
+        command.argument.clear();
+        if (name == "start") {
+            command.type = CaptureCommandType::Start;
+        } else if (name == "stop") {
+            command.type = CaptureCommandType::Stop;
+        } else if (name == "screenshot-now") {
+            command.type = CaptureCommandType::ScreenshotNow;
+        } else if (name == "dump-next") {
+            command.type = CaptureCommandType::DumpNext;
+            std::string count, unit;
+            words >> count >> unit;
+            char *end = NULL;
+            command.frames = count.empty() || count[0] == '-' ? 0 : strtoull(count.c_str(), &end, 10);
+            if (command.frames == 0 || *end != '\0' || (!unit.empty() && unit != "frames" && unit != "frame")) {
+                error = "dump-next takes a number of frames: " + line;
+                return false;
+            }
+        } else if (name == "set-filter") {
+            command.type = CaptureCommandType::SetFilter;
+            std::getline(words, command.argument);
+            size_t start = command.argument.find_first_not_of(" \t");
+            command.argument = start == std::string::npos ? std::string() : command.argument.substr(start);
+        } else {
+            error = "unknown command: " + line;
+            return false;
+        }
+        std::string rest;
+        if (command.type != CaptureCommandType::SetFilter && words >> rest) {
+            error = "unexpected text after the command: " + line;
+            return false;
+        }
+        return true;
+    }
+
+    // Reads the commands written since the last frame and applies those that decide which frames are captured.
+    // Returns whether this frame is captured, given whether the layer's own schedule captures it, and leaves the
+    // commands only the layer understands in commands, in the order they were written.
+    bool nextFrame(bool scheduled, std::vector<CaptureCommand> &commands) {
+        commands.clear();
+        readCommands(commands);
+
+        size_t kept = 0;
+        for (size_t i = 0; i < commands.size(); ++i) {
+            switch (commands[i].type) {
+                case CaptureCommandType::Start:
+                    overridden = true;
+                    frames_left = FRAME_SCHEDULE_NEVER;
+                    break;
+                case CaptureCommandType::Stop:
+                    overridden = true;
+                    frames_left = 0;
+                    break;
+                case CaptureCommandType::DumpNext:
+                    overridden = true;
+                    frames_left = commands[i].frames;
+                    break;
+                default:
+                    commands[kept++] = commands[i];
+                    break;
+            }
+        }
+        commands.resize(kept);
+
+        if (!overridden) return scheduled;
+        if (frames_left == 0) return false;
+        if (frames_left != FRAME_SCHEDULE_NEVER) frames_left--;
+        return true;
+    }
+
+   private:
+    void readCommands(std::vector<CaptureCommand> &commands) {
+        // The file is claimed by renaming it, so that commands appended from now on go to a new file instead of being
+        // deleted unread. Only one rename a frame while no commands come in, the application may be presenting quickly.
+        if (rename(path.c_str(), claimed_path.c_str()) != 0) return;
+        FILE *file = fopen(claimed_path.c_str(), "r");
+        if (file == NULL) return;
+        std::string contents;
+        char buffer[256];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) contents.append(buffer, size);
+        fclose(file);
+        remove(claimed_path.c_str());
+
+        std::istringstream lines(contents);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            CaptureCommand command;
+            std::string error;
+            if (parseCommand(line, command, error)) {
+                commands.push_back(command);
+            } else if (!error.empty()) {
+#ifdef ANDROID
+                __android_log_print(ANDROID_LOG_ERROR, layer_name, "Control file %s: %s", path.c_str(), error.c_str());
+#else
+                fprintf(stderr, "%s: control file %s: %s\n", layer_name, path.c_str(), error.c_str());
+#endif
+            }
+        }
+    }
+
+    std::string path;
+    std::string claimed_path;  // Private to this process, the control file is moved there to be read
+    const char *layer_name;
+    bool overridden = false;
+    uint64_t frames_left = 0;
+};
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+
+# Python script to send commands to the api_dump and screenshot layers while the application
+# runs. When the layers are given a control file, they look for it once a frame, rename it to
+# claim it, apply the commands in it and delete it. This script appends its commands to the file
+# in a single write, so that a layer never reads half of them, and the commands of a file the
+# layer has not claimed yet are kept.
+#
+# Usage: capture_control.py [--pid <process id>] <control file> <command> [<command> ...]
+#
+# Commands, each given as one argument:
+#   start                       capture every frame from the next one on
+#   stop                        capture nothing from the next frame on
+#   "dump-next <N>"             capture the next N frames, then stop
+#   screenshot-now              take a screenshot of the next frame presented
+#   "set-filter <functions>"    replace the functions api_dump dumps, as in its functions setting
+
+
+# Copyright (c) 2020 The Khronos Group Inc.
+# Copyright (c) 2020 Valve Corporation
+# Copyright (c) 2020 LunarG, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import argparse
+import os
+import sys
+
+# Must match CaptureControl::parseCommand in capture_control.h
+COMMANDS = ['start', 'stop', 'dump-next', 'screenshot-now', 'set-filter']
+
+
+def send(path, commands):
+    text = ''.join(command + '\n' for command in commands).encode()
+    control = os.open(path, os.O_WRONLY | os.O_APPEND | os.O_CREAT, 0o644)
+    try:
+        os.write(control, text)
+    finally:
+        os.close(control)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Send commands to the control file of the api_dump or screenshot layer.')
+    parser.add_argument('--pid', help='process id to put in place of %%p in the control file path')
+    parser.add_argument('control_file', help='control file given to the layer')
+    parser.add_argument('commands', nargs='+', help='commands, such as start, stop or "dump-next 5"')
+    args = parser.parse_args()
+
+    for command in args.commands:
+        if command.split(' ', 1)[0] not in COMMANDS:
+            sys.exit('unknown command: %s' % command)
+    path = args.control_file.replace('%p', args.pid) if args.pid else args.control_file
+    send(path, args.commands)
+
+
+if __name__ == '__main__':
+    main()
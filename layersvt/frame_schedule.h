@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Returned for the next active frame once there is none
+static const uint64_t FRAME_SCHEDULE_NEVER = UINT64_MAX;
+
+// The frames a layer works on, as given by the frame list setting of the api_dump and screenshot layers: a comma
+// separated list of single frames and of ranges "S-C" or "S-C-I", where S is the first frame, C the number of frames
+// the range spans and I the interval between the frames used in it. A count of 0 leaves the range open ended, and "all"
+// stands for every frame.
+//
+// Valid schedules: "all", "2,3,5", "4-4-2", "3-6, 10-2", "100-0-10"
+
+class FrameSchedule {
+   public:
+    // Replaces the schedule with the one described by text. On error the schedule is left empty and error tells why.
+    bool parse(const std::string &text, std::string &error) {
+        frames.clear();
+        ranges.clear();
+
+        size_t position = skipSpaces(text, 0);
+        if (position == text.size()) return fail("the frame list is empty", error);
+        if (text.compare(position, 3, "all") == 0 && skipSpaces(text, position + 3) == text.size()) {
+            ranges.push_back(Range{0, FRAME_SCHEDULE_NEVER, 1});
+            return true;
+        }
+
+        while (true) {
+            uint64_t numbers[3] = {0, 0, 1};
+            size_t count = 0;
+            while (true) {
+                position = skipSpaces(text, position);
+                if (!parseNumber(text, position, numbers[count])) {
+                    static const char *const errors[] = {"expected a frame number", "expected a frame count",
+                                                         "expected a frame interval"};
+                    return fail(errors[count], error);
+                }
+                count++;
+                position = skipSpaces(text, position);
+                if (count == 3 || position == text.size() || text[position] != '-') break;
+                position++;
+            }
+
+            if (count == 1) {
+                frames.push_back(numbers[0]);
+            } else {
+                if (numbers[2] == 0) return fail("the frame interval must not be 0", error);
+                uint64_t end = FRAME_SCHEDULE_NEVER;
+                if (numbers[1] != 0 && numbers[1] < FRAME_SCHEDULE_NEVER - numbers[0]) end = numbers[0] + numbers[1];
+                if (numbers[1] == 1) {
+                    frames.push_back(numbers[0]);
+                } else {
+                    ranges.push_back(Range{numbers[0], end, numbers[2]});
+                }
+            }
+
+            if (position == text.size()) break;
+            if (text[position] != ',') return fail("expected a comma between frames", error);
+            position++;
+        }
+
+        std::sort(frames.begin(), frames.end());
+        frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+        return true;
+    }
+
+    bool empty() const { return frames.empty() && ranges.empty(); }
+
+    // The first frame from frame onwards that is in the schedule, or FRAME_SCHEDULE_NEVER if no frame after it is.
+    uint64_t nextActiveFrame(uint64_t frame) const {
+        uint64_t next = FRAME_SCHEDULE_NEVER;
+        auto single = std::lower_bound(frames.begin(), frames.end(), frame);
+        if (single != frames.end()) next = *single;
+        // Ranges are few, single frames can be many
+        for (const Range &range : ranges) {
+            uint64_t first = range.start;
+            if (first < frame) {
+                uint64_t steps = (frame - range.start + range.interval - 1) / range.interval;
+                if (steps > (FRAME_SCHEDULE_NEVER - range.start) / range.interval) continue;
+                first = range.start + steps * range.interval;
+            }
+            if (first < range.end && first < next) next = first;
+        }
+        return next;
+    }
+
+    bool isActive(uint64_t frame) const { return nextActiveFrame(frame) == frame; }
+
+   private:
+    struct Range {
+        uint64_t start;
+        uint64_t end;  // Exclusive, FRAME_SCHEDULE_NEVER for ranges without an end
+        uint64_t interval;
+    };
+
+    std::vector<uint64_t> frames;  // Sorted
+    std::vector<Range> ranges;
+
+    static size_t skipSpaces(const std::string &text, size_t position) {
+        while (position < text.size() && (text[position] == ' ' || text[position] == '\t')) position++;
+        return position;
+    }
+
+    static bool parseNumber(const std::string &text, size_t &position, uint64_t &value) {
+        size_t start = position;
+        value = 0;
+        while (position < text.size() && text[position] >= '0' && text[position] <= '9') {
+            uint64_t digit = static_cast<uint64_t>(text[position] - '0');
+            if (value > (FRAME_SCHEDULE_NEVER - 1 - digit) / 10) return false;
+            value = value * 10 + digit;
+            position++;
+        }
+        return position > start;
+    }
+
+    bool fail(const char *reason, std::string &error) {
+        frames.clear();
+        ranges.clear();
+        error = reason;
+        return false;
+    }
+};
+
+// Follows a FrameSchedule through the frames of an application, which only ever move forwards. The next frame in the
+// schedule is kept ready, so that the frames in between cost a single comparison, and other threads can read it to
+// skip work until then.
+class FrameScheduleCursor {
+   public:
+    // Starts over at the first frame of schedule
+    void reset(const FrameSchedule &schedule) { next_active.store(schedule.nextActiveFrame(0), std::memory_order_relaxed); }
+
+    // Moves on to frame, which must not come before the last one, and returns whether it is in the schedule.
+    // Only one thread at a time may advance the cursor.
+    bool advance(const FrameSchedule &schedule, uint64_t frame) {
+        uint64_t next = next_active.load(std::memory_order_relaxed);
+        if (frame < next || next == FRAME_SCHEDULE_NEVER) return false;
+        if (frame > next) {
+            next = schedule.nextActiveFrame(frame);
+            if (next != frame) {
+                next_active.store(next, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        next_active.store(schedule.nextActiveFrame(frame + 1), std::memory_order_relaxed);
+        return true;
+    }
+
+    // The next frame in the schedule that was not advanced past yet, FRAME_SCHEDULE_NEVER once the schedule is over
+    uint64_t nextActiveFrame() const { return next_active.load(std::memory_order_relaxed); }
+
+    bool done() const { return nextActiveFrame() == FRAME_SCHEDULE_NEVER; }
+
+   private:
+    std::atomic<uint64_t> next_active{FRAME_SCHEDULE_NEVER};
+};
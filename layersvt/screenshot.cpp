@@ -40,7 +40,8 @@ using namespace std;
 #include "vk_layer_extension_utils.h"
 #include "vk_layer_utils.h"
 
-#include "screenshot_parsing.h"
+#include "frame_schedule.h"
+#include "capture_control.h"
 
 #ifdef ANDROID
 
@@ -51,16 +52,19 @@ const char *env_var_frames = "debug.vulkan.screenshot";
 const char *env_var_old = env_var_frames;
 const char *env_var_format = "debug.vulkan.screenshot.format";
 const char *env_var_dir = "debug.vulkan.screenshot.dir";
+const char *env_var_control_file = "debug.vulkan.screenshot.control_file";
 #else  // Linux or Windows
 const char *env_var_old = "_VK_SCREENSHOT";
 const char *env_var_frames = "VK_SCREENSHOT_FRAMES";
 const char *env_var_format = "VK_SCREENSHOT_FORMAT";
 const char *env_var_dir = "VK_SCREENSHOT_DIR";
+const char *env_var_control_file = "VK_SCREENSHOT_CONTROL_FILE";
 #endif
 
 const char *settings_option_frames = "lunarg_screenshot.frames";
 const char *settings_option_format = "lunarg_screenshot.format";
 const char *settings_option_dir = "lunarg_screenshot.dir";
+const char *settings_option_control_file = "lunarg_screenshot.control_file";
 
 #ifdef ANDROID
 
@@ -176,57 +180,20 @@ typedef struct {
 } PhysDeviceMapStruct;
 static unordered_map<VkPhysicalDevice, PhysDeviceMapStruct *> physDeviceMap;
 
-// set: list of frames to take screenshots without duplication.
-static set<int> screenshotFrames;
+// The frames to take screenshots on
+static FrameSchedule screenshotFrames;
+
+// Follows screenshotFrames through the presented frames, done once no screenshot is left to take
+static FrameScheduleCursor screenshotCursor;
 
 // Flag indicating we have received the frame list
 static bool screenshotFramesReceived = false;
 
-// Screenshots will be generated from screenShotFrameRange's startFrame to startFrame+count-1 with skipped Interval in between.
-static FrameRange screenShotFrameRange = {false, 0, SCREEN_SHOT_FRAMES_UNLIMITED, SCREEN_SHOT_FRAMES_INTERVAL_DEFAULT};
-
-// Get maximum frame number of the frame range
-// FrameRange* pFrameRange, the specified frame rang
-// return:
-//  maximum frame number of the frame range,
-//  if it's unlimited range, the return will be SCREEN_SHOT_FRAMES_UNLIMITED
-static int getEndFrameOfRange(FrameRange *pFrameRange) {
-    int endFrameOfRange = SCREEN_SHOT_FRAMES_UNLIMITED;
-    if (pFrameRange->count != SCREEN_SHOT_FRAMES_UNLIMITED) {
-        endFrameOfRange = pFrameRange->startFrame + (pFrameRange->count - 1) * pFrameRange->interval;
-    }
-    return endFrameOfRange;
-}
+// Commands to take screenshots while the application runs, NULL without a control file
+static CaptureControl *screenshotControl = NULL;
 
-// detect if frameNumber is in the range of pFrameRange, also detect if frameNumber is a frame on which a screenshot should be
-// generated.
-// int frameNumber, the frame number.
-// FrameRange* pFrameRange, the specified frame range.
-// bool *pScreenShotFrame, if pScreenShotFrame is not nullptr, indicate(return) if frameNumber is a frame on which a screenshot
-// should be generated.
-// return:
-//  if frameNumber is in the range of pFrameRange.
-static bool isInScreenShotFrameRange(int frameNumber, FrameRange *pFrameRange, bool *pScreenShotFrame) {
-    bool inRange = false, screenShotFrame = false;
-    if (pFrameRange->valid) {
-        if (pFrameRange->count != SCREEN_SHOT_FRAMES_UNLIMITED) {
-            int endFrame = getEndFrameOfRange(pFrameRange);
-            if ((frameNumber >= pFrameRange->startFrame) &&
-                ((frameNumber <= endFrame) || (endFrame == SCREEN_SHOT_FRAMES_UNLIMITED))) {
-                inRange = true;
-            }
-        } else {
-            inRange = true;
-        }
-        if (inRange) {
-            screenShotFrame = (((frameNumber - pFrameRange->startFrame) % pFrameRange->interval) == 0);
-        }
-    }
-    if (pScreenShotFrame != nullptr) {
-        *pScreenShotFrame = screenShotFrame;
-    }
-    return inRange;
-}
+// Once no screenshot is left to take, the layer stops tracking devices, queues and swapchains
+static bool noScreenshotsLeft() { return screenshotCursor.done() && screenshotControl == NULL; }
 
 // Get users request is specific color space format required
 void readScreenShotFormatENV(void) {
@@ -296,61 +263,17 @@ void readScreenShotDir(void) {
 #endif
 }
 
-// detect if frameNumber reach or beyond the right edge for screenshot in the range.
-// return:
-//       if frameNumber is already the last screenshot frame of the range(mean no another screenshot frame number >frameNumber and
-//       just in the range)
-//       if the range is invalid, return true.
-static bool isEndOfScreenShotFrameRange(int frameNumber, FrameRange *pFrameRange) {
-    bool endOfScreenShotFrameRange = false, screenShotFrame = false;
-    if (!pFrameRange->valid) {
-        endOfScreenShotFrameRange = true;
-    } else {
-        int endFrame = getEndFrameOfRange(pFrameRange);
-        if (endFrame != SCREEN_SHOT_FRAMES_UNLIMITED) {
-            if (isInScreenShotFrameRange(frameNumber, pFrameRange, &screenShotFrame)) {
-                if ((frameNumber >= endFrame) && screenShotFrame) {
-                    endOfScreenShotFrameRange = true;
-                }
-            }
-        }
-    }
-    return endOfScreenShotFrameRange;
-}
-
-// Parse comma-separated frame list string into the set
+// Parse the frame list string into the schedule
 static void populate_frame_list(const char *vk_screenshot_frames) {
-    string spec(vk_screenshot_frames), word;
-    size_t start = 0, comma = 0;
-
-    if (!isOptionBelongToScreenShotRange(vk_screenshot_frames)) {
-        while (start < spec.size()) {
-            int frameToAdd;
-            comma = spec.find(',', start);
-            if (comma == string::npos)
-                word = string(spec, start);
-            else
-                word = string(spec, start, comma - start);
-            frameToAdd = atoi(word.c_str());
-            // Add the frame number to set, but only do it if the word
-            // started with a digit and if
-            // it's not already in the list
-            if (*(word.c_str()) >= '0' && *(word.c_str()) <= '9') {
-                screenshotFrames.insert(frameToAdd);
-            }
-            if (comma == string::npos) break;
-            start = comma + 1;
-        }
-    } else {
-        int parsingStatus = initScreenShotFrameRange(vk_screenshot_frames, &screenShotFrameRange);
-        if (parsingStatus != 0) {
+    string error;
+    if (!screenshotFrames.parse(vk_screenshot_frames, error)) {
 #ifdef ANDROID
-            __android_log_print(ANDROID_LOG_ERROR, "screenshot", "range error\n");
+        __android_log_print(ANDROID_LOG_ERROR, "screenshot", "range error: %s\n", error.c_str());
 #else
-            fprintf(stderr, "Screenshot range error\n");
+        fprintf(stderr, "Screenshot range error: %s\n", error.c_str());
 #endif
-        }
     }
+    screenshotCursor.reset(screenshotFrames);
 
     screenshotFramesReceived = true;
 }
@@ -380,6 +303,22 @@ void readScreenShotFrames(void) {
     }
 }
 
+void readScreenShotControlFile(void) {
+    if (screenshotControl != NULL) return;
+    const char *control_file = getLayerOption(settings_option_control_file);
+    const char *env_var = local_getenv(env_var_control_file);
+
+    if (env_var != NULL && strlen(env_var) > 0) {
+        screenshotControl = new CaptureControl(env_var, "screenshot");
+    } else if (control_file && *control_file) {
+        screenshotControl = new CaptureControl(control_file, "screenshot");
+    }
+
+    if (env_var != NULL) {
+        local_free_getenv(env_var);
+    }
+}
+
 static bool memory_type_from_properties(VkPhysicalDeviceMemoryProperties *memory_properties, uint32_t typeBits,
                                         VkFlags requirements_mask, uint32_t *typeIndex) {
     // Search memtypes to find first index with those properties
@@ -426,6 +365,7 @@ static void init_screenshot() {
     readScreenShotFormatENV();
     readScreenShotDir();
     readScreenShotFrames();
+    readScreenShotControlFile();
 }
 
 VkQueue getQueueForScreenshot(VkDevice device) {
@@ -1198,7 +1138,7 @@ VKAPI_ATTR void VKAPI_CALL GetDeviceQueue(VkDevice device, uint32_t queueFamilyI
 
     // Save the device queue in a map if we are taking screenshots.
     loader_platform_thread_lock_mutex(&globalLock);
-    if (screenshotFramesReceived && screenshotFrames.empty() && !screenShotFrameRange.valid) {
+    if (screenshotFramesReceived && noScreenshotsLeft()) {
         // No screenshots in the list to take
         loader_platform_thread_unlock_mutex(&globalLock);
         return;
@@ -1241,7 +1181,7 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice device, const VkSwapc
 
     // Save the swapchain in a map of we are taking screenshots.
     loader_platform_thread_lock_mutex(&globalLock);
-    if (screenshotFramesReceived && screenshotFrames.empty() && !screenShotFrameRange.valid) {
+    if (screenshotFramesReceived && noScreenshotsLeft()) {
         // No screenshots in the list to take
         loader_platform_thread_unlock_mutex(&globalLock);
         return result;
@@ -1279,7 +1219,7 @@ VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice device, VkSwapchai
 
     // Save the swapchain images in a map if we are taking screenshots
     loader_platform_thread_lock_mutex(&globalLock);
-    if (screenshotFramesReceived && screenshotFrames.empty() && !screenShotFrameRange.valid) {
+    if (screenshotFramesReceived && noScreenshotsLeft()) {
         // No screenshots in the list to take
         loader_platform_thread_unlock_mutex(&globalLock);
         return result;
@@ -1315,71 +1255,66 @@ VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice device, VkSwapchai
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR *pPresentInfo) {
-    static int frameNumber = 0;
+    static uint64_t frameNumber = 0;
     DispatchMapStruct *dispMap = get_dispatch_info((VkDevice)queue);
     assert(dispMap);
     loader_platform_thread_lock_mutex(&globalLock);
 
-    if (!screenshotFrames.empty() || screenShotFrameRange.valid) {
-        set<int>::iterator it;
-        bool inScreenShotFrames = false;
-        bool inScreenShotFrameRange = false;
-        it = screenshotFrames.find(frameNumber);
-        inScreenShotFrames = (it != screenshotFrames.end());
-        isInScreenShotFrameRange(frameNumber, &screenShotFrameRange, &inScreenShotFrameRange);
-        if ((inScreenShotFrames) || (inScreenShotFrameRange)) {
-            string fileName;
-
-            if (vk_screenshot_dir == NULL || strlen(vk_screenshot_dir) == 0) {
-                fileName = to_string(frameNumber) + ".ppm";
-            } else {
-                fileName = vk_screenshot_dir;
-                fileName += "/" + to_string(frameNumber) + ".ppm";
-            }
+    bool takeScreenshot = screenshotCursor.advance(screenshotFrames, frameNumber);
+    if (screenshotControl != NULL) {
+        vector<CaptureCommand> commands;
+        takeScreenshot = screenshotControl->nextFrame(takeScreenshot, commands);
+        for (const CaptureCommand &command : commands) {
+            if (command.type == CaptureCommandType::ScreenshotNow) takeScreenshot = true;
+        }
+    }
+    if (takeScreenshot) {
+        string fileName;
+
+        if (vk_screenshot_dir == NULL || strlen(vk_screenshot_dir) == 0) {
+            fileName = to_string(frameNumber) + ".ppm";
+        } else {
+            fileName = vk_screenshot_dir;
+            fileName += "/" + to_string(frameNumber) + ".ppm";
+        }
 #ifdef ANDROID
-            __android_log_print(ANDROID_LOG_INFO, "screenshot", "Screen capture file is: %s", fileName.c_str());
+        __android_log_print(ANDROID_LOG_INFO, "screenshot", "Screen capture file is: %s", fileName.c_str());
 #else
-            printf("Screen Capture file is: %s \n", fileName.c_str());
+        printf("Screen Capture file is: %s \n", fileName.c_str());
 #endif
 
-            VkImage image;
-            VkSwapchainKHR swapchain;
-            // We'll dump only one image: the first
-            // If there are 0 swapchains, skip taking the snapshot
-            if (pPresentInfo && pPresentInfo->swapchainCount > 0) {
-                swapchain = pPresentInfo->pSwapchains[0];
-                image = swapchainMap[swapchain]->imageList[pPresentInfo->pImageIndices[0]];
-                writePPM(fileName.c_str(), image);
-            } else {
+        VkImage image;
+        VkSwapchainKHR swapchain;
+        // We'll dump only one image: the first
+        // If there are 0 swapchains, skip taking the snapshot
+        if (pPresentInfo && pPresentInfo->swapchainCount > 0) {
+            swapchain = pPresentInfo->pSwapchains[0];
+            image = swapchainMap[swapchain]->imageList[pPresentInfo->pImageIndices[0]];
+            writePPM(fileName.c_str(), image);
+        } else {
 #ifdef ANDROID
-                __android_log_print(ANDROID_LOG_ERROR, "screenshot", "Failure - no swapchain specified\n");
+            __android_log_print(ANDROID_LOG_ERROR, "screenshot", "Failure - no swapchain specified\n");
 #else
-                fprintf(stderr, "Screenshot failure - no swapchain specified\n");
+            fprintf(stderr, "Screenshot failure - no swapchain specified\n");
 #endif
+        }
+        if (noScreenshotsLeft()) {
+            // Free all our maps since we are done with them.
+            for (auto swapchainIter = swapchainMap.begin(); swapchainIter != swapchainMap.end(); swapchainIter++) {
+                SwapchainMapStruct *swapchainMapElem = swapchainIter->second;
+                delete swapchainMapElem;
             }
-            if (inScreenShotFrames) {
-                screenshotFrames.erase(it);
+            for (auto imageIter = imageMap.begin(); imageIter != imageMap.end(); imageIter++) {
+                ImageMapStruct *imageMapElem = imageIter->second;
+                delete imageMapElem;
             }
-
-            if (screenshotFrames.empty() && isEndOfScreenShotFrameRange(frameNumber, &screenShotFrameRange)) {
-                // Free all our maps since we are done with them.
-                for (auto swapchainIter = swapchainMap.begin(); swapchainIter != swapchainMap.end(); swapchainIter++) {
-                    SwapchainMapStruct *swapchainMapElem = swapchainIter->second;
-                    delete swapchainMapElem;
-                }
-                for (auto imageIter = imageMap.begin(); imageIter != imageMap.end(); imageIter++) {
-                    ImageMapStruct *imageMapElem = imageIter->second;
-                    delete imageMapElem;
-                }
-                for (auto physDeviceIter = physDeviceMap.begin(); physDeviceIter != physDeviceMap.end(); physDeviceIter++) {
-                    PhysDeviceMapStruct *physDeviceMapElem = physDeviceIter->second;
-                    delete physDeviceMapElem;
-                }
-                swapchainMap.clear();
-                imageMap.clear();
-                physDeviceMap.clear();
-                screenShotFrameRange.valid = false;
+            for (auto physDeviceIter = physDeviceMap.begin(); physDeviceIter != physDeviceMap.end(); physDeviceIter++) {
+                PhysDeviceMapStruct *physDeviceMapElem = physDeviceIter->second;
+                delete physDeviceMapElem;
             }
+            swapchainMap.clear();
+            imageMap.clear();
+            physDeviceMap.clear();
         }
     }
     frameNumber++;
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+// A map of per-object state that threads can use concurrently. The entries are spread over a fixed
+// number of shards by the hash of their key, each with its own lock, so that threads working on
+// different objects rarely wait on each other. Values are only reached with their shard locked,
+// through update and visit, or copied out with find.
+template <typename Key, typename Value>
+class ApiDumpShardedMap {
+   public:
+    ApiDumpShardedMap() : count(0) {}
+
+    // Calls f with the value of key, which is default constructed first if it is missing.
+    template <typename F>
+    void update(const Key &key, F f) {
+        Shard &shard = shardOf(key);
+        std::lock_guard<std::mutex> lg(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            it = shard.entries.insert(std::make_pair(key, Value())).first;
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+        f(it->second);
+    }
+
+    // Calls f with the value of key and returns true, or returns false if there is none.
+    template <typename F>
+    bool visit(const Key &key, F f) {
+        if (empty()) return false;
+        Shard &shard = shardOf(key);
+        std::lock_guard<std::mutex> lg(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) return false;
+        f(it->second);
+        return true;
+    }
+
+    inline bool find(const Key &key, Value &value) {
+        return visit(key, [&value](const Value &found) { value = found; });
+    }
+
+    inline void assign(const Key &key, const Value &value) {
+        update(key, [&value](Value &entry) { entry = value; });
+    }
+
+    void erase(const Key &key) {
+        Shard &shard = shardOf(key);
+        std::lock_guard<std::mutex> lg(shard.mutex);
+        if (shard.entries.erase(key) > 0) count.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Lets lookups skip the locks while nothing has been added, like the names of objects in an
+    // application that does not name any.
+    inline bool empty() const { return count.load(std::memory_order_relaxed) == 0; }
+
+    static const size_t SHARD_BITS = 4;
+    static const size_t SHARD_COUNT = 1 << SHARD_BITS;
+
+    // Handles are often aligned addresses or small counters, the multiplication mixes their bits
+    // into the top ones that pick the shard.
+    static inline size_t shardIndex(const Key &key) {
+        uint64_t hash = (uint64_t)std::hash<Key>()(key) * 0x9e3779b97f4a7c15ULL;
+        return (size_t)(hash >> (64 - SHARD_BITS));
+    }
+
+   private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Key, Value> entries;
+    };
+
+    inline Shard &shardOf(const Key &key) { return shards[shardIndex(key)]; }
+
+    Shard shards[SHARD_COUNT];
+    std::atomic<size_t> count;
+};
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "binary_encoding.h"
+
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+template <typename Encode>
+static std::string Encoded(Encode encode) {
+    std::ostringstream stream;
+    encode(stream);
+    return stream.str();
+}
+
+static std::string Varint(uint64_t value) {
+    return Encoded([value](std::ostream &stream) { dump_binary_varint(value, stream); });
+}
+
+static std::string Svarint(int64_t value) {
+    return Encoded([value](std::ostream &stream) { dump_binary_svarint(value, stream); });
+}
+
+// Decodes a varint the way api_dump_convert.py does, returns the number of bytes read.
+static size_t DecodeVarint(const std::string &bytes, uint64_t &value) {
+    value = 0;
+    size_t i = 0;
+    for (int shift = 0; i < bytes.size(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(bytes[i++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) break;
+    }
+    return i;
+}
+
+static int64_t DecodeSvarint(const std::string &bytes) {
+    uint64_t value = 0;
+    DecodeVarint(bytes, value);
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+TEST(test_binary_encoding, varint_bytes) {
+    EXPECT_EQ(std::string("\x00", 1), Varint(0));
+    EXPECT_EQ(std::string("\x01", 1), Varint(1));
+    EXPECT_EQ(std::string("\x7f", 1), Varint(127));
+    EXPECT_EQ(std::string("\x80\x01", 2), Varint(128));
+    EXPECT_EQ(std::string("\xac\x02", 2), Varint(300));
+    EXPECT_EQ(std::string("\xff\x7f", 2), Varint(16383));
+    EXPECT_EQ(std::string("\x80\x80\x01", 3), Varint(16384));
+}
+
+TEST(test_binary_encoding, varint_max) {
+    std::string bytes = Varint(std::numeric_limits<uint64_t>::max());
+    EXPECT_EQ(10u, bytes.size());
+    EXPECT_EQ(std::string("\x01", 1), bytes.substr(9));
+
+    uint64_t value = 0;
+    EXPECT_EQ(10u, DecodeVarint(bytes, value));
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(), value);
+}
+
+TEST(test_binary_encoding, varint_round_trip) {
+    for (int shift = 0; shift < 64; ++shift) {
+        for (uint64_t offset = 0; offset < 2; ++offset) {
+            uint64_t expected = (1ull << shift) - offset;
+            std::string bytes = Varint(expected);
+            uint64_t value = 0;
+            EXPECT_EQ(bytes.size(), DecodeVarint(bytes, value));
+            EXPECT_EQ(expected, value);
+        }
+    }
+}
+
+TEST(test_binary_encoding, svarint_zigzag) {
+    EXPECT_EQ(Varint(0), Svarint(0));
+    EXPECT_EQ(Varint(1), Svarint(-1));
+    EXPECT_EQ(Varint(2), Svarint(1));
+    EXPECT_EQ(Varint(3), Svarint(-2));
+    EXPECT_EQ(Varint(4294967294ull), Svarint(2147483647));
+    EXPECT_EQ(Varint(4294967295ull), Svarint(-2147483648ll));
+    // Small negative values, like VkResult error codes, stay short
+    EXPECT_EQ(1u, Svarint(-4).size());
+}
+
+TEST(test_binary_encoding, svarint_limits) {
+    EXPECT_EQ(Varint(std::numeric_limits<uint64_t>::max() - 1), Svarint(std::numeric_limits<int64_t>::max()));
+    EXPECT_EQ(Varint(std::numeric_limits<uint64_t>::max()), Svarint(std::numeric_limits<int64_t>::min()));
+
+    const int64_t values[] = {std::numeric_limits<int64_t>::min(), -1000000, -1, 0, 1, 1000000, std::numeric_limits<int64_t>::max()};
+    for (int64_t expected : values) EXPECT_EQ(expected, DecodeSvarint(Svarint(expected)));
+}
+
+TEST(test_binary_encoding, double_little_endian) {
+    std::string bytes = Encoded([](std::ostream &stream) { dump_binary_double(1.0, stream); });
+    EXPECT_EQ(std::string("\x00\x00\x00\x00\x00\x00\xf0\x3f", 8), bytes);
+
+    bytes = Encoded([](std::ostream &stream) { dump_binary_double(-2.5, stream); });
+    EXPECT_EQ(std::string("\x00\x00\x00\x00\x00\x00\x04\xc0", 8), bytes);
+}
+
+TEST(test_binary_encoding, text_is_length_prefixed) {
+    EXPECT_EQ(std::string("\x05" "vkFoo"), Encoded([](std::ostream &stream) { dump_binary_text("vkFoo", 5, stream); }));
+    EXPECT_EQ(std::string("\x00", 1), Encoded([](std::ostream &stream) { dump_binary_text("", 0, stream); }));
+
+    std::string long_text(200, 'x');
+    std::string bytes = Encoded([&long_text](std::ostream &stream) { dump_binary_text(long_text.data(), long_text.size(), stream); });
+    EXPECT_EQ(Varint(200) + long_text, bytes);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "call_filter.h"
+
+#include <gtest/gtest.h>
+
+static ObjectFilter ParseObjects(const char *list) {
+    ObjectFilter filter;
+    filter.parseObjectList(list);
+    return filter;
+}
+
+TEST(test_call_filter, match_glob) {
+    EXPECT_TRUE(match_glob("vkCmdDraw", "vkCmdDraw"));
+    EXPECT_FALSE(match_glob("vkCmdDraw", "vkCmdDrawIndexed"));
+    EXPECT_TRUE(match_glob("vkCmd*", "vkCmdDrawIndexed"));
+    EXPECT_TRUE(match_glob("vkCmd*", "vkCmd"));
+    EXPECT_TRUE(match_glob("*Indexed", "vkCmdDrawIndexed"));
+    EXPECT_TRUE(match_glob("vk*Draw*Indirect", "vkCmdDrawIndexedIndirect"));
+    EXPECT_FALSE(match_glob("vk*Draw*Indirect", "vkCmdDrawIndirectCount"));
+    EXPECT_TRUE(match_glob("vkCmdDraw?", "vkCmdDraw2"));
+    EXPECT_FALSE(match_glob("vkCmdDraw?", "vkCmdDraw"));
+    EXPECT_TRUE(match_glob("*", ""));
+    EXPECT_FALSE(match_glob("?", ""));
+    // The '*' has to be retried after a partial match
+    EXPECT_TRUE(match_glob("*ab", "aab"));
+    EXPECT_TRUE(match_glob("a*b*c", "abxbxc"));
+}
+
+TEST(test_call_filter, split_filter_list) {
+    EXPECT_EQ(std::vector<std::string>({"vkCmd*", "!vkCmdDraw"}), split_filter_list(" vkCmd* ,\t!vkCmdDraw "));
+    EXPECT_EQ(std::vector<std::string>({"a", "b"}), split_filter_list(",a,, ,b,"));
+    EXPECT_TRUE(split_filter_list("").empty());
+    EXPECT_TRUE(split_filter_list(" , ").empty());
+}
+
+TEST(test_call_filter, function_filter) {
+    FunctionFilter filter;
+    EXPECT_TRUE(filter.empty());
+    EXPECT_TRUE(filter.isFunctionDumped("vkQueueSubmit"));
+
+    filter.parseFunctionList("vkCmd*, !vkCmdDraw*");
+    EXPECT_FALSE(filter.empty());
+    EXPECT_TRUE(filter.isFunctionDumped("vkCmdBindPipeline"));
+    EXPECT_FALSE(filter.isFunctionDumped("vkCmdDrawIndexed"));
+    EXPECT_FALSE(filter.isFunctionDumped("vkQueueSubmit"));
+}
+
+TEST(test_call_filter, function_filter_exclusions_only) {
+    FunctionFilter filter;
+    filter.parseFunctionList("!vkGetFenceStatus, !vkGetQueryPoolResults");
+    EXPECT_TRUE(filter.isFunctionDumped("vkQueueSubmit"));
+    EXPECT_FALSE(filter.isFunctionDumped("vkGetFenceStatus"));
+    EXPECT_FALSE(filter.isFunctionDumped("vkGetQueryPoolResults"));
+}
+
+TEST(test_call_filter, object_filter_empty) {
+    ObjectFilter filter = ParseObjects(" , ");
+    EXPECT_TRUE(filter.empty());
+    EXPECT_TRUE(filter.isObjectDumped(0x1234, NULL));
+    EXPECT_TRUE(filter.isObjectDumped(0x1234, "ShadowPass"));
+}
+
+TEST(test_call_filter, object_filter_handles) {
+    ObjectFilter filter = ParseObjects("0x55d0c2a8f0, 4096");
+    EXPECT_FALSE(filter.empty());
+    EXPECT_TRUE(filter.isObjectDumped(0x55d0c2a8f0ull, NULL));
+    EXPECT_TRUE(filter.isObjectDumped(4096, NULL));
+    EXPECT_FALSE(filter.isObjectDumped(0x55d0c2a8f8ull, NULL));
+    // A handle is not matched against the name
+    EXPECT_FALSE(filter.isObjectDumped(1, "4096"));
+}
+
+TEST(test_call_filter, object_filter_names) {
+    ObjectFilter filter = ParseObjects("ShadowPass*");
+    EXPECT_TRUE(filter.isObjectDumped(1, "ShadowPassCmd"));
+    EXPECT_FALSE(filter.isObjectDumped(1, "MainPassCmd"));
+    // Unnamed objects only match handles
+    EXPECT_FALSE(filter.isObjectDumped(1, NULL));
+}
+
+TEST(test_call_filter, object_filter_names_that_start_like_numbers) {
+    // Entries that do not parse as a whole number are name patterns
+    ObjectFilter filter = ParseObjects("0x12*, 3DPass");
+    EXPECT_TRUE(filter.isObjectDumped(1, "0x12ab"));
+    EXPECT_FALSE(filter.isObjectDumped(0x12, NULL));
+    EXPECT_TRUE(filter.isObjectDumped(2, "3DPass"));
+    EXPECT_FALSE(filter.isObjectDumped(3, NULL));
+}
+
+TEST(test_call_filter, object_filter_exclusions) {
+    ObjectFilter filter = ParseObjects("!Upload*, !0x20");
+    EXPECT_TRUE(filter.isObjectDumped(1, "ShadowPass"));
+    EXPECT_TRUE(filter.isObjectDumped(1, NULL));
+    EXPECT_FALSE(filter.isObjectDumped(1, "UploadQueue"));
+    EXPECT_FALSE(filter.isObjectDumped(0x20, NULL));
+    EXPECT_FALSE(filter.isObjectDumped(0x20, "ShadowPass"));
+}
+
+TEST(test_call_filter, object_filter_last_match_decides) {
+    ObjectFilter filter = ParseObjects("Shadow*, !ShadowDebug*");
+    EXPECT_TRUE(filter.isObjectDumped(1, "ShadowPass"));
+    EXPECT_FALSE(filter.isObjectDumped(1, "ShadowDebugView"));
+    EXPECT_FALSE(filter.isObjectDumped(1, "MainPass"));
+
+    filter = ParseObjects("!ShadowDebug*, Shadow*");
+    EXPECT_TRUE(filter.isObjectDumped(1, "ShadowDebugView"));
+}
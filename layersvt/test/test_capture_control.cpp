@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "capture_control.h"
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+static void WriteControlFile(const CaptureControl &control, const char *text) {
+    FILE *file = fopen(control.controlFile().c_str(), "w");
+    ASSERT_TRUE(file != NULL);
+    fputs(text, file);
+    fclose(file);
+}
+
+TEST(test_capture_control, parse_commands) {
+    CaptureCommand command;
+    std::string error;
+
+    EXPECT_TRUE(CaptureControl::parseCommand("start", command, error));
+    EXPECT_EQ(CaptureCommandType::Start, command.type);
+    EXPECT_TRUE(CaptureControl::parseCommand("  stop  ", command, error));
+    EXPECT_EQ(CaptureCommandType::Stop, command.type);
+    EXPECT_TRUE(CaptureControl::parseCommand("screenshot-now", command, error));
+    EXPECT_EQ(CaptureCommandType::ScreenshotNow, command.type);
+
+    EXPECT_TRUE(CaptureControl::parseCommand("dump-next 5", command, error));
+    EXPECT_EQ(CaptureCommandType::DumpNext, command.type);
+    EXPECT_EQ(5u, command.frames);
+    EXPECT_TRUE(CaptureControl::parseCommand("dump-next 12 frames", command, error));
+    EXPECT_EQ(12u, command.frames);
+
+    EXPECT_TRUE(CaptureControl::parseCommand("set-filter vkCmd*, !vkCmdDraw*", command, error));
+    EXPECT_EQ(CaptureCommandType::SetFilter, command.type);
+    EXPECT_STREQ("vkCmd*, !vkCmdDraw*", command.argument.c_str());
+    EXPECT_TRUE(CaptureControl::parseCommand("set-filter", command, error));
+    EXPECT_TRUE(command.argument.empty());
+
+    EXPECT_TRUE(error.empty());
+}
+
+TEST(test_capture_control, parse_skipped_lines) {
+    CaptureCommand command;
+    std::string error;
+    EXPECT_FALSE(CaptureControl::parseCommand("", command, error));
+    EXPECT_FALSE(CaptureControl::parseCommand("   ", command, error));
+    EXPECT_FALSE(CaptureControl::parseCommand("# start", command, error));
+    EXPECT_TRUE(error.empty());
+}
+
+TEST(test_capture_control, parse_invalid) {
+    const char *invalid[] = {"begin",        "dump-next",           "dump-next 0", "dump-next -2",
+                             "dump-next 3x", "dump-next 3 seconds", "stop now"};
+    for (const char *line : invalid) {
+        CaptureCommand command;
+        std::string error;
+        EXPECT_FALSE(CaptureControl::parseCommand(line, command, error)) << line;
+        EXPECT_FALSE(error.empty()) << line;
+    }
+}
+
+TEST(test_capture_control, process_id_in_path) {
+    CaptureControl control("control_%p.txt", "test");
+    const std::string &path = control.controlFile();
+    EXPECT_EQ(std::string::npos, path.find('%'));
+    EXPECT_EQ(0u, path.find("control_"));
+    EXPECT_GT(path.size(), strlen("control_.txt"));
+}
+
+TEST(test_capture_control, schedule_without_commands) {
+    CaptureControl control("test_capture_control_none.txt", "test");
+    remove(control.controlFile().c_str());
+    std::vector<CaptureCommand> commands;
+    EXPECT_TRUE(control.nextFrame(true, commands));
+    EXPECT_FALSE(control.nextFrame(false, commands));
+    EXPECT_TRUE(commands.empty());
+}
+
+TEST(test_capture_control, start_stop) {
+    CaptureControl control("test_capture_control_start.txt", "test");
+    std::vector<CaptureCommand> commands;
+
+    WriteControlFile(control, "start\n");
+    EXPECT_TRUE(control.nextFrame(false, commands));
+    EXPECT_TRUE(control.nextFrame(false, commands));
+    EXPECT_NE(0, remove(control.controlFile().c_str()));
+
+    WriteControlFile(control, "stop\r\n");
+    EXPECT_FALSE(control.nextFrame(true, commands));
+    EXPECT_FALSE(control.nextFrame(true, commands));
+}
+
+TEST(test_capture_control, dump_next) {
+    CaptureControl control("test_capture_control_dump_next.txt", "test");
+    std::vector<CaptureCommand> commands;
+
+    WriteControlFile(control, "stop\ndump-next 2 frames\n");
+    EXPECT_TRUE(control.nextFrame(false, commands));
+    EXPECT_TRUE(control.nextFrame(false, commands));
+    EXPECT_FALSE(control.nextFrame(true, commands));
+}
+
+TEST(test_capture_control, layer_commands) {
+    CaptureControl control("test_capture_control_layer.txt", "test");
+    std::vector<CaptureCommand> commands;
+
+    WriteControlFile(control, "screenshot-now\nunknown\nset-filter vkQueue*\n");
+    EXPECT_TRUE(control.nextFrame(true, commands));
+    ASSERT_EQ(2u, commands.size());
+    EXPECT_EQ(CaptureCommandType::ScreenshotNow, commands[0].type);
+    EXPECT_EQ(CaptureCommandType::SetFilter, commands[1].type);
+    EXPECT_STREQ("vkQueue*", commands[1].argument.c_str());
+
+    EXPECT_FALSE(control.nextFrame(false, commands));
+    EXPECT_TRUE(commands.empty());
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_schedule.h"
+
+#include <gtest/gtest.h>
+
+static std::vector<uint64_t> ActiveFrames(const FrameSchedule &schedule, uint64_t frame_count) {
+    std::vector<uint64_t> frames;
+    for (uint64_t frame = 0; frame < frame_count; ++frame) {
+        if (schedule.isActive(frame)) frames.push_back(frame);
+    }
+    return frames;
+}
+
+static FrameSchedule Parse(const char *text) {
+    FrameSchedule schedule;
+    std::string error;
+    EXPECT_TRUE(schedule.parse(text, error)) << text << ": " << error;
+    return schedule;
+}
+
+TEST(test_frame_schedule, single_frames) {
+    EXPECT_EQ(std::vector<uint64_t>({2, 3, 5}), ActiveFrames(Parse("2,3,5"), 10));
+    EXPECT_EQ(std::vector<uint64_t>({0}), ActiveFrames(Parse("0"), 10));
+}
+
+TEST(test_frame_schedule, single_frames_unordered) {
+    EXPECT_EQ(std::vector<uint64_t>({1, 4, 7}), ActiveFrames(Parse("7,1,4,1"), 10));
+}
+
+TEST(test_frame_schedule, range) {
+    EXPECT_EQ(std::vector<uint64_t>({20, 21, 22}), ActiveFrames(Parse("20-3"), 30));
+    EXPECT_EQ(std::vector<uint64_t>({5}), ActiveFrames(Parse("5-1"), 10));
+}
+
+TEST(test_frame_schedule, range_interval) {
+    EXPECT_EQ(std::vector<uint64_t>({4, 6}), ActiveFrames(Parse("4-4-2"), 20));
+    EXPECT_EQ(std::vector<uint64_t>({1, 4, 7}), ActiveFrames(Parse("1-7-3"), 20));
+}
+
+TEST(test_frame_schedule, open_ended) {
+    FrameSchedule schedule = Parse("100-0-10");
+    EXPECT_FALSE(schedule.isActive(99));
+    EXPECT_TRUE(schedule.isActive(100));
+    EXPECT_FALSE(schedule.isActive(105));
+    EXPECT_TRUE(schedule.isActive(1000000));
+    EXPECT_EQ(110u, schedule.nextActiveFrame(101));
+
+    EXPECT_EQ(std::vector<uint64_t>({3, 4, 5, 6}), ActiveFrames(Parse("3-0"), 7));
+}
+
+TEST(test_frame_schedule, all) {
+    FrameSchedule schedule = Parse("all");
+    EXPECT_TRUE(schedule.isActive(0));
+    EXPECT_TRUE(schedule.isActive(12345));
+}
+
+TEST(test_frame_schedule, mixed) {
+    EXPECT_EQ(std::vector<uint64_t>({1, 3, 4, 5, 6, 7, 8, 10, 11}), ActiveFrames(Parse("3-6, 10-2,1"), 20));
+    EXPECT_EQ(std::vector<uint64_t>({0, 2, 4, 5, 6}), ActiveFrames(Parse(" 0-6-2 , 5-2 "), 20));
+}
+
+TEST(test_frame_schedule, next_active_frame) {
+    FrameSchedule schedule = Parse("2,8-3-2");
+    EXPECT_EQ(2u, schedule.nextActiveFrame(0));
+    EXPECT_EQ(2u, schedule.nextActiveFrame(2));
+    EXPECT_EQ(8u, schedule.nextActiveFrame(3));
+    EXPECT_EQ(10u, schedule.nextActiveFrame(9));
+    EXPECT_EQ(FRAME_SCHEDULE_NEVER, schedule.nextActiveFrame(11));
+}
+
+TEST(test_frame_schedule, invalid) {
+    const char *invalid[] = {"", "  ", "a", "1-", "1-2-", "-1", "1,,2", "1,", "1-2-0", "1-2-3-4", "1 2", "al", "all,1",
+                             "99999999999999999999"};
+    for (const char *text : invalid) {
+        FrameSchedule schedule;
+        std::string error;
+        EXPECT_FALSE(schedule.parse(text, error)) << text;
+        EXPECT_FALSE(error.empty()) << text;
+        EXPECT_TRUE(schedule.empty()) << text;
+    }
+}
+
+TEST(test_frame_schedule, parse_replaces) {
+    FrameSchedule schedule = Parse("1,2");
+    std::string error;
+    EXPECT_TRUE(schedule.parse("5", error));
+    EXPECT_EQ(std::vector<uint64_t>({5}), ActiveFrames(schedule, 10));
+}
+
+TEST(test_frame_schedule, cursor) {
+    FrameSchedule schedule = Parse("2,5-4-2");
+    FrameScheduleCursor cursor;
+    EXPECT_TRUE(cursor.done());
+
+    cursor.reset(schedule);
+    EXPECT_EQ(2u, cursor.nextActiveFrame());
+    std::vector<uint64_t> frames;
+    for (uint64_t frame = 0; frame < 10; ++frame) {
+        if (cursor.advance(schedule, frame)) frames.push_back(frame);
+    }
+    EXPECT_EQ(std::vector<uint64_t>({2, 5, 7}), frames);
+    EXPECT_TRUE(cursor.done());
+}
+
+TEST(test_frame_schedule, cursor_skipped_frames) {
+    FrameSchedule schedule = Parse("0-0-10");
+    FrameScheduleCursor cursor;
+    cursor.reset(schedule);
+    EXPECT_TRUE(cursor.advance(schedule, 0));
+    EXPECT_EQ(10u, cursor.nextActiveFrame());
+    EXPECT_FALSE(cursor.advance(schedule, 15));
+    EXPECT_EQ(20u, cursor.nextActiveFrame());
+    EXPECT_TRUE(cursor.advance(schedule, 20));
+    EXPECT_FALSE(cursor.done());
+}
+
+TEST(test_frame_schedule, cursor_done_after_last_frame) {
+    FrameSchedule schedule = Parse("3");
+    FrameScheduleCursor cursor;
+    cursor.reset(schedule);
+    EXPECT_FALSE(cursor.advance(schedule, 1));
+    EXPECT_FALSE(cursor.done());
+    EXPECT_TRUE(cursor.advance(schedule, 3));
+    EXPECT_TRUE(cursor.done());
+    EXPECT_FALSE(cursor.advance(schedule, 4));
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2015-2021 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sharded_map.h"
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+typedef ApiDumpShardedMap<uint64_t, uint64_t> CounterMap;
+
+TEST(test_sharded_map, empty_map_finds_nothing) {
+    CounterMap map;
+    EXPECT_TRUE(map.empty());
+
+    uint64_t value = 7;
+    EXPECT_FALSE(map.find(1, value));
+    EXPECT_EQ(7u, value);
+
+    bool visited = false;
+    EXPECT_FALSE(map.visit(1, [&visited](uint64_t &) { visited = true; }));
+    EXPECT_FALSE(visited);
+}
+
+TEST(test_sharded_map, update_inserts_default_value) {
+    ApiDumpShardedMap<uint64_t, std::string> map;
+    map.update(42, [](std::string &value) {
+        EXPECT_TRUE(value.empty());
+        value = "swapchain";
+    });
+    EXPECT_FALSE(map.empty());
+
+    std::string name;
+    EXPECT_TRUE(map.find(42, name));
+    EXPECT_EQ("swapchain", name);
+    EXPECT_FALSE(map.find(43, name));
+}
+
+TEST(test_sharded_map, update_changes_existing_value) {
+    CounterMap map;
+    for (int i = 0; i < 3; ++i) map.update(5, [](uint64_t &value) { value++; });
+
+    uint64_t value = 0;
+    EXPECT_TRUE(map.find(5, value));
+    EXPECT_EQ(3u, value);
+}
+
+TEST(test_sharded_map, visit_changes_value_in_place) {
+    CounterMap map;
+    map.assign(9, 10);
+    EXPECT_TRUE(map.visit(9, [](uint64_t &value) { value *= 2; }));
+
+    uint64_t value = 0;
+    EXPECT_TRUE(map.find(9, value));
+    EXPECT_EQ(20u, value);
+    EXPECT_FALSE(map.visit(10, [](uint64_t &value) { value = 0; }));
+}
+
+TEST(test_sharded_map, assign_replaces_value) {
+    CounterMap map;
+    map.assign(1, 100);
+    map.assign(1, 200);
+
+    uint64_t value = 0;
+    EXPECT_TRUE(map.find(1, value));
+    EXPECT_EQ(200u, value);
+}
+
+TEST(test_sharded_map, erase_empties_map) {
+    CounterMap map;
+    map.assign(1, 1);
+    map.assign(2, 2);
+    map.erase(1);
+    EXPECT_FALSE(map.empty());
+
+    uint64_t value = 0;
+    EXPECT_FALSE(map.find(1, value));
+    EXPECT_TRUE(map.find(2, value));
+
+    // Erasing a missing key must not throw off the count behind empty()
+    map.erase(1);
+    map.erase(3);
+    EXPECT_FALSE(map.empty());
+    map.erase(2);
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.find(2, value));
+}
+
+TEST(test_sharded_map, shard_index_in_range) {
+    const size_t shard_count = CounterMap::SHARD_COUNT;
+    for (uint64_t key = 0; key < 1000; ++key) {
+        EXPECT_LT(CounterMap::shardIndex(key), shard_count);
+        EXPECT_EQ(CounterMap::shardIndex(key), CounterMap::shardIndex(key));
+    }
+}
+
+TEST(test_sharded_map, shard_index_spreads_handles) {
+    const size_t shard_count = CounterMap::SHARD_COUNT;
+
+    // Small counters, as handed out by some drivers for non-dispatchable handles
+    std::set<size_t> counter_shards;
+    for (uint64_t key = 1; key <= 64; ++key) counter_shards.insert(CounterMap::shardIndex(key));
+    EXPECT_GT(counter_shards.size(), shard_count / 2);
+
+    // Aligned addresses, as used for dispatchable handles
+    std::set<size_t> address_shards;
+    for (uint64_t key = 0; key < 64; ++key) address_shards.insert(CounterMap::shardIndex(0x55d0c2a8f000ull + key * 256));
+    EXPECT_GT(address_shards.size(), shard_count / 2);
+}
+
+TEST(test_sharded_map, concurrent_updates) {
+    CounterMap map;
+    const uint64_t thread_count = 8;
+    const uint64_t key_count = 64;
+    const uint64_t rounds = 1000;
+
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < thread_count; ++t) {
+        threads.push_back(std::thread([&map, key_count, rounds]() {
+            for (uint64_t round = 0; round < rounds; ++round) {
+                for (uint64_t key = 0; key < key_count; ++key) map.update(key, [](uint64_t &value) { value++; });
+            }
+        }));
+    }
+    for (std::thread &thread : threads) thread.join();
+
+    for (uint64_t key = 0; key < key_count; ++key) {
+        uint64_t value = 0;
+        EXPECT_TRUE(map.find(key, value));
+        EXPECT_EQ(thread_count * rounds, value);
+    }
+}
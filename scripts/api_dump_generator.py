@@ -37,6 +37,10 @@
 #   * api_dump_text.h: TEXT_CODEGEN - Provides the back end for dumping to a text file
 #   * api_dump_html.h: HTML_CODEGEN - Provides the back end for dumping to a html document
 #   * api_dump_json.h: JSON_CODEGEN - Provides the back end for dumping to a JSON file
+#   * api_dump_binary.h: BINARY_CODEGEN - Provides the back end for writing binary captures
+#   * api_dump_trace.h: TRACE_CODEGEN - Provides the back end for writing Chrome trace events
+#   * api_dump_tables.h: TABLES_CODEGEN - Provides the tables of enum and bitmask options, and of struct
+#       members, that all of the back ends share
 #
 
 import os,re,sys,string
@@ -75,14 +79,31 @@ COMMON_CODEGEN = """
 #include "api_dump_text.h"
 #include "api_dump_html.h"
 #include "api_dump_json.h"
+#include "api_dump_binary.h"
+#include "api_dump_trace.h"
+
+//============================== Function Ids ===============================//
+
+enum ApiDumpFunctionId : uint32_t {{
+@foreach function
+    API_DUMP_FUNCTION_{funcName},
+@end function
+}};
+
+const char *const api_dump_function_names[] = {{
+@foreach function
+    "{funcName}",
+@end function
+    NULL
+}};
 
 //============================= Dump Functions ==============================//
 
 @foreach function where(not '{funcName}' in ['vkGetDeviceProcAddr', 'vkGetInstanceProcAddr', 'vkDebugMarkerSetObjectNameEXT','vkSetDebugUtilsObjectNameEXT'])
 inline void dump_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
 {{
-    if (!dump_inst.shouldDumpOutput()) return ;
-    dump_inst.outputMutex()->lock();
+    if (!dump_inst.decideCall(API_DUMP_FUNCTION_{funcName}, {funcDispatchHandle})) return;
+    dump_inst.beginRecord();
     switch(dump_inst.settings().format())
     {{
     case ApiDumpFormat::Text:
@@ -94,38 +115,61 @@ inline void dump_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
     case ApiDumpFormat::Json:
         dump_json_head_{funcName}(dump_inst, {funcNamedParams});
         break;
+    case ApiDumpFormat::Binary:
+        dump_binary_head_{funcName}(dump_inst, {funcNamedParams});
+        break;
+    case ApiDumpFormat::Stats:
+        dump_inst.callStats().beginCall();
+        break;
+    case ApiDumpFormat::Trace:
+        dump_trace_head_{funcName}(dump_inst, {funcNamedParams});
+        break;
     }}
-    //Keep lock
+    //Keep the record open
 }}
 @end function
 
 @foreach function where('{funcReturn}' != 'void' and not '{funcName}' in ['vkGetDeviceProcAddr', 'vkGetInstanceProcAddr', 'vkDebugMarkerSetObjectNameEXT','vkSetDebugUtilsObjectNameEXT'])
 inline void dump_body_{funcName}(ApiDumpInstance& dump_inst, {funcReturn} result, {funcTypedParams})
 {{
-    if (!dump_inst.shouldDumpOutput()) return;
-
-    //Lock is already held
-    switch(dump_inst.settings().format())
-    {{
-    case ApiDumpFormat::Text:
-        dump_text_body_{funcName}(dump_inst, result, {funcNamedParams});
-        break;
-    case ApiDumpFormat::Html:
-        dump_html_body_{funcName}(dump_inst, result, {funcNamedParams});
-        break;
-    case ApiDumpFormat::Json:
-        dump_json_body_{funcName}(dump_inst, result, {funcNamedParams});
-        break;
+    if (dump_inst.wasCallDumped()) {{
+        //Record is already open
+        dump_inst.beginRecordBody(API_DUMP_FUNCTION_{funcName}, {funcCommandBuffer});
+        switch(dump_inst.settings().format())
+        {{
+        case ApiDumpFormat::Text:
+            dump_text_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
+        case ApiDumpFormat::Html:
+            dump_html_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
+        case ApiDumpFormat::Json:
+            dump_json_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
+        case ApiDumpFormat::Binary:
+            dump_binary_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
+        case ApiDumpFormat::Stats:
+            dump_inst.callStats().endCall(API_DUMP_FUNCTION_{funcName});
+            break;
+        case ApiDumpFormat::Trace:
+            dump_trace_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
+        }}
+        dump_inst.endRecord();
     }}
-    dump_inst.outputMutex()->unlock();
+    @if('{funcReturn}' == 'VkResult')
+    dump_inst.checkResult(result);
+    @end if
 }}
 @end function
 
 @foreach function where('{funcReturn}' == 'void')
 inline void dump_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
 {{
-    if (!dump_inst.shouldDumpOutput()) return ;
-    //Lock is already held
+    if (!dump_inst.wasCallDumped()) return;
+    //Record is already open
+    dump_inst.beginRecordBody(API_DUMP_FUNCTION_{funcName}, {funcCommandBuffer});
     switch(dump_inst.settings().format())
     {{
     case ApiDumpFormat::Text:
@@ -137,8 +181,17 @@ inline void dump_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
     case ApiDumpFormat::Json:
         dump_json_body_{funcName}(dump_inst, {funcNamedParams});
         break;
+    case ApiDumpFormat::Binary:
+        dump_binary_body_{funcName}(dump_inst, {funcNamedParams});
+        break;
+    case ApiDumpFormat::Stats:
+        dump_inst.callStats().endCall(API_DUMP_FUNCTION_{funcName});
+        break;
+    case ApiDumpFormat::Trace:
+        dump_trace_body_{funcName}(dump_inst, {funcNamedParams});
+        break;
     }}
-    dump_inst.outputMutex()->unlock();
+    dump_inst.endRecord();
 }}
 @end function
 
@@ -146,18 +199,10 @@ inline void dump_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
 @foreach function where('{funcName}' == 'vkDebugMarkerSetObjectNameEXT')
 inline void dump_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
 {{
-    dump_inst.outputMutex()->lock();
-
-    if (pNameInfo->pObjectName)
-    {{
-        dump_inst.object_name_map.insert(std::make_pair<uint64_t, std::string>((uint64_t &&)pNameInfo->object, pNameInfo->pObjectName));
-    }}
-    else
-    {{
-        dump_inst.object_name_map.erase(pNameInfo->object);
-    }}
+    dump_inst.setObjectName((uint64_t)pNameInfo->object, pNameInfo->pObjectName);
 
-    if (dump_inst.shouldDumpOutput()) {{
+    if (dump_inst.decideCall(API_DUMP_FUNCTION_{funcName}, {funcDispatchHandle})) {{
+        dump_inst.beginRecord();
         switch(dump_inst.settings().format())
         {{
         case ApiDumpFormat::Text:
@@ -169,18 +214,28 @@ inline void dump_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
         case ApiDumpFormat::Json:
             dump_json_head_{funcName}(dump_inst, {funcNamedParams});
             break;
+        case ApiDumpFormat::Binary:
+            dump_binary_head_{funcName}(dump_inst, {funcNamedParams});
+            break;
+        case ApiDumpFormat::Stats:
+            dump_inst.callStats().beginCall();
+            break;
+        case ApiDumpFormat::Trace:
+            dump_trace_head_{funcName}(dump_inst, {funcNamedParams});
+            break;
         }}
     }}
 
-    //Keep lock
+    //Keep the record open
 }}
 @end function
 
 @foreach function where('{funcName}' == 'vkDebugMarkerSetObjectNameEXT')
 inline void dump_body_{funcName}(ApiDumpInstance& dump_inst, {funcReturn} result, {funcTypedParams})
 {{
-    //Lock is already held
-    if (dump_inst.shouldDumpOutput()) {{
+    //Record is already open
+    if (dump_inst.wasCallDumped()) {{
+        dump_inst.beginRecordBody(API_DUMP_FUNCTION_{funcName}, {funcCommandBuffer});
         switch(dump_inst.settings().format())
         {{
         case ApiDumpFormat::Text:
@@ -192,26 +247,29 @@ inline void dump_body_{funcName}(ApiDumpInstance& dump_inst, {funcReturn} result
         case ApiDumpFormat::Json:
             dump_json_body_{funcName}(dump_inst, result, {funcNamedParams});
             break;
+        case ApiDumpFormat::Binary:
+            dump_binary_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
+        case ApiDumpFormat::Stats:
+            dump_inst.callStats().endCall(API_DUMP_FUNCTION_{funcName});
+            break;
+        case ApiDumpFormat::Trace:
+            dump_trace_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
         }}
+        dump_inst.endRecord();
     }}
-
-    dump_inst.outputMutex()->unlock();
+    dump_inst.checkResult(result);
 }}
 @end function
 
 @foreach function where('{funcName}' == 'vkSetDebugUtilsObjectNameEXT')
 inline void dump_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
 {{
-    dump_inst.outputMutex()->lock();
-    if (pNameInfo->pObjectName)
-    {{
-        dump_inst.object_name_map.insert(std::make_pair<uint64_t, std::string>((uint64_t &&)pNameInfo->objectHandle, pNameInfo->pObjectName));
-    }}
-    else
-    {{
-        dump_inst.object_name_map.erase(pNameInfo->objectHandle);
-    }}
-    if (dump_inst.shouldDumpOutput()) {{
+    dump_inst.setObjectName((uint64_t)pNameInfo->objectHandle, pNameInfo->pObjectName);
+
+    if (dump_inst.decideCall(API_DUMP_FUNCTION_{funcName}, {funcDispatchHandle})) {{
+        dump_inst.beginRecord();
         switch(dump_inst.settings().format())
         {{
         case ApiDumpFormat::Text:
@@ -223,17 +281,27 @@ inline void dump_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
         case ApiDumpFormat::Json:
             dump_json_head_{funcName}(dump_inst, {funcNamedParams});
             break;
+        case ApiDumpFormat::Binary:
+            dump_binary_head_{funcName}(dump_inst, {funcNamedParams});
+            break;
+        case ApiDumpFormat::Stats:
+            dump_inst.callStats().beginCall();
+            break;
+        case ApiDumpFormat::Trace:
+            dump_trace_head_{funcName}(dump_inst, {funcNamedParams});
+            break;
         }}
     }}
-    //Keep lock
+    //Keep the record open
 }}
 @end function
 
 @foreach function where('{funcName}' == 'vkSetDebugUtilsObjectNameEXT')
 inline void dump_body_{funcName}(ApiDumpInstance& dump_inst, {funcReturn} result, {funcTypedParams})
 {{
-    //Lock is already held
-    if (dump_inst.shouldDumpOutput()) {{
+    //Record is already open
+    if (dump_inst.wasCallDumped()) {{
+        dump_inst.beginRecordBody(API_DUMP_FUNCTION_{funcName}, {funcCommandBuffer});
         switch(dump_inst.settings().format())
         {{
         case ApiDumpFormat::Text:
@@ -245,9 +313,19 @@ inline void dump_body_{funcName}(ApiDumpInstance& dump_inst, {funcReturn} result
         case ApiDumpFormat::Json:
             dump_json_body_{funcName}(dump_inst, result, {funcNamedParams});
             break;
+        case ApiDumpFormat::Binary:
+            dump_binary_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
+        case ApiDumpFormat::Stats:
+            dump_inst.callStats().endCall(API_DUMP_FUNCTION_{funcName});
+            break;
+        case ApiDumpFormat::Trace:
+            dump_trace_body_{funcName}(dump_inst, result, {funcNamedParams});
+            break;
         }}
+        dump_inst.endRecord();
     }}
-    dump_inst.outputMutex()->unlock();
+    dump_inst.checkResult(result);
 }}
 @end function
 
@@ -382,7 +460,10 @@ VK_LAYER_EXPORT VKAPI_ATTR {funcReturn} VKAPI_CALL {funcName}({funcTypedParams})
 @foreach function where('{funcName}' == 'vkQueuePresentKHR')
 VK_LAYER_EXPORT VKAPI_ATTR {funcReturn} VKAPI_CALL {funcName}({funcTypedParams})
 {{
-    ApiDumpInstance::current().outputMutex()->lock();
+    // Synchronous output keeps the present and the start of the next frame together. The writer
+    // thread orders asynchronous output, so there is no need to block other threads here.
+    const bool serialize_frame = !ApiDumpInstance::current().settings().writesRecordsOnCompletion();
+    if (serialize_frame) ApiDumpInstance::current().outputMutex()->lock();
     dump_head_{funcName}(ApiDumpInstance::current(), {funcNamedParams});
 
     {funcReturn} result = device_dispatch_table({funcDispatchParam})->{funcShortName}({funcNamedParams});
@@ -390,7 +471,7 @@ VK_LAYER_EXPORT VKAPI_ATTR {funcReturn} VKAPI_CALL {funcName}({funcTypedParams})
     dump_body_{funcName}(ApiDumpInstance::current(), result, {funcNamedParams});
 
     ApiDumpInstance::current().nextFrame();
-    ApiDumpInstance::current().outputMutex()->unlock();
+    if (serialize_frame) ApiDumpInstance::current().outputMutex()->unlock();
     return result;
 }}
 @end function
@@ -472,12 +553,27 @@ VK_LAYER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceToolProperties
     return result;
 }}
 
+VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char* pName);
+VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, const char* pName);
+
+// Sorted by name, for find_proc_address
+static const ApiDumpProcEntry instance_procs[] = {{
+@foreach function where('{funcType}' == 'instance'  and '{funcName}' not in [ 'vkEnumerateDeviceExtensionProperties' ])
+    {{ "{funcName}", reinterpret_cast<PFN_vkVoidFunction>({funcName}) }},
+@end function
+}};
+
+static const ApiDumpProcEntry device_procs[] = {{
+@foreach function where('{funcType}' == 'device')
+    {{ "{funcName}", reinterpret_cast<PFN_vkVoidFunction>({funcName}) }},
+@end function
+}};
+
 VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char* pName)
 {{
-    @foreach function where('{funcType}' == 'instance'  and '{funcName}' not in [ 'vkEnumerateDeviceExtensionProperties' ])
-    if(strcmp(pName, "{funcName}") == 0)
-        return reinterpret_cast<PFN_vkVoidFunction>({funcName});
-    @end function
+    PFN_vkVoidFunction proc = find_proc_address(instance_procs, pName);
+    if(proc != NULL)
+        return proc;
 
     if(instance_dispatch_table(instance)->GetInstanceProcAddr == NULL)
         return NULL;
@@ -486,10 +582,9 @@ VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(V
 
 VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, const char* pName)
 {{
-    @foreach function where('{funcType}' == 'device')
-    if(strcmp(pName, "{funcName}") == 0)
-        return reinterpret_cast<PFN_vkVoidFunction>({funcName});
-    @end function
+    PFN_vkVoidFunction proc = find_proc_address(device_procs, pName);
+    if(proc != NULL)
+        return proc;
 
     if(device_dispatch_table(device)->GetDeviceProcAddr == NULL)
         return NULL;
@@ -497,6 +592,89 @@ VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkD
 }}
 """
 
+TABLES_CODEGEN = """
+/* Copyright (c) 2015-2020 Valve Corporation
+ * Copyright (c) 2015-2020 LunarG, Inc.
+ * Copyright (c) 2015-2017, 2019 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Lenny Komow <lenny@lunarg.com>
+ * Author: Shannon McPherson <shannon@lunarg.com>
+ * Author: Charles Giessen <charles@lunarg.com>
+ */
+
+/*
+ * This file is generated from the Khronos Vulkan XML API Registry.
+ */
+
+#pragma once
+
+#include "api_dump.h"
+
+//=============================== Enum Tables ===============================//
+
+@foreach enum
+static const ApiDumpEnumOption API_DUMP_OPTIONS_{enumName}[] = {{
+    @foreach option
+    {{{optValue}, "{optName}"}},
+    @end option
+    {{0, NULL}}
+}};
+@end enum
+
+//============================== Bitmask Tables =============================//
+
+@foreach bitmask
+static const ApiDumpBitmaskOption API_DUMP_OPTIONS_{bitName}[] = {{
+    @foreach option
+        @if('{optMultiValue}' != 'None')
+    {{{optValue}, "{optName}", true}},
+        @end if
+        @if('{optMultiValue}' == 'None')
+    {{{optValue}, "{optName}", false}},
+        @end if
+    @end option
+    {{0, NULL, false}}
+}};
+@end bitmask
+
+//=============================== Member Types ==============================//
+
+enum ApiDumpTypeId : uint16_t {{
+@foreach membertype
+    API_DUMP_TYPE_{mtyName},
+@end membertype
+}};
+
+const ApiDumpTypeInfo api_dump_types[] = {{
+@foreach membertype
+    {{sizeof({mtyBaseType}), ApiDumpTypeKind::{mtyKind}}},
+@end membertype
+}};
+
+//=============================== Member Tables =============================//
+
+@foreach struct where({sctTable})
+static const ApiDumpMemberInfo API_DUMP_MEMBERS_{sctName}[] = {{
+    @foreach member
+    {{"{memName}", "{memType}", {memTableChildType}, offsetof({sctName}, {memName}), {memTableCount}, API_DUMP_TYPE_{memTypeID}, {memTableCountMember}, {memTableFlags}}},
+    @end member
+    {{NULL, NULL, NULL, 0, 0, 0, -1, 0}}
+}};
+@end struct
+"""
+
 TEXT_CODEGEN = """
 /* Copyright (c) 2015-2016, 2019 Valve Corporation
  * Copyright (c) 2015-2016, 2019 LunarG, Inc.
@@ -526,6 +704,7 @@ TEXT_CODEGEN = """
 #pragma once
 
 #include "api_dump.h"
+#include "api_dump_tables.h"
 
 @foreach struct
 std::ostream& dump_text_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents{sctConditionVars});
@@ -622,10 +801,10 @@ std::ostream& dump_text_pNext_struct_name(const void* object, const ApiDumpSetti
 inline std::ostream& dump_text_{etyName}({etyName} object, const ApiDumpSettings& settings, int indents)
 {{
     @if('{etyName}' != 'uint8_t')
-    return settings.stream() << object;
+    return dump_write_value(settings.stream(), object);
     @end if
     @if('{etyName}' == 'uint8_t')
-    return settings.stream() << (uint32_t) object;
+    return dump_write_value(settings.stream(), (uint32_t) object);
     @end if
 }}
 @end type
@@ -635,14 +814,14 @@ inline std::ostream& dump_text_{etyName}({etyName} object, const ApiDumpSettings
 @foreach basetype where(not '{baseName}' in ['ANativeWindow', 'AHardwareBuffer', 'CAMetalLayer'])
 inline std::ostream& dump_text_{baseName}({baseName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << object;
+    return dump_write_value(settings.stream(), object);
 }}
 @end basetype
 @foreach basetype where('{baseName}' in ['ANativeWindow', 'AHardwareBuffer'])
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 inline std::ostream& dump_text_{baseName}(const {baseName}* object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << object;
+    return dump_write_value(settings.stream(), object);
 }}
 #endif
 @end basetype
@@ -650,7 +829,7 @@ inline std::ostream& dump_text_{baseName}(const {baseName}* object, const ApiDum
 #if defined(VK_USE_PLATFORM_METAL_EXT)
 inline std::ostream& dump_text_{baseName}({baseName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << object;
+    return dump_write_value(settings.stream(), object);
 }}
 #endif
 @end basetype
@@ -660,7 +839,7 @@ inline std::ostream& dump_text_{baseName}({baseName} object, const ApiDumpSettin
 @foreach systype
 inline std::ostream& dump_text_{sysName}(const {sysType} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << object;
+    return dump_write_value(settings.stream(), object);
 }}
 @end systype
 
@@ -670,11 +849,11 @@ inline std::ostream& dump_text_{sysName}(const {sysType} object, const ApiDumpSe
 inline std::ostream& dump_text_{hdlName}(const {hdlName} object, const ApiDumpSettings& settings, int indents)
 {{
     if(settings.showAddress()) {{
-        settings.stream() << object;
+        dump_write_value(settings.stream(), object);
 
-        std::unordered_map<uint64_t, std::string>::const_iterator it = ApiDumpInstance::current().object_name_map.find((uint64_t) object);
-        if (it != ApiDumpInstance::current().object_name_map.end()) {{
-            settings.stream() << " [" << it->second << "]";
+        std::string object_name;
+        if (ApiDumpInstance::current().getObjectName((uint64_t) object, object_name)) {{
+            settings.stream() << " [" << object_name << "]";
         }}
     }} else {{
         settings.stream() << "address";
@@ -687,19 +866,9 @@ inline std::ostream& dump_text_{hdlName}(const {hdlName} object, const ApiDumpSe
 //=========================== Enum Implementations ==========================//
 
 @foreach enum
-std::ostream& dump_text_{enumName}({enumName} object, const ApiDumpSettings& settings, int indents)
+inline std::ostream& dump_text_{enumName}({enumName} object, const ApiDumpSettings& settings, int indents)
 {{
-    switch((int64_t) object)
-    {{
-    @foreach option
-    case {optValue}:
-        settings.stream() << "{optName} (";
-        break;
-    @end option
-    default:
-        settings.stream() << "UNKNOWN (";
-    }}
-    return settings.stream() << object << ")";
+    return dump_text_enum(dump_enum_name(API_DUMP_OPTIONS_{enumName}, object), object, settings);
 }}
 @end enum
 
@@ -712,25 +881,9 @@ std::ostream& dump_text_{enumName}({enumName} object, const ApiDumpSettings& set
 // only needs to be generated by the first .h file.
 typedef VkFlags64 {bitName};
 @end if
-std::ostream& dump_text_{bitName}({bitName} object, const ApiDumpSettings& settings, int indents)
+inline std::ostream& dump_text_{bitName}({bitName} object, const ApiDumpSettings& settings, int indents)
 {{
-    bool is_first = true;
-    //settings.formatNameType(stream, indents, name, type_string) << object;
-    settings.stream() << object;
-    @foreach option
-        @if('{optMultiValue}' != 'None')
-            if(object == {optValue})
-                is_first = dump_text_bitmaskOption("{optName}", settings.stream(), is_first);
-        @end if
-        @if('{optMultiValue}' == 'None')
-            if(object & {optValue})
-                is_first = dump_text_bitmaskOption("{optName}", settings.stream(), is_first);
-        @end if
-
-    @end option
-    if(!is_first)
-        settings.stream() << ")";
-    return settings.stream();
+    return dump_text_bitmask(API_DUMP_OPTIONS_{bitName}, object, settings);
 }}
 @end bitmask
 
@@ -745,7 +898,7 @@ inline std::ostream& dump_text_{flagName}({flagName} object, const ApiDumpSettin
 @foreach flag where('{flagEnum}' == 'None')
 inline std::ostream& dump_text_{flagName}({flagName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << object;
+    return dump_write_value(settings.stream(), object);
 }}
 @end flag
 
@@ -763,11 +916,19 @@ inline std::ostream& dump_text_{pfnName}({pfnName} object, const ApiDumpSettings
 
 //========================== Struct Implementations =========================//
 
-@foreach struct where('{sctName}' not in ['VkPhysicalDeviceMemoryProperties','VkPhysicalDeviceGroupProperties'])
+@foreach struct where({sctTable})
+std::ostream& dump_text_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents)
+{{
+    return dump_text_struct(API_DUMP_MEMBERS_{sctName}, &object, settings, indents);
+}}
+@end struct
+
+// Structs with special cases that the member tables do not describe
+@foreach struct where(not {sctTable} and '{sctName}' not in ['VkPhysicalDeviceMemoryProperties','VkPhysicalDeviceGroupProperties'])
 std::ostream& dump_text_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents{sctConditionVars})
 {{
     if(settings.showAddress())
-        settings.stream() << &object << ":\\n";
+        dump_write_pointer(settings.stream(), &object) << ":\\n";
     else
         settings.stream() << "address:\\n";
 
@@ -777,9 +938,12 @@ std::ostream& dump_text_{sctName}(const {sctName}& object, const ApiDumpSettings
     @end if
 
     @if({memPtrLevel} == 0)
-        @if('{memName}' != 'pNext')
+        @if('{memName}' != 'pNext' and not ('{memType}' == 'const void*' and '{memLength}' != 'None'))
     dump_text_value<const {memBaseType}>(object.{memName}, settings, "{memType}", "{memName}", indents + 1, dump_text_{memTypeID}{memInheritedConditions});  // AET
         @end if 
+        @if('{memType}' == 'const void*' and '{memLength}' != 'None')
+    dump_text_payload(object.{memName}, object.{memLength}, settings, "{memType}", "{memName}", indents + 1);
+        @end if
         @if('{memName}' == 'pNext')
     if(object.pNext != nullptr){{
         dump_text_pNext_struct_name(object.{memName}, settings, indents + 1);
@@ -805,7 +969,9 @@ std::ostream& dump_text_{sctName}(const {sctName}& object, const ApiDumpSettings
 
     @if('{sctName}' == 'VkShaderModuleCreateInfo')
     @if('{memName}' == 'pCode')
-    if(settings.showShader())
+    if(settings.showShader() && settings.storesBlobs())
+        dump_text_payload(object.{memName}, object.codeSize, settings, "{memType}", "{memName}", indents + 1);
+    else if(settings.showShader())
         dump_text_array<const {memBaseType}>(object.{memName}, object.{memLength}, settings, "{memType}", "{memChildType}", "{memName}", indents + 1, dump_text_{memTypeID}{memInheritedConditions}); // CQA
     else
         dump_text_special("SHADER DATA", settings, "{memType}", "{memName}", indents + 1);
@@ -834,7 +1000,7 @@ std::ostream& dump_text_{sctName}(const {sctName}& object, const ApiDumpSettings
 std::ostream& dump_text_VkPhysicalDeviceMemoryProperties(const VkPhysicalDeviceMemoryProperties& object, const ApiDumpSettings& settings, int indents)
 {{
     if(settings.showAddress())
-        settings.stream() << &object << ":\\n";
+        dump_write_pointer(settings.stream(), &object) << ":\\n";
     else
         settings.stream() << "address:\\n";
 
@@ -848,7 +1014,7 @@ std::ostream& dump_text_VkPhysicalDeviceMemoryProperties(const VkPhysicalDeviceM
 std::ostream& dump_text_VkPhysicalDeviceGroupProperties(const VkPhysicalDeviceGroupProperties& object, const ApiDumpSettings& settings, int indents)
 {{
     if(settings.showAddress())
-        settings.stream() << &object << ":\\n";
+        dump_write_pointer(settings.stream(), &object) << ":\\n";
     else
         settings.stream() << "address:\\n";
     dump_text_value<const VkStructureType>(object.sType, settings, "VkStructureType", "sType", indents + 1, dump_text_VkStructureType); // HET
@@ -865,7 +1031,7 @@ std::ostream& dump_text_VkPhysicalDeviceGroupProperties(const VkPhysicalDeviceGr
 std::ostream& dump_text_{unName}(const {unName}& object, const ApiDumpSettings& settings, int indents)
 {{
     if(settings.showAddress())
-        settings.stream() << &object << " (Union):\\n";
+        dump_write_pointer(settings.stream(), &object) << " (Union):\\n";
     else
         settings.stream() << "address (Union):\\n";
 
@@ -884,6 +1050,34 @@ std::ostream& dump_text_{unName}(const {unName}& object, const ApiDumpSettings&
 }}
 @end union
 
+//=========================== Member Type Dispatch ==========================//
+
+// Dumps a value of one of the types that the member tables of api_dump_tables.h use
+std::ostream& dump_text_type(uint32_t type_id, const void* object, const ApiDumpSettings& settings, int indents)
+{{
+    switch(type_id) {{
+    @foreach membertype
+    case API_DUMP_TYPE_{mtyName}:
+        return dump_text_{mtyName}(*static_cast<{mtyBaseType} const*>(object), settings, indents);
+    @end membertype
+    }}
+    return settings.stream();
+}}
+
+//======================== Command Buffer Summaries =========================//
+
+std::ostream& dump_text_ApiDumpCmdBufferSummary(const ApiDumpCmdBufferSummary& object, const ApiDumpSettings& settings, int indents)
+{{
+    dump_text_VkCommandBuffer(object.commandBuffer, settings, indents) << ":\\n";
+    for (int i = 0; i < ApiDumpCmdBufferSummary::CategoryCount; ++i)
+        dump_text_value<const uint64_t>(object.counts[i], settings, "uint64_t", API_DUMP_CMD_BUFFER_SUMMARY_NAMES[i], indents + 1, dump_text_uint64_t);
+    dump_text_value<const uint64_t>(object.pipelines.size(), settings, "uint64_t", "uniquePipelines", indents + 1, dump_text_uint64_t);
+    ArrayIndexName pipelineName("pipelines");
+    for (size_t i = 0; i < object.pipelines.size(); ++i)
+        dump_text_value<const VkPipeline>(object.pipelines[i], settings, "VkPipeline", pipelineName.get(i), indents + 1, dump_text_VkPipeline);
+    return settings.stream();
+}}
+
 //========================= Function Implementations ========================//
 
 @foreach function where('{funcName}' not in ['vkGetDeviceProcAddr', 'vkGetInstanceProcAddr'])
@@ -891,13 +1085,14 @@ std::ostream& dump_text_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
 {{
     const ApiDumpSettings& settings(dump_inst.settings());
     if (settings.showThreadAndFrame()) {{
-        settings.stream() << "Thread " << dump_inst.threadID() << ", Frame " << dump_inst.frameCount();
+        dump_write_uint(settings.stream() << "Thread ", dump_inst.threadID());
+        dump_write_uint(settings.stream() << ", Frame ", dump_inst.frameCount());
     }}
     if(settings.showTimestamp() && settings.showThreadAndFrame()) {{
         settings.stream() << ", ";
     }}
     if (settings.showTimestamp()) {{
-        settings.stream() << "Time " << dump_inst.current_time_since_start().count() << " us";
+        dump_write_int(settings.stream() << "Time ", dump_inst.current_time_since_start().count()) << " us";
     }} 
     if (settings.showTimestamp() || settings.showThreadAndFrame()) {{
         settings.stream() << ":\\n";
@@ -926,9 +1121,12 @@ std::ostream& dump_text_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
     if(settings.showParams())
     {{
         @foreach parameter
-        @if({prmPtrLevel} == 0)
+        @if({prmPtrLevel} == 0 and not ('{prmType}' == 'const void*' and '{prmLength}' != 'None'))
         dump_text_value<const {prmBaseType}>({prmName}, settings, "{prmType}", "{prmName}", 1, dump_text_{prmTypeID}{prmInheritedConditions}); // MET
         @end if
+        @if({prmPtrLevel} == 0 and '{prmType}' == 'const void*' and '{prmLength}' != 'None')
+        dump_text_payload({prmName}, {prmLength}, settings, "{prmType}", "{prmName}", 1);
+        @end if
         @if({prmPtrLevel} == 1 and '{prmLength}' == 'None')
         dump_text_pointer<const {prmBaseType}>({prmName}, settings, "{prmType}", "{prmName}", 1, dump_text_{prmTypeID}{prmInheritedConditions});
         @end if
@@ -936,6 +1134,14 @@ std::ostream& dump_text_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
         dump_text_array<const {prmBaseType}>({prmName}, {prmLength}, settings, "{prmType}", "{prmChildType}", "{prmName}", 1, dump_text_{prmTypeID}{prmInheritedConditions}); // HQA
         @end if
         @end parameter
+        @if('{funcName}' == 'vkQueueSubmit')
+        if (settings.summarizesCmdBuffers()) {{
+            std::vector<ApiDumpCmdBufferSummary> summaries = settings.cmdBufferSummaries().summarize(submitCount, pSubmits);
+            ArrayIndexName summaryName("commandBufferSummaries");
+            for (size_t i = 0; i < summaries.size(); ++i)
+                dump_text_value<const ApiDumpCmdBufferSummary>(summaries[i], settings, "CommandBufferSummary", summaryName.get(i), 1, dump_text_ApiDumpCmdBufferSummary);
+        }}
+        @end if
     }}
     settings.shouldFlush() ? settings.stream() << std::endl : settings.stream() << "\\n";
 
@@ -979,6 +1185,7 @@ HTML_CODEGEN = """
 #pragma once
 
 #include "api_dump.h"
+#include "api_dump_tables.h"
 
 @foreach struct
 std::ostream& dump_html_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents{sctConditionVars});
@@ -1054,10 +1261,10 @@ inline std::ostream& dump_html_{etyName}({etyName} object, const ApiDumpSettings
 {{
     settings.stream() << "<div class='val'>";
     @if('{etyName}' != 'uint8_t')
-    settings.stream() << object;
+    dump_write_value(settings.stream(), object);
     @end if
     @if('{etyName}' == 'uint8_t')
-    settings.stream() << (uint32_t) object;
+    dump_write_value(settings.stream(), (uint32_t) object);
     @end if
     return settings.stream() << "</div></summary>";
 }}
@@ -1068,14 +1275,16 @@ inline std::ostream& dump_html_{etyName}({etyName} object, const ApiDumpSettings
 @foreach basetype where(not '{baseName}' in ['ANativeWindow', 'AHardwareBuffer', 'CAMetalLayer'])
 inline std::ostream& dump_html_{baseName}({baseName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "<div class='val'>" << object << "</div></summary>";
+    settings.stream() << "<div class='val'>";
+    return dump_write_value(settings.stream(), object) << "</div></summary>";
 }}
 @end basetype
 @foreach basetype where('{baseName}' in ['ANativeWindow', 'AHardwareBuffer'])
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 inline std::ostream& dump_html_{baseName}(const {baseName}* object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "<div class='val'>" << object << "</div></summary>";
+    settings.stream() << "<div class='val'>";
+    return dump_write_value(settings.stream(), object) << "</div></summary>";
 }}
 #endif
 @end basetype
@@ -1083,7 +1292,8 @@ inline std::ostream& dump_html_{baseName}(const {baseName}* object, const ApiDum
 #if defined(VK_USE_PLATFORM_METAL_EXT)
 inline std::ostream& dump_html_{baseName}({baseName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "<div class='val'>" << object << "</div></summary>";
+    settings.stream() << "<div class='val'>";
+    return dump_write_value(settings.stream(), object) << "</div></summary>";
 }}
 #endif
 @end basetype
@@ -1093,7 +1303,8 @@ inline std::ostream& dump_html_{baseName}({baseName} object, const ApiDumpSettin
 @foreach systype
 inline std::ostream& dump_html_{sysName}(const {sysType} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "<div class='val'>" << object << "</div></summary>";
+    settings.stream() << "<div class='val'>";
+    return dump_write_value(settings.stream(), object) << "</div></summary>";
 }}
 @end systype
 
@@ -1104,11 +1315,11 @@ inline std::ostream& dump_html_{hdlName}(const {hdlName} object, const ApiDumpSe
 {{
     settings.stream() << "<div class='val'>";
     if(settings.showAddress()) {{
-        settings.stream() << object;
+        dump_write_value(settings.stream(), object);
 
-        std::unordered_map<uint64_t, std::string>::const_iterator it = ApiDumpInstance::current().object_name_map.find((uint64_t) object);
-        if (it != ApiDumpInstance::current().object_name_map.end()) {{
-            settings.stream() << "</div><div class='val'>[" << it->second << "]";
+        std::string object_name;
+        if (ApiDumpInstance::current().getObjectName((uint64_t) object, object_name)) {{
+            settings.stream() << "</div><div class='val'>[" << object_name << "]";
         }}
     }} else {{
         settings.stream() << "address";
@@ -1120,44 +1331,18 @@ inline std::ostream& dump_html_{hdlName}(const {hdlName} object, const ApiDumpSe
 //=========================== Enum Implementations ==========================//
 
 @foreach enum
-std::ostream& dump_html_{enumName}({enumName} object, const ApiDumpSettings& settings, int indents)
+inline std::ostream& dump_html_{enumName}({enumName} object, const ApiDumpSettings& settings, int indents)
 {{
-    settings.stream() << "<div class='val'>";
-    switch((int64_t) object)
-    {{
-    @foreach option
-    case {optValue}:
-        settings.stream() << "{optName} (";
-        break;
-    @end option
-    default:
-        settings.stream() << "UNKNOWN (";
-    }}
-    return settings.stream() << object << ")</div></summary>";
+    return dump_html_enum(dump_enum_name(API_DUMP_OPTIONS_{enumName}, object), object, settings);
 }}
 @end enum
 
 //========================= Bitmask Implementations =========================//
 
 @foreach bitmask
-std::ostream& dump_html_{bitName}({bitName} object, const ApiDumpSettings& settings, int indents)
+inline std::ostream& dump_html_{bitName}({bitName} object, const ApiDumpSettings& settings, int indents)
 {{
-    settings.stream() << "<div class=\'val\'>";
-    bool is_first = true;
-    settings.stream() << object;
-    @foreach option
-        @if('{optMultiValue}' != 'None')
-            if(object == {optValue})
-                is_first = dump_html_bitmaskOption("{optName}", settings.stream(), is_first);
-        @end if
-        @if('{optMultiValue}' == 'None')
-            if(object & {optValue})
-                is_first = dump_html_bitmaskOption("{optName}", settings.stream(), is_first);
-        @end if
-    @end option
-    if(!is_first)
-        settings.stream() << ")";
-    return settings.stream() << "</div></summary>";
+    return dump_html_bitmask(API_DUMP_OPTIONS_{bitName}, object, settings);
 }}
 @end bitmask
 
@@ -1172,8 +1357,8 @@ inline std::ostream& dump_html_{flagName}({flagName} object, const ApiDumpSettin
 @foreach flag where('{flagEnum}' == 'None')
 inline std::ostream& dump_html_{flagName}({flagName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "<div class=\'val\'>"
-                             << object << "</div></summary>";
+    settings.stream() << "<div class=\'val\'>";
+    return dump_write_value(settings.stream(), object) << "</div></summary>";
 }}
 @end flag
 
@@ -1193,12 +1378,20 @@ inline std::ostream& dump_html_{pfnName}({pfnName} object, const ApiDumpSettings
 
 //========================== Struct Implementations =========================//
 
-@foreach struct where('{sctName}' not in ['VkPhysicalDeviceMemoryProperties' ,'VkPhysicalDeviceGroupProperties'])
+@foreach struct where({sctTable})
+std::ostream& dump_html_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents)
+{{
+    return dump_html_struct(API_DUMP_MEMBERS_{sctName}, &object, settings, indents);
+}}
+@end struct
+
+// Structs with special cases that the member tables do not describe
+@foreach struct where(not {sctTable} and '{sctName}' not in ['VkPhysicalDeviceMemoryProperties' ,'VkPhysicalDeviceGroupProperties'])
 std::ostream& dump_html_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents{sctConditionVars})
 {{
     settings.stream() << "<div class=\'val\'>";
     if(settings.showAddress())
-        settings.stream() << &object << "\\n";
+        dump_write_pointer(settings.stream(), &object) << "\\n";
     else
         settings.stream() << "address\\n";
     settings.stream() << "</div></summary>";
@@ -1209,9 +1402,12 @@ std::ostream& dump_html_{sctName}(const {sctName}& object, const ApiDumpSettings
     @end if
 
     @if({memPtrLevel} == 0)
-        @if('{memName}' != 'pNext')
+        @if('{memName}' != 'pNext' and not ('{memType}' == 'const void*' and '{memLength}' != 'None'))
     dump_html_value<const {memBaseType}>(object.{memName}, settings, "{memType}", "{memName}", indents + 1, dump_html_{memTypeID}{memInheritedConditions});
         @end if 
+        @if('{memType}' == 'const void*' and '{memLength}' != 'None')
+    dump_html_payload(object.{memName}, object.{memLength}, settings, "{memType}", "{memName}", indents + 1);
+        @end if
         @if('{memName}' == 'pNext')
     if(object.pNext != nullptr){{
         dump_html_pNext_trampoline(object.{memName}, settings, indents + 1);
@@ -1236,7 +1432,9 @@ std::ostream& dump_html_{sctName}(const {sctName}& object, const ApiDumpSettings
     @end if
     @if('{sctName}' == 'VkShaderModuleCreateInfo')
     @if('{memName}' == 'pCode')
-    if(settings.showShader())
+    if(settings.showShader() && settings.storesBlobs())
+        dump_html_payload(object.{memName}, object.codeSize, settings, "{memType}", "{memName}", indents + 1);
+    else if(settings.showShader())
         dump_html_array<const {memBaseType}>(object.{memName}, object.{memLength}, settings, "{memType}", "{memChildType}", "{memName}", indents + 1, dump_html_{memTypeID}{memInheritedConditions}); // ZRU
     else
         dump_html_special("SHADER DATA", settings, "{memType}", "{memName}", indents + 1);
@@ -1256,7 +1454,7 @@ std::ostream& dump_html_VkPhysicalDeviceMemoryProperties(const VkPhysicalDeviceM
 {{
     settings.stream() << "<div class='val'>";
     if(settings.showAddress())
-        settings.stream() << &object << "\\n";
+        dump_write_pointer(settings.stream(), &object) << "\\n";
     else
         settings.stream() << "address\\n";
     settings.stream() << "</div></summary>";
@@ -1271,7 +1469,7 @@ std::ostream& dump_html_VkPhysicalDeviceGroupProperties(const VkPhysicalDeviceGr
 {{
     settings.stream() << "<div class='val'>";
     if(settings.showAddress())
-        settings.stream() << &object << "\\n";
+        dump_write_pointer(settings.stream(), &object) << "\\n";
     else
         settings.stream() << "address\\n";
     settings.stream() << "</div></summary>";
@@ -1290,7 +1488,7 @@ std::ostream& dump_html_{unName}(const {unName}& object, const ApiDumpSettings&
 {{
     settings.stream() << "<div class='val'>";
     if(settings.showAddress())
-        settings.stream() << &object << " (Union):\\n";
+        dump_write_pointer(settings.stream(), &object) << " (Union):\\n";
     else
         settings.stream() << "address (Union):\\n";
     settings.stream() << "</div></summary>";
@@ -1310,6 +1508,45 @@ std::ostream& dump_html_{unName}(const {unName}& object, const ApiDumpSettings&
 }}
 @end union
 
+//=========================== Member Type Dispatch ==========================//
+
+// Dumps a value of one of the types that the member tables of api_dump_tables.h use
+std::ostream& dump_html_type(uint32_t type_id, const void* object, const ApiDumpSettings& settings, int indents)
+{{
+    switch(type_id) {{
+    @foreach membertype
+    case API_DUMP_TYPE_{mtyName}:
+        return dump_html_{mtyName}(*static_cast<{mtyBaseType} const*>(object), settings, indents);
+    @end membertype
+    }}
+    return settings.stream();
+}}
+
+//======================== Command Buffer Summaries =========================//
+
+std::ostream& dump_html_ApiDumpCmdBufferSummary(const ApiDumpCmdBufferSummary& object, const ApiDumpSettings& settings, int indents)
+{{
+    settings.stream() << "<div class='val'>";
+    if(settings.showAddress()) {{
+        dump_write_value(settings.stream(), object.commandBuffer);
+
+        std::string object_name;
+        if (ApiDumpInstance::current().getObjectName((uint64_t) object.commandBuffer, object_name)) {{
+            settings.stream() << "</div><div class='val'>[" << object_name << "]";
+        }}
+    }} else {{
+        settings.stream() << "address";
+    }}
+    settings.stream() << "</div></summary>";
+    for (int i = 0; i < ApiDumpCmdBufferSummary::CategoryCount; ++i)
+        dump_html_value<const uint64_t>(object.counts[i], settings, "uint64_t", API_DUMP_CMD_BUFFER_SUMMARY_NAMES[i], indents + 1, dump_html_uint64_t);
+    dump_html_value<const uint64_t>(object.pipelines.size(), settings, "uint64_t", "uniquePipelines", indents + 1, dump_html_uint64_t);
+    ArrayIndexName pipelineName("pipelines");
+    for (size_t i = 0; i < object.pipelines.size(); ++i)
+        dump_html_value<const VkPipeline>(object.pipelines[i], settings, "VkPipeline", pipelineName.get(i), indents + 1, dump_html_VkPipeline);
+    return settings.stream();
+}}
+
 //========================= Function Implementations ========================//
 
 @foreach function where('{funcName}' not in ['vkGetDeviceProcAddr', 'vkGetInstanceProcAddr'])
@@ -1317,10 +1554,10 @@ std::ostream& dump_html_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
 {{
     const ApiDumpSettings& settings(dump_inst.settings());
     if (settings.showThreadAndFrame()){{
-        settings.stream() << "<div class='thd'>Thread: " << dump_inst.threadID() << "</div>";
+        dump_write_uint(settings.stream() << "<div class='thd'>Thread: ", dump_inst.threadID()) << "</div>";
     }}
     if(settings.showTimestamp())
-        settings.stream() << "<div class='time'>Time: " << dump_inst.current_time_since_start().count() << " us</div>";
+        dump_write_int(settings.stream() << "<div class='time'>Time: ", dump_inst.current_time_since_start().count()) << " us</div>";
     settings.stream() << "<details class='fn'><summary>";
     dump_html_nametype(settings.stream(), settings.showType(), "{funcName}({funcNamedParams})", "{funcReturn}");
 
@@ -1346,9 +1583,12 @@ std::ostream& dump_html_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
     if(settings.showParams())
     {{
         @foreach parameter
-        @if({prmPtrLevel} == 0)
+        @if({prmPtrLevel} == 0 and not ('{prmType}' == 'const void*' and '{prmLength}' != 'None'))
         dump_html_value<const {prmBaseType}>({prmName}, settings, "{prmType}", "{prmName}", 1, dump_html_{prmTypeID}{prmInheritedConditions});
         @end if
+        @if({prmPtrLevel} == 0 and '{prmType}' == 'const void*' and '{prmLength}' != 'None')
+        dump_html_payload({prmName}, {prmLength}, settings, "{prmType}", "{prmName}", 1);
+        @end if
         @if({prmPtrLevel} == 1 and '{prmLength}' == 'None')
         dump_html_pointer<const {prmBaseType}>({prmName}, settings, "{prmType}", "{prmName}", 1, dump_html_{prmTypeID}{prmInheritedConditions});
         @end if
@@ -1356,6 +1596,14 @@ std::ostream& dump_html_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
         dump_html_array<const {prmBaseType}>({prmName}, {prmLength}, settings, "{prmType}", "{prmChildType}", "{prmName}", 1, dump_html_{prmTypeID}{prmInheritedConditions}); // ZRZ
         @end if
         @end parameter
+        @if('{funcName}' == 'vkQueueSubmit')
+        if (settings.summarizesCmdBuffers()) {{
+            std::vector<ApiDumpCmdBufferSummary> summaries = settings.cmdBufferSummaries().summarize(submitCount, pSubmits);
+            ArrayIndexName summaryName("commandBufferSummaries");
+            for (size_t i = 0; i < summaries.size(); ++i)
+                dump_html_value<const ApiDumpCmdBufferSummary>(summaries[i], settings, "CommandBufferSummary", summaryName.get(i), 1, dump_html_ApiDumpCmdBufferSummary);
+        }}
+        @end if
     }}
     settings.shouldFlush() ? settings.stream() << std::endl : settings.stream() << "\\n";
 
@@ -1397,6 +1645,7 @@ JSON_CODEGEN = """
 #pragma once
 
 #include "api_dump.h"
+#include "api_dump_tables.h"
 
 @foreach struct
 std::ostream& dump_json_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents{sctConditionVars});
@@ -1405,6 +1654,13 @@ std::ostream& dump_json_{sctName}(const {sctName}& object, const ApiDumpSettings
 std::ostream& dump_json_{unName}(const {unName}& object, const ApiDumpSettings& settings, int indents);
 @end union
 
+@foreach struct
+template <> struct ApiDumpTypeTraits<{sctName}> {{ static const ApiDumpTypeKind kind = ApiDumpTypeKind::Struct; }};
+@end struct
+@foreach union
+template <> struct ApiDumpTypeTraits<{unName}> {{ static const ApiDumpTypeKind kind = ApiDumpTypeKind::Union; }};
+@end union
+
 //============================= typedefs ==============================//
 
 // Functions for dumping typedef types that the codegen scripting can't handle
@@ -1440,18 +1696,18 @@ std::ostream& dump_json_pNext_trampoline(const void* object, const ApiDumpSettin
         if(static_cast<const VkBaseInStructure*>(object)->pNext != nullptr){{
             dump_json_pNext_trampoline(static_cast<const void*>(static_cast<const VkBaseInStructure*>(object)->pNext), settings, indents);
         }} else {{
-            settings.stream() << settings.indentation(indents) << "{{\\n";
-            settings.stream() << settings.indentation(indents + 1) << "\\"type\\" : \\"const void*\\",\\n";
-            settings.stream() << settings.indentation(indents + 1) << "\\"name\\" : \\"pNext\\",\\n";
-            settings.stream() << settings.indentation(indents + 1) << "\\"value\\" : \\"NULL\\"\\n";
+            settings.stream() << settings.indentation(indents) << "{{" << settings.jsonLineBreak();
+            settings.stream() << settings.indentation(indents + 1) << "\\"type\\" : \\"const void*\\"," << settings.jsonLineBreak();
+            settings.stream() << settings.indentation(indents + 1) << "\\"name\\" : \\"pNext\\"," << settings.jsonLineBreak();
+            settings.stream() << settings.indentation(indents + 1) << "\\"value\\" : \\"NULL\\"" << settings.jsonLineBreak();
             settings.stream() << settings.indentation(indents) << "}}";
         }}
         break;
     default:
-        settings.stream() << settings.indentation(indents) << "{{\\n";
-        settings.stream() << settings.indentation(indents + 1) << "\\"type\\" : \\"const void*\\",\\n";
-        settings.stream() << settings.indentation(indents + 1) << "\\"name\\" : \\"pNext\\",\\n";
-        settings.stream() << settings.indentation(indents + 1) << "\\"value\\" : \\"UNKNOWN (\\"" << (int64_t) (static_cast<const VkBaseInStructure*>(object)->sType) << "\\")\\n";
+        settings.stream() << settings.indentation(indents) << "{{" << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents + 1) << "\\"type\\" : \\"const void*\\"," << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents + 1) << "\\"name\\" : \\"pNext\\"," << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents + 1) << "\\"value\\" : \\"UNKNOWN (\\"" << (int64_t) (static_cast<const VkBaseInStructure*>(object)->sType) << "\\")" << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents) << "}}";
     }}
     return settings.stream(); 
@@ -1477,10 +1733,12 @@ inline std::ostream& dump_json_{etyName}({etyName} object, const ApiDumpSettings
 
     //settings.stream() << settings.indentation(indents);
     @if('{etyName}' != 'uint8_t')
-    return settings.stream() << "\\"" << object << "\\"";
+    settings.stream() << "\\"";
+    return dump_write_value(settings.stream(), object) << "\\"";
     @end if
     @if('{etyName}' == 'uint8_t')
-    return settings.stream() << "\\"" << (uint32_t) object << "\\"";
+    settings.stream() << "\\"";
+    return dump_write_value(settings.stream(), (uint32_t) object) << "\\"";
     @end if
 }}
 @end type
@@ -1490,14 +1748,16 @@ inline std::ostream& dump_json_{etyName}({etyName} object, const ApiDumpSettings
 @foreach basetype where(not '{baseName}' in ['ANativeWindow', 'AHardwareBuffer', 'CAMetalLayer'])
 inline std::ostream& dump_json_{baseName}({baseName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "\\"" << object << "\\"";
+    settings.stream() << "\\"";
+    return dump_write_value(settings.stream(), object) << "\\"";
 }}
 @end basetype
 @foreach basetype where('{baseName}' in ['ANativeWindow', 'AHardwareBuffer'])
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 inline std::ostream& dump_json_{baseName}(const {baseName}* object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "\\"" << object << "\\"";
+    settings.stream() << "\\"";
+    return dump_write_value(settings.stream(), object) << "\\"";
 }}
 #endif
 @end basetype
@@ -1505,7 +1765,8 @@ inline std::ostream& dump_json_{baseName}(const {baseName}* object, const ApiDum
 #if defined(VK_USE_PLATFORM_METAL_EXT)
 inline std::ostream& dump_json_{baseName}({baseName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "\\"" << object << "\\"";
+    settings.stream() << "\\"";
+    return dump_write_value(settings.stream(), object) << "\\"";
 }}
 #endif
 @end basetype
@@ -1515,7 +1776,8 @@ inline std::ostream& dump_json_{baseName}({baseName} object, const ApiDumpSettin
 @foreach systype
 inline std::ostream& dump_json_{sysName}(const {sysType} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << "\\"" << object << "\\"";
+    settings.stream() << "\\"";
+    return dump_write_value(settings.stream(), object) << "\\"";
 }}
 @end systype
 
@@ -1525,7 +1787,8 @@ inline std::ostream& dump_json_{sysName}(const {sysType} object, const ApiDumpSe
 inline std::ostream& dump_json_{hdlName}(const {hdlName} object, const ApiDumpSettings& settings, int indents)
 {{
     if(settings.showAddress()) {{
-        return settings.stream() << "\\"" << object << "\\"";
+        settings.stream() << "\\"";
+        return dump_write_value(settings.stream(), object) << "\\"";
     }} else {{
         return settings.stream() << "\\"address\\"";
     }}
@@ -1536,44 +1799,18 @@ inline std::ostream& dump_json_{hdlName}(const {hdlName} object, const ApiDumpSe
 //=========================== Enum Implementations ==========================//
 
 @foreach enum
-std::ostream& dump_json_{enumName}({enumName} object, const ApiDumpSettings& settings, int indents)
+inline std::ostream& dump_json_{enumName}({enumName} object, const ApiDumpSettings& settings, int indents)
 {{
-    switch((int64_t) object)
-    {{
-    @foreach option
-    case {optValue}:
-        settings.stream() << "\\"{optName}\\"";
-        break;
-    @end option
-    default:
-        settings.stream() << "\\"UNKNOWN (" << object << ")\\"";
-    }}
-    return settings.stream();
+    return dump_json_enum(dump_enum_name(API_DUMP_OPTIONS_{enumName}, object), object, settings);
 }}
 @end enum
 
 //========================= Bitmask Implementations =========================//
 
 @foreach bitmask
-std::ostream& dump_json_{bitName}({bitName} object, const ApiDumpSettings& settings, int indents)
+inline std::ostream& dump_json_{bitName}({bitName} object, const ApiDumpSettings& settings, int indents)
 {{
-    bool is_first = true;
-    settings.stream() << '"' << object;
-    if (object)
-        settings.stream() << ' ';
-    @foreach option
-        @if('{optMultiValue}' != 'None')
-            if(object == {optValue})
-                is_first = dump_json_bitmaskOption("{optName}", settings.stream(), is_first);
-        @end if
-        @if('{optMultiValue}' == 'None')
-            if(object & {optValue})
-                is_first = dump_json_bitmaskOption("{optName}", settings.stream(), is_first);
-        @end if
-    @end option
-    if(!is_first)
-        settings.stream() << ')';
-    return settings.stream() << "\\"";
+    return dump_json_bitmask(API_DUMP_OPTIONS_{bitName}, object, settings);
 }}
 @end bitmask
 
@@ -1588,7 +1825,7 @@ inline std::ostream& dump_json_{flagName}({flagName} object, const ApiDumpSettin
 @foreach flag where('{flagEnum}' == 'None')
 inline std::ostream& dump_json_{flagName}({flagName} object, const ApiDumpSettings& settings, int indents)
 {{
-    return settings.stream() << '"' << object << "\\"";
+    return dump_write_value(settings.stream() << '"', object) << "\\"";
 }}
 @end flag
 
@@ -1607,22 +1844,33 @@ inline std::ostream& dump_json_{pfnName}({pfnName} object, const ApiDumpSettings
 
 //========================== Struct Implementations =========================//
 
-@foreach struct where('{sctName}' not in ['VkPhysicalDeviceMemoryProperties' ,'VkPhysicalDeviceGroupProperties'])
+@foreach struct where({sctTable})
+std::ostream& dump_json_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents)
+{{
+    return dump_json_struct(API_DUMP_MEMBERS_{sctName}, &object, settings, indents);
+}}
+@end struct
+
+// Structs with special cases that the member tables do not describe
+@foreach struct where(not {sctTable} and '{sctName}' not in ['VkPhysicalDeviceMemoryProperties' ,'VkPhysicalDeviceGroupProperties'])
 std::ostream& dump_json_{sctName}(const {sctName}& object, const ApiDumpSettings& settings, int indents{sctConditionVars})
 {{
-    settings.stream() << settings.indentation(indents) << "[\\n";
+    settings.stream() << settings.indentation(indents) << "[" << settings.jsonLineBreak();
 
     bool needMemberComma = false;
     @foreach member
-    if (needMemberComma) settings.stream() << ",\\n";
+    if (needMemberComma) settings.stream() << "," << settings.jsonLineBreak();
     @if('{memCondition}' != 'None')
     if({memCondition})
     @end if
 
     @if({memPtrLevel} == 0)
-        @if('{memName}' != 'pNext')
+        @if('{memName}' != 'pNext' and not ('{memType}' == 'const void*' and '{memLength}' != 'None'))
     dump_json_value<const {memBaseType}>(object.{memName}, NULL, settings, "{memType}", "{memName}", indents + 1, dump_json_{memTypeID}{memInheritedConditions});
         @end if 
+        @if('{memType}' == 'const void*' and '{memLength}' != 'None')
+    dump_json_payload(object.{memName}, object.{memLength}, settings, "{memType}", "{memName}", indents + 1);
+        @end if
         @if('{memName}' == 'pNext')
     if(object.pNext != nullptr){{
         dump_json_pNext_trampoline(object.{memName}, settings, indents + 1);
@@ -1647,7 +1895,9 @@ std::ostream& dump_json_{sctName}(const {sctName}& object, const ApiDumpSettings
     @end if
     @if('{sctName}' == 'VkShaderModuleCreateInfo')
     @if('{memName}' == 'pCode')
-    if(settings.showShader())
+    if(settings.showShader() && settings.storesBlobs())
+        dump_json_payload(object.{memName}, object.codeSize, settings, "{memType}", "{memName}", indents + 1);
+    else if(settings.showShader())
         dump_json_array<const {memBaseType}>(object.{memName}, object.{memLength}, settings, "{memType}", "{memChildType}", "{memName}", indents + 1, dump_json_{memTypeID}{memInheritedConditions}); // KQA
     else
         dump_json_special("SHADER DATA", settings, "{memType}", "{memName}", indents + 1);
@@ -1657,62 +1907,50 @@ std::ostream& dump_json_{sctName}(const {sctName}& object, const ApiDumpSettings
     @if('{memCondition}' != 'None')
     else
     {{
-        settings.stream() << settings.indentation(indents+1) << "{{\\n";
-        settings.stream() << settings.indentation(indents+2) << "\\"type\\" : \\"{memType}\\",\\n";
-        settings.stream() << settings.indentation(indents+2) << "\\"name\\" : \\"{memName}\\",\\n";
-        settings.stream() << settings.indentation(indents+2) << "\\"address\\" : \\"UNUSED\\",\\n";
-        settings.stream() << settings.indentation(indents+2) << "\\"value\\" : \\"UNUSED\\"\\n";
+        settings.stream() << settings.indentation(indents+1) << "{{" << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents+2) << "\\"type\\" : \\"{memType}\\"," << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents+2) << "\\"name\\" : \\"{memName}\\"," << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents+2) << "\\"address\\" : \\"UNUSED\\"," << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(indents+2) << "\\"value\\" : \\"UNUSED\\"" << settings.jsonLineBreak();
         settings.stream() << settings.indentation(indents+1) << "}}";
     }}
     @end if
     needMemberComma = true;
     @end member
-    settings.stream() << "\\n" << settings.indentation(indents) << "]";
+    settings.stream() << settings.jsonLineBreak() << settings.indentation(indents) << "]";
     return settings.stream();
 }}
 @end struct
 
-bool is_struct(const char *t)
-{{
-    char *tm = (char*)t;
-    size_t tmlen;
-    if (strncmp(tm, "const ", 6) == 0) tm = tm + 6;
-    tmlen = strcspn(tm, "[*");
-@foreach struct
-    if (strncmp("{sctName}", tm, tmlen) == 0 && strlen("{sctName}") == tmlen) return true;
-@end struct
-    return false;
-}}
-
 std::ostream& dump_json_VkPhysicalDeviceMemoryProperties(const VkPhysicalDeviceMemoryProperties& object, const ApiDumpSettings& settings, int indents)
 {{
-    settings.stream() << settings.indentation(indents) << "[\\n";
+    settings.stream() << settings.indentation(indents) << "[" << settings.jsonLineBreak();
 
     dump_json_value<const uint32_t>(object.memoryTypeCount, NULL, settings, "uint32_t", "memoryTypeCount", indents + 1, dump_json_uint32_t);
-    settings.stream() << ",\\n";
+    settings.stream() << "," << settings.jsonLineBreak();
     dump_json_array<const VkMemoryType>(object.memoryTypes, object.memoryTypeCount, settings, "VkMemoryType[VK_MAX_MEMORY_TYPES]", "VkMemoryType", "memoryTypes", indents + 1, dump_json_VkMemoryType); // LQA
-    settings.stream() << ",\\n";
+    settings.stream() << "," << settings.jsonLineBreak();
     dump_json_value<const uint32_t>(object.memoryHeapCount, NULL, settings, "uint32_t", "memoryHeapCount", indents + 1, dump_json_uint32_t);
-    settings.stream() << ",\\n";
+    settings.stream() << "," << settings.jsonLineBreak();
     dump_json_array<const VkMemoryHeap>(object.memoryHeaps, object.memoryHeapCount, settings, "VkMemoryHeap[VK_MAX_MEMORY_HEAPS]", "VkMemoryHeap", "memoryHeaps", indents + 1, dump_json_VkMemoryHeap); // MQA
-    settings.stream() << "\\n" << settings.indentation(indents) << "]";
+    settings.stream() << settings.jsonLineBreak() << settings.indentation(indents) << "]";
     return settings.stream();
 }}
 
 std::ostream& dump_json_VkPhysicalDeviceGroupProperties(const VkPhysicalDeviceGroupProperties& object, const ApiDumpSettings& settings, int indents)
 {{
-    settings.stream() << settings.indentation(indents) << "[\\n";
+    settings.stream() << settings.indentation(indents) << "[" << settings.jsonLineBreak();
 
     dump_json_value<const VkStructureType>(object.sType, NULL, settings, "VkStructureType", "sType", indents + 1, dump_json_VkStructureType);
-    settings.stream() << ",\\n";
+    settings.stream() << "," << settings.jsonLineBreak();
     dump_json_value<const void*>(object.pNext, object.pNext, settings, "void*", "pNext", indents + 1, dump_json_void);
-    settings.stream() << ",\\n";
+    settings.stream() << "," << settings.jsonLineBreak();
     dump_json_value<const uint32_t>(object.physicalDeviceCount, NULL, settings, "uint32_t", "physicalDeviceCount", indents + 1, dump_json_uint32_t);
-    settings.stream() << ",\\n";
+    settings.stream() << "," << settings.jsonLineBreak();
     dump_json_array<const VkPhysicalDevice>(object.physicalDevices, object.physicalDeviceCount, settings, "VkPhysicalDevice[VK_MAX_DEVICE_GROUP_SIZE]", "VkPhysicalDevice", "physicalDevices", indents + 1, dump_json_VkPhysicalDevice); // NQA
-    settings.stream() << ",\\n";
+    settings.stream() << "," << settings.jsonLineBreak();
     dump_json_value<const VkBool32>(object.subsetAllocation, NULL, settings, "VkBool32", "subsetAllocation", indents + 1, dump_json_VkBool32);
-    settings.stream() << "\\n" << settings.indentation(indents) << "]";
+    settings.stream() << settings.jsonLineBreak() << settings.indentation(indents) << "]";
     return settings.stream();
 }}
 
@@ -1720,11 +1958,11 @@ std::ostream& dump_json_VkPhysicalDeviceGroupProperties(const VkPhysicalDeviceGr
 @foreach union
 std::ostream& dump_json_{unName}(const {unName}& object, const ApiDumpSettings& settings, int indents)
 {{
-    settings.stream() << settings.indentation(indents) << "[\\n";
+    settings.stream() << settings.indentation(indents) << "[" << settings.jsonLineBreak();
 
     bool needChoiceComma = false;
     @foreach choice
-    if (needChoiceComma) settings.stream() << ",\\n";
+    if (needChoiceComma) settings.stream() << "," << settings.jsonLineBreak();
 
     @if({chcPtrLevel} == 0)
     dump_json_value<const {chcBaseType}>(object.{chcName}, NULL, settings, "{chcType}", "{chcName}", indents + 2, dump_json_{chcTypeID});
@@ -1738,21 +1976,44 @@ std::ostream& dump_json_{unName}(const {unName}& object, const ApiDumpSettings&
     needChoiceComma = true;
     @end choice
 
-    settings.stream() << "\\n" << settings.indentation(indents) << "]";
+    settings.stream() << settings.jsonLineBreak() << settings.indentation(indents) << "]";
     return settings.stream();
 }}
 @end union
 
-bool is_union(const char *t)
+//=========================== Member Type Dispatch ==========================//
+
+// Dumps a value of one of the types that the member tables of api_dump_tables.h use
+std::ostream& dump_json_type(uint32_t type_id, const void* object, const ApiDumpSettings& settings, int indents)
 {{
-    char *tm = (char*)t;
-    size_t tmlen;
-    if (strncmp(tm, "const ", 6) == 0) tm = tm + 6;
-    tmlen = strcspn(tm, "[*");
-@foreach union
-    if (strncmp("{unName}", tm, tmlen) == 0 && strlen("{unName}") == tmlen) return true;
-@end union
-    return false;
+    switch(type_id) {{
+    @foreach membertype
+    case API_DUMP_TYPE_{mtyName}:
+        return dump_json_{mtyName}(*static_cast<{mtyBaseType} const*>(object), settings, indents);
+    @end membertype
+    }}
+    return settings.stream();
+}}
+
+//======================== Command Buffer Summaries =========================//
+
+std::ostream& dump_json_ApiDumpCmdBufferSummary(const ApiDumpCmdBufferSummary& object, const ApiDumpSettings& settings, int indents)
+{{
+    settings.stream() << settings.indentation(indents) << "[" << settings.jsonLineBreak();
+    dump_json_value<const VkCommandBuffer>(object.commandBuffer, NULL, settings, "VkCommandBuffer", "commandBuffer", indents + 1, dump_json_VkCommandBuffer);
+    for (int i = 0; i < ApiDumpCmdBufferSummary::CategoryCount; ++i) {{
+        settings.stream() << "," << settings.jsonLineBreak();
+        dump_json_value<const uint64_t>(object.counts[i], NULL, settings, "uint64_t", API_DUMP_CMD_BUFFER_SUMMARY_NAMES[i], indents + 1, dump_json_uint64_t);
+    }}
+    settings.stream() << "," << settings.jsonLineBreak();
+    dump_json_value<const uint64_t>(object.pipelines.size(), NULL, settings, "uint64_t", "uniquePipelines", indents + 1, dump_json_uint64_t);
+    ArrayIndexName pipelineName("pipelines");
+    for (size_t i = 0; i < object.pipelines.size(); ++i) {{
+        settings.stream() << "," << settings.jsonLineBreak();
+        dump_json_value<const VkPipeline>(object.pipelines[i], NULL, settings, "VkPipeline", pipelineName.get(i), indents + 1, dump_json_VkPipeline);
+    }}
+    settings.stream() << settings.jsonLineBreak() << settings.indentation(indents) << "]";
+    return settings.stream();
 }}
 
 //========================= Function Implementations ========================//
@@ -1767,24 +2028,32 @@ std::ostream& dump_json_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
     if(dump_inst.firstFunctionCallOnFrame())
         needFuncComma = false;
 
-    if (needFuncComma) settings.stream() << ",\\n";
+    // Calls written on completion, or let through by the delta filter, are separated as they are written
+    if (!settings.separatesJsonCallsOnWrite() && needFuncComma) settings.stream() << "," << settings.jsonLineBreak();
 
     // Display apicall name
-    settings.stream() << settings.indentation(2) << "{{\\n";
-    settings.stream() << settings.indentation(3) << "\\\"name\\\" : \\\"{funcName}\\\",\\n";
+    settings.stream() << settings.indentation(2) << "{{" << settings.jsonLineBreak();
+    settings.stream() << settings.indentation(3) << "\\\"name\\\" : \\\"{funcName}\\\"," << settings.jsonLineBreak();
+
+    // Calls written one per line always hold their frame, thread and elapsed time, as plain numbers
+    if (settings.jsonLines()) {{
+        dump_write_uint(settings.stream() << "\\\"frame\\\" : ", dump_inst.frameCount()) << ",";
+        dump_write_uint(settings.stream() << "\\\"thread\\\" : ", dump_inst.threadID()) << ",";
+        dump_write_int(settings.stream() << "\\\"ts\\\" : ", dump_inst.current_time_since_start().count()) << ",";
+    }}
 
     // Display thread info
-    if (settings.showThreadAndFrame()){{
-        settings.stream() << settings.indentation(3) << "\\\"thread\\\" : \\\"Thread " << dump_inst.threadID() << "\\\",\\n";
+    if (settings.showThreadAndFrame() && !settings.jsonLines()){{
+        dump_write_uint(settings.stream() << settings.indentation(3) << "\\\"thread\\\" : \\\"Thread ", dump_inst.threadID()) << "\\\"," << settings.jsonLineBreak();
     }}
 
     // Display elapsed time
-    if(settings.showTimestamp()) {{
-        settings.stream() << settings.indentation(3) << "\\\"time\\\" : \\\""<< dump_inst.current_time_since_start().count() << " us\\\",\\n";
+    if(settings.showTimestamp() && !settings.jsonLines()) {{
+        dump_write_int(settings.stream() << settings.indentation(3) << "\\\"time\\\" : \\\"", dump_inst.current_time_since_start().count()) << " us\\\"," << settings.jsonLineBreak();
     }}
 
     // Display return value
-    settings.stream() << settings.indentation(3) << "\\\"returnType\\\" : " << "\\\"{funcReturn}\\\",\\n";
+    settings.stream() << settings.indentation(3) << "\\\"returnType\\\" : " << "\\\"{funcReturn}\\\"," << settings.jsonLineBreak();
 
     return settings.shouldFlush() ? settings.stream() << std::flush : settings.stream();
 }}
@@ -1805,7 +2074,7 @@ std::ostream& dump_json_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
     dump_json_{funcReturn}(result, settings, 0);
     if(settings.showParams())
         settings.stream() << ",";
-    settings.stream() << "\\n";
+    settings.stream() << settings.jsonLineBreak();
     @end if
 
     // Display parameter values
@@ -1813,14 +2082,17 @@ std::ostream& dump_json_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
     {{
         bool needParameterComma = false;
 
-        settings.stream() << settings.indentation(3) << "\\\"args\\\" :\\n";
-        settings.stream() << settings.indentation(3) << "[\\n";
+        settings.stream() << settings.indentation(3) << "\\\"args\\\" :" << settings.jsonLineBreak();
+        settings.stream() << settings.indentation(3) << "[" << settings.jsonLineBreak();
 
         @foreach parameter
-        if (needParameterComma) settings.stream() << ",\\n";
-        @if({prmPtrLevel} == 0)
+        if (needParameterComma) settings.stream() << "," << settings.jsonLineBreak();
+        @if({prmPtrLevel} == 0 and not ('{prmType}' == 'const void*' and '{prmLength}' != 'None'))
         dump_json_value<const {prmBaseType}>({prmName}, NULL, settings, "{prmType}", "{prmName}", 4, dump_json_{prmTypeID}{prmInheritedConditions});
         @end if
+        @if({prmPtrLevel} == 0 and '{prmType}' == 'const void*' and '{prmLength}' != 'None')
+        dump_json_payload({prmName}, {prmLength}, settings, "{prmType}", "{prmName}", 4);
+        @end if
         @if({prmPtrLevel} == 1 and '{prmLength}' == 'None')
         dump_json_pointer<const {prmBaseType}>({prmName}, settings, "{prmType}", "{prmName}", 4, dump_json_{prmTypeID}{prmInheritedConditions});
         @end if
@@ -1829,19 +2101,507 @@ std::ostream& dump_json_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedPa
         @end if
         needParameterComma = true;
         @end parameter
+        @if('{funcName}' == 'vkQueueSubmit')
+        if (settings.summarizesCmdBuffers()) {{
+            std::vector<ApiDumpCmdBufferSummary> summaries = settings.cmdBufferSummaries().summarize(submitCount, pSubmits);
+            ArrayIndexName summaryName("commandBufferSummaries");
+            for (size_t i = 0; i < summaries.size(); ++i) {{
+                if (needParameterComma) settings.stream() << "," << settings.jsonLineBreak();
+                dump_json_value<const ApiDumpCmdBufferSummary>(summaries[i], NULL, settings, "CommandBufferSummary", summaryName.get(i), 4, dump_json_ApiDumpCmdBufferSummary);
+                needParameterComma = true;
+            }}
+        }}
+        @end if
 
-        settings.stream() << "\\n" << settings.indentation(3) << "]\\n";
+        settings.stream() << settings.jsonLineBreak() << settings.indentation(3) << "]" << settings.jsonLineBreak();
     }}
     settings.stream() << settings.indentation(2) << "}}";
-    needFuncComma = true;
+    if (settings.jsonLines())
+        settings.stream() << "\\n";
+    else if (!settings.separatesJsonCallsOnWrite())
+        needFuncComma = true;
     if (settings.shouldFlush()) settings.stream().flush();
     return settings.stream();
 }}
 @end function
 """
 
-POINTER_TYPES = ['void', 'xcb_connection_t', 'Display', 'SECURITY_ATTRIBUTES', 'ANativeWindow', 'AHardwareBuffer']
-
+BINARY_CODEGEN = """
+/* Copyright (c) 2015-2020 Valve Corporation
+ * Copyright (c) 2015-2020 LunarG, Inc.
+ * Copyright (c) 2015-2017, 2019 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Lenny Komow <lenny@lunarg.com>
+ * Author: Joey Bzdek <joey@lunarg.com>
+ * Author: Shannon McPherson <shannon@lunarg.com>
+ * Author: David Pinedo <david@lunarg.com>
+ * Author: Charles Giessen <charles@lunarg.com>
+ */
+
+/*
+ * This file is generated from the Khronos Vulkan XML API Registry.
+ */
+
+#pragma once
+
+#include "api_dump.h"
+#include "api_dump_tables.h"
+
+@foreach struct
+std::ostream& dump_binary_{sctName}(const {sctName}& object, const ApiDumpSettings& settings{sctConditionVars});
+@end struct
+@foreach union
+std::ostream& dump_binary_{unName}(const {unName}& object, const ApiDumpSettings& settings);
+@end union
+
+//============================= typedefs ==============================//
+
+// Functions for dumping typedef types that the codegen scripting can't handle
+#if defined(VK_ENABLE_BETA_EXTENSIONS)
+std::ostream& dump_binary_VkAccelerationStructureTypeKHR(VkAccelerationStructureTypeKHR object, const ApiDumpSettings& settings);
+std::ostream& dump_binary_VkAccelerationStructureTypeNV(VkAccelerationStructureTypeNV object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_VkAccelerationStructureTypeKHR(object, settings);
+}}
+std::ostream& dump_binary_VkBuildAccelerationStructureFlagsKHR(VkBuildAccelerationStructureFlagsKHR object, const ApiDumpSettings& settings);
+inline std::ostream& dump_binary_VkBuildAccelerationStructureFlagsNV(VkBuildAccelerationStructureFlagsNV object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_VkBuildAccelerationStructureFlagsKHR(object, settings);
+}}
+#endif // VK_ENABLE_BETA_EXTENSIONS
+
+
+//======================== pNext Chain Implementation =======================//
+
+std::ostream& dump_binary_VkStructureType(VkStructureType object, const ApiDumpSettings& settings);
+
+std::ostream& dump_binary_pNext_trampoline(const void* object, const ApiDumpSettings& settings)
+{{
+    switch((int64_t) (static_cast<const VkBaseInStructure*>(object)->sType)) {{
+    @foreach struct where('{sctName}' not in ['VkPipelineViewportStateCreateInfo', 'VkCommandBufferBeginInfo'])
+        @if({sctStructureTypeIndex} != -1)
+    case {sctStructureTypeIndex}:
+        dump_binary_pNext<const {sctName}>(static_cast<const {sctName}*>(object), settings, "{sctName}", dump_binary_{sctName});
+        break;
+        @end if
+    @end struct
+
+    case 47: // VK_STRUCTURE_TYPE_LOADER_INSTANCE_CREATE_INFO
+    case 48: // VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO
+        if(static_cast<const VkBaseInStructure*>(object)->pNext != nullptr){{
+            dump_binary_pNext_trampoline(static_cast<const void*>(static_cast<const VkBaseInStructure*>(object)->pNext), settings);
+        }} else {{
+            dump_binary_node(NULL, settings, "const void*", "pNext");
+            dump_binary_tag(ApiDumpBinaryTag::Null, settings.stream());
+        }}
+        break;
+    default:
+        // The converter prints an sType without a name as UNKNOWN
+        dump_binary_node(object, settings, "const void*", "pNext");
+        dump_binary_VkStructureType(static_cast<const VkBaseInStructure*>(object)->sType, settings);
+    }}
+    return settings.stream();
+}}
+
+inline std::ostream& dump_binary_pNext_trampoline(const void* object, const ApiDumpSettings& settings, bool is_dynamic_viewport, bool is_dynamic_scissor)
+{{
+    dump_binary_pNext<const VkPipelineViewportStateCreateInfo>(static_cast<const VkPipelineViewportStateCreateInfo*>(object), settings, "VkPipelineViewportStateCreateInfo", dump_binary_VkPipelineViewportStateCreateInfo, is_dynamic_viewport, is_dynamic_scissor);
+    return settings.stream();
+}}
+
+inline std::ostream& dump_binary_pNext_trampoline(const void* object, const ApiDumpSettings& settings, VkCommandBuffer cmd_buffer)
+{{
+    dump_binary_pNext<const VkCommandBufferBeginInfo>(static_cast<const VkCommandBufferBeginInfo*>(object), settings, "VkCommandBufferBeginInfo", dump_binary_VkCommandBufferBeginInfo, cmd_buffer);
+    return settings.stream();
+}}
+
+//=========================== Type Implementations ==========================//
+
+@foreach type where('{etyName}' != 'void')
+inline std::ostream& dump_binary_{etyName}({etyName} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_scalar(object, settings);
+}}
+@end type
+
+//========================= Basetype Implementations ========================//
+
+@foreach basetype where(not '{baseName}' in ['ANativeWindow', 'AHardwareBuffer', 'CAMetalLayer'])
+inline std::ostream& dump_binary_{baseName}({baseName} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_scalar(object, settings);
+}}
+@end basetype
+@foreach basetype where('{baseName}' in ['ANativeWindow', 'AHardwareBuffer'])
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+inline std::ostream& dump_binary_{baseName}(const {baseName}* object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_scalar(object, settings);
+}}
+#endif
+@end basetype
+@foreach basetype where('{baseName}' in ['CAMetalLayer'])
+#if defined(VK_USE_PLATFORM_METAL_EXT)
+inline std::ostream& dump_binary_{baseName}({baseName} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_scalar(object, settings);
+}}
+#endif
+@end basetype
+
+//======================= System Type Implementations =======================//
+
+@foreach systype
+inline std::ostream& dump_binary_{sysName}(const {sysType} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_scalar(object, settings);
+}}
+@end systype
+
+//========================== Handle Implementations =========================//
+
+@foreach handle
+inline std::ostream& dump_binary_{hdlName}(const {hdlName} object, const ApiDumpSettings& settings)
+{{
+    dump_binary_tag(ApiDumpBinaryTag::Handle, settings.stream());
+    dump_binary_varint(settings.showAddress() ? (uint64_t) object : 0, settings.stream());
+    std::string object_name;
+    ApiDumpInstance::current().getObjectName((uint64_t) object, object_name);
+    dump_binary_text(object_name.c_str(), object_name.size(), settings.stream());
+    return settings.stream();
+}}
+@end handle
+
+//=========================== Enum Implementations ==========================//
+
+@foreach enum
+inline std::ostream& dump_binary_{enumName}({enumName} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_enum(dump_enum_name(API_DUMP_OPTIONS_{enumName}, object), object, settings);
+}}
+@end enum
+
+//========================= Bitmask Implementations =========================//
+
+@foreach bitmask
+inline std::ostream& dump_binary_{bitName}({bitName} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_bitmask(API_DUMP_OPTIONS_{bitName}, object, settings);
+}}
+@end bitmask
+
+//=========================== Flag Implementations ==========================//
+
+@foreach flag where('{flagEnum}' != 'None')
+inline std::ostream& dump_binary_{flagName}({flagName} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_{flagEnum}(({flagEnum}) object, settings);
+}}
+@end flag
+@foreach flag where('{flagEnum}' == 'None')
+inline std::ostream& dump_binary_{flagName}({flagName} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_scalar(object, settings);
+}}
+@end flag
+
+//======================= Func Pointer Implementations ======================//
+
+@foreach funcpointer
+inline std::ostream& dump_binary_{pfnName}({pfnName} object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_scalar(object, settings);
+}}
+@end funcpointer
+
+//========================== Struct Implementations =========================//
+
+@foreach struct where({sctTable})
+std::ostream& dump_binary_{sctName}(const {sctName}& object, const ApiDumpSettings& settings)
+{{
+    return dump_binary_struct(API_DUMP_MEMBERS_{sctName}, &object, settings);
+}}
+@end struct
+
+// Structs with special cases that the member tables do not describe
+@foreach struct where(not {sctTable} and '{sctName}' not in ['VkPhysicalDeviceMemoryProperties' ,'VkPhysicalDeviceGroupProperties'])
+std::ostream& dump_binary_{sctName}(const {sctName}& object, const ApiDumpSettings& settings{sctConditionVars})
+{{
+    dump_binary_tag(ApiDumpBinaryTag::Struct, settings.stream());
+
+    @foreach member
+    @if('{memCondition}' != 'None')
+    if({memCondition})
+    @end if
+
+    @if({memPtrLevel} == 0)
+        @if('{memName}' != 'pNext')
+    dump_binary_value<const {memBaseType}>(object.{memName}, NULL, settings, "{memType}", "{memName}", dump_binary_{memTypeID}{memInheritedConditions});
+        @end if
+        @if('{memName}' == 'pNext')
+    if(object.pNext != nullptr){{
+        dump_binary_pNext_trampoline(object.{memName}, settings);
+    }} else {{
+        dump_binary_value<const {memBaseType}>(object.{memName}, object.{memName}, settings, "{memType}", "{memName}", dump_binary_{memTypeID}{memInheritedConditions});
+    }}
+        @end if
+    @end if
+    @if({memPtrLevel} == 1 and '{memLength}' == 'None')
+    dump_binary_pointer<const {memBaseType}>(object.{memName}, settings, "{memType}", "{memName}", dump_binary_{memTypeID}{memInheritedConditions});
+    @end if
+    @if({memPtrLevel} == 1 and '{memLength}' != 'None' and not {memLengthIsMember})
+    dump_binary_array<const {memBaseType}>(object.{memName}, {memLength}, settings, "{memType}", "{memChildType}", "{memName}", dump_binary_{memTypeID}{memInheritedConditions});
+    @end if
+    @if({memPtrLevel} == 1 and '{memLength}' != 'None' and {memLengthIsMember} and '{memName}' != 'pCode')
+    @if('{memLength}'[0].isdigit() or '{memLength}'[0].isupper())
+    dump_binary_array<const {memBaseType}>(object.{memName}, {memLength}, settings, "{memType}", "{memChildType}", "{memName}", dump_binary_{memTypeID}{memInheritedConditions});
+    @end if
+    @if(not ('{memLength}'[0].isdigit() or '{memLength}'[0].isupper()))
+    dump_binary_array<const {memBaseType}>(object.{memName}, object.{memLength}, settings, "{memType}", "{memChildType}", "{memName}", dump_binary_{memTypeID}{memInheritedConditions});
+    @end if
+    @end if
+    @if('{sctName}' == 'VkShaderModuleCreateInfo')
+    @if('{memName}' == 'pCode')
+    if(settings.showShader())
+        dump_binary_blob(object.{memName}, object.codeSize, settings, "{memType}", "{memName}");
+    else
+        dump_binary_special("SHADER DATA", settings, "{memType}", "{memName}");
+    @end if
+    @end if
+
+    @if('{memCondition}' != 'None')
+    else
+        dump_binary_special("UNUSED", settings, "{memType}", "{memName}");
+    @end if
+    @end member
+    dump_binary_tag(ApiDumpBinaryTag::End, settings.stream());
+    return settings.stream();
+}}
+@end struct
+
+std::ostream& dump_binary_VkPhysicalDeviceMemoryProperties(const VkPhysicalDeviceMemoryProperties& object, const ApiDumpSettings& settings)
+{{
+    dump_binary_tag(ApiDumpBinaryTag::Struct, settings.stream());
+    dump_binary_value<const uint32_t>(object.memoryTypeCount, NULL, settings, "uint32_t", "memoryTypeCount", dump_binary_uint32_t);
+    dump_binary_array<const VkMemoryType>(object.memoryTypes, object.memoryTypeCount, settings, "VkMemoryType[VK_MAX_MEMORY_TYPES]", "VkMemoryType", "memoryTypes", dump_binary_VkMemoryType);
+    dump_binary_value<const uint32_t>(object.memoryHeapCount, NULL, settings, "uint32_t", "memoryHeapCount", dump_binary_uint32_t);
+    dump_binary_array<const VkMemoryHeap>(object.memoryHeaps, object.memoryHeapCount, settings, "VkMemoryHeap[VK_MAX_MEMORY_HEAPS]", "VkMemoryHeap", "memoryHeaps", dump_binary_VkMemoryHeap);
+    dump_binary_tag(ApiDumpBinaryTag::End, settings.stream());
+    return settings.stream();
+}}
+
+std::ostream& dump_binary_VkPhysicalDeviceGroupProperties(const VkPhysicalDeviceGroupProperties& object, const ApiDumpSettings& settings)
+{{
+    dump_binary_tag(ApiDumpBinaryTag::Struct, settings.stream());
+    dump_binary_value<const VkStructureType>(object.sType, NULL, settings, "VkStructureType", "sType", dump_binary_VkStructureType);
+    dump_binary_value<const void*>(object.pNext, object.pNext, settings, "void*", "pNext", dump_binary_void);
+    dump_binary_value<const uint32_t>(object.physicalDeviceCount, NULL, settings, "uint32_t", "physicalDeviceCount", dump_binary_uint32_t);
+    dump_binary_array<const VkPhysicalDevice>(object.physicalDevices, object.physicalDeviceCount, settings, "VkPhysicalDevice[VK_MAX_DEVICE_GROUP_SIZE]", "VkPhysicalDevice", "physicalDevices", dump_binary_VkPhysicalDevice);
+    dump_binary_value<const VkBool32>(object.subsetAllocation, NULL, settings, "VkBool32", "subsetAllocation", dump_binary_VkBool32);
+    dump_binary_tag(ApiDumpBinaryTag::End, settings.stream());
+    return settings.stream();
+}}
+
+//========================== Union Implementations ==========================//
+@foreach union
+std::ostream& dump_binary_{unName}(const {unName}& object, const ApiDumpSettings& settings)
+{{
+    dump_binary_tag(ApiDumpBinaryTag::Union, settings.stream());
+
+    @foreach choice
+    @if({chcPtrLevel} == 0)
+    dump_binary_value<const {chcBaseType}>(object.{chcName}, NULL, settings, "{chcType}", "{chcName}", dump_binary_{chcTypeID});
+    @end if
+    @if({chcPtrLevel} == 1 and '{chcLength}' == 'None')
+    dump_binary_pointer<const {chcBaseType}>(object.{chcName}, settings, "{chcType}", "{chcName}", dump_binary_{chcTypeID});
+    @end if
+    @if({chcPtrLevel} == 1 and '{chcLength}' != 'None')
+    dump_binary_array<const {chcBaseType}>(object.{chcName}, {chcLength}, settings, "{chcType}", "{chcChildType}", "{chcName}", dump_binary_{chcTypeID});
+    @end if
+    @end choice
+
+    dump_binary_tag(ApiDumpBinaryTag::End, settings.stream());
+    return settings.stream();
+}}
+@end union
+
+//=========================== Member Type Dispatch ==========================//
+
+// Dumps a value of one of the types that the member tables of api_dump_tables.h use
+std::ostream& dump_binary_type(uint32_t type_id, const void* object, const ApiDumpSettings& settings)
+{{
+    switch(type_id) {{
+    @foreach membertype
+    case API_DUMP_TYPE_{mtyName}:
+        return dump_binary_{mtyName}(*static_cast<{mtyBaseType} const*>(object), settings);
+    @end membertype
+    }}
+    return settings.stream();
+}}
+
+//========================= Function Implementations ========================//
+
+@foreach function where(not '{funcName}' in ['vkGetDeviceProcAddr', 'vkGetInstanceProcAddr'])
+std::ostream& dump_binary_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
+{{
+    const ApiDumpSettings& settings(dump_inst.settings());
+
+    // Thread, frame and time are always recorded, the converter decides what to display
+    dump_binary_tag(ApiDumpBinaryTag::Call, settings.stream());
+    dump_binary_varint(dump_inst.threadID(), settings.stream());
+    dump_binary_varint(dump_inst.frameCount(), settings.stream());
+    dump_binary_varint((uint64_t) dump_inst.current_time_since_start().count(), settings.stream());
+    dump_binary_name("{funcName}", settings.stream());
+    dump_binary_name("{funcNamedParams}", settings.stream());
+    dump_binary_name("{funcReturn}", settings.stream());
+
+    return settings.shouldFlush() ? settings.stream() << std::flush : settings.stream();
+}}
+@end function
+
+@foreach function where(not '{funcName}' in ['vkGetDeviceProcAddr', 'vkGetInstanceProcAddr'])
+@if('{funcReturn}' != 'void')
+std::ostream& dump_binary_body_{funcName}(ApiDumpInstance& dump_inst, {funcReturn} result, {funcTypedParams})
+@end if
+@if('{funcReturn}' == 'void')
+std::ostream& dump_binary_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
+@end if
+{{
+    const ApiDumpSettings& settings(dump_inst.settings());
+
+    @if('{funcReturn}' != 'void')
+    dump_binary_{funcReturn}(result, settings);
+    @end if
+
+    // Display parameter values
+    if(settings.showParams())
+    {{
+        @foreach parameter
+        @if({prmPtrLevel} == 0)
+        dump_binary_value<const {prmBaseType}>({prmName}, NULL, settings, "{prmType}", "{prmName}", dump_binary_{prmTypeID}{prmInheritedConditions});
+        @end if
+        @if({prmPtrLevel} == 1 and '{prmLength}' == 'None')
+        dump_binary_pointer<const {prmBaseType}>({prmName}, settings, "{prmType}", "{prmName}", dump_binary_{prmTypeID}{prmInheritedConditions});
+        @end if
+        @if({prmPtrLevel} == 1 and '{prmLength}' != 'None')
+        dump_binary_array<const {prmBaseType}>({prmName}, {prmLength}, settings, "{prmType}", "{prmChildType}", "{prmName}", dump_binary_{prmTypeID}{prmInheritedConditions});
+        @end if
+        @end parameter
+    }}
+    dump_binary_tag(ApiDumpBinaryTag::End, settings.stream());
+    if (settings.shouldFlush()) settings.stream().flush();
+    return settings.stream();
+}}
+@end function
+"""
+
+TRACE_CODEGEN = """
+/* Copyright (c) 2015-2020 Valve Corporation
+ * Copyright (c) 2015-2020 LunarG, Inc.
+ * Copyright (c) 2015-2017, 2019 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Lenny Komow <lenny@lunarg.com>
+ * Author: Joey Bzdek <joey@lunarg.com>
+ * Author: Shannon McPherson <shannon@lunarg.com>
+ * Author: David Pinedo <david@lunarg.com>
+ * Author: Charles Giessen <charles@lunarg.com>
+ */
+
+/*
+ * This file is generated from the Khronos Vulkan XML API Registry.
+ */
+
+#pragma once
+
+#include "api_dump.h"
+#include "api_dump_tables.h"
+
+// Adds the debug name of a handle parameter to the arguments of the event, if it has one.
+inline void dump_trace_object_name(ApiDumpInstance& dump_inst, std::ostream& stream, const char* name, uint64_t object)
+{{
+    std::string object_name;
+    if (!dump_inst.getObjectName(object, object_name)) return;
+    stream.put(',');
+    dump_trace_string(stream, name);
+    stream.put(':');
+    dump_trace_string(stream, object_name.c_str());
+}}
+
+@foreach enum where('{enumName}' == 'VkResult')
+inline const char* dump_trace_{enumName}({enumName} object)
+{{
+    const char* name = dump_enum_name(API_DUMP_OPTIONS_{enumName}, object);
+    return name != NULL ? name : "UNKNOWN";
+}}
+@end enum
+
+//========================= Function Implementations ========================//
+
+@foreach function where(not '{funcName}' in ['vkGetDeviceProcAddr', 'vkGetInstanceProcAddr'])
+inline void dump_trace_head_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
+{{
+    dump_trace_call_start() = std::chrono::steady_clock::now();
+}}
+@end function
+
+@foreach function where(not '{funcName}' in ['vkGetDeviceProcAddr', 'vkGetInstanceProcAddr'])
+@if('{funcReturn}' != 'void')
+void dump_trace_body_{funcName}(ApiDumpInstance& dump_inst, {funcReturn} result, {funcTypedParams})
+@end if
+@if('{funcReturn}' == 'void')
+void dump_trace_body_{funcName}(ApiDumpInstance& dump_inst, {funcTypedParams})
+@end if
+{{
+    const std::chrono::steady_clock::time_point call_end = std::chrono::steady_clock::now();
+    const std::chrono::steady_clock::time_point call_start = dump_trace_call_start();
+    ApiDumpTraceBuffer& trace = dump_trace_buffer();
+
+    dump_trace_event_begin(trace.stream, "{funcName}", dump_inst.threadID(), dump_inst.time_since_start(call_start),
+                           std::chrono::duration_cast<std::chrono::nanoseconds>(call_end - call_start), dump_inst.frameCount());
+    @if('{funcReturn}' == 'VkResult')
+    dump_write_literal(trace.stream, ",\\"result\\":");
+    dump_trace_string(trace.stream, dump_trace_VkResult(result));
+    @end if
+    @foreach parameter
+    @if({prmPtrLevel} == 0 and {prmIsHandle})
+    dump_trace_object_name(dump_inst, trace.stream, "{prmName}", (uint64_t) {prmName});
+    @end if
+    @end parameter
+    dump_trace_event_end(trace.stream);
+    dump_inst.writeRecord(trace.buffer.str());
+}}
+@end function
+"""
+
+POINTER_TYPES = ['void', 'xcb_connection_t', 'Display', 'SECURITY_ATTRIBUTES', 'ANativeWindow', 'AHardwareBuffer']
+
+# The handles that calls are dispatched on, see ApiDumpInstance::isObjectDumped
+DISPATCHABLE_HANDLES = ['VkInstance', 'VkPhysicalDevice', 'VkDevice', 'VkQueue', 'VkCommandBuffer']
+
 TRACKED_STATE = {
     'vkAllocateCommandBuffers':
         'if(result == VK_SUCCESS)\n' +
@@ -2080,6 +2840,32 @@ class ApiDumpOutputGenerator(OutputGenerator):
                                         if sysType not in self.sysTypes:
                                             self.sysTypes.add(sysType)
 
+        # Find the types that the member tables refer to
+        structNames = set(struct.name for struct in self.structs) | set(self.aliases)
+        unionNames = set(union.name for union in self.unions)
+        sysTypeExts = dict((sysType.name, sysType.ext) for sysType in self.sysTypes)
+        memberTypes = {}
+        for struct in self.structs:
+            if not struct.isTable:
+                continue
+            for member in struct.members:
+                if member.typeID in memberTypes:
+                    continue
+                if member.typeID in structNames:
+                    kind = 'Struct'
+                elif member.typeID in unionNames:
+                    kind = 'Union'
+                else:
+                    kind = 'Value'
+                memberTypes[member.typeID] = VulkanMemberType(member, kind, sysTypeExts.get(member.typeID))
+        self.memberTypes = sorted(memberTypes.values(), key=lambda memberType: memberType.name)
+
+        # Mark the parameters that are handles
+        handleNames = set(handle.name for handle in self.handles)
+        for func in self.functions:
+            for param in func.parameters:
+                param.isHandle = param.baseType in handleNames
+
         # Find every @foreach, @if, and @end
         forIter = re.finditer('(^\\s*\\@foreach\\s+[a-z]+(\\s+where\\(.*\\))?\\s*^)|(\\@foreach [a-z]+(\\s+where\\(.*\\))?\\b)', self.format, flags=re.MULTILINE)
         ifIter = re.finditer('(^\\s*\\@if\\(.*\\)\\s*^)|(\\@if\\(.*\\))', self.format, flags=re.MULTILINE)
@@ -2235,13 +3021,16 @@ class ApiDumpOutputGenerator(OutputGenerator):
         elif loop.text == 'funcpointer':
             subjects = self.funcPointers
         elif loop.text == 'function':
-            subjects = self.functions
+            # Sorted so that the proc address tables can be binary searched
+            subjects = sorted(self.functions, key=lambda func: func.name)
         elif loop.text == 'handle':
             subjects = self.handles
         elif loop.text == 'option':
             subjects = self.findByType([VulkanEnum, VulkanBitmask], parents).options
         elif loop.text == 'member':
             subjects = self.findByType([VulkanStruct], parents).members
+        elif loop.text == 'membertype':
+            subjects = self.memberTypes
         elif loop.text == 'parameter':
             subjects = self.findByType([VulkanFunction], parents).parameters
         elif loop.text == 'struct':
@@ -2276,6 +3065,8 @@ class ApiDumpOutputGenerator(OutputGenerator):
                 ext = self.extFuncs[item.name]
             elif item.name in self.extTypes:
                 ext = self.extTypes[item.name]
+            elif isinstance(item, VulkanMemberType):
+                ext = item.ext
             elif item in self.sysTypes:
                 ext = item.ext
             else:
@@ -2391,6 +3182,7 @@ class VulkanVariable:
                 self.arrayLength = '*' + self.arrayLength
 
         self.pointerLevels = len(re.findall('\\*|\\[', self.text))
+        self.isBitfield = re.search(self.name + '\\s*:', self.text) is not None
         if self.typeID == 'char' and self.pointerLevels > 0:
             self.baseType += '*'
             self.pointerLevels -= 1
@@ -2537,6 +3329,9 @@ class VulkanEnum:
                     continue
                 self.options.append(VulkanEnum.Option(childName, childValue, None, None))
 
+        # The enum tables of api_dump_tables.h are searched by value
+        self.options.sort(key=lambda option: StrToInt(str(option.value)))
+
     def values(self):
         return {
             'enumName': self.name,
@@ -2630,6 +3425,7 @@ class VulkanFunction:
 
         def __init__(self, rootNode, constants, aliases, parentName):
             VulkanVariable.__init__(self, rootNode, constants, aliases, parentName)
+            self.isHandle = False    # Set once all of the handles are known
 
         def values(self):
             return {
@@ -2641,6 +3437,7 @@ class VulkanFunction:
                 'prmPtrLevel': self.pointerLevels,
                 'prmLength': self.arrayLength,
                 'prmInheritedConditions': self.inheritedConditions,
+                'prmIsHandle': self.isHandle,
             }
 
     def __init__(self, rootNode, constants, aliases, extensions):
@@ -2671,6 +3468,9 @@ class VulkanFunction:
         self.stateTrackingCode = ''
         if self.name in TRACKED_STATE:
             self.stateTrackingCode = TRACKED_STATE[self.name]
+        if self.parameters[0].type == 'VkCommandBuffer':
+            self.stateTrackingCode += 'ApiDumpInstance::current().trackCmdBufferCall(%s, API_DUMP_FUNCTION_%s, %s);' % (
+                self.parameters[0].name, self.name, '(uint64_t)pipeline' if self.name == 'vkCmdBindPipeline' else '0')
 
         self.safeToPrint = True
         for param in self.parameters:
@@ -2687,6 +3487,8 @@ class VulkanFunction:
             'funcTypedParams': self.typedParams,
             'funcDispatchParam': self.parameters[0].name,
             'funcDispatchType' : self.dispatchType, 
+            'funcCommandBuffer': '(uint64_t)' + self.parameters[0].name if self.parameters[0].type == 'VkCommandBuffer' else '0',
+            'funcDispatchHandle': '(uint64_t)' + self.parameters[0].name if self.parameters[0].type in DISPATCHABLE_HANDLES else '0',
             'funcStateTrackingCode': self.stateTrackingCode,
             'funcSafeToPrint': self.safeToPrint,
         }
@@ -2731,6 +3533,40 @@ class VulkanStruct:
                 self.condition = VALIDITY_CHECKS[parentName][self.name]
             self.structValues = rootNode.get('values')
 
+        # Fills in how the member tables of api_dump_tables.h describe this member, the same way the
+        # struct dump functions of the back ends treat it. False if the table can't describe it.
+        def describe(self, memberNames):
+            self.tableFlags = []
+            self.tableCount = '0'
+            self.tableCountMember = -1
+            if self.condition is not None or self.inheritedConditions != '' or self.isBitfield or self.name == 'pCode':
+                return False
+            if self.arrayLength is not None and not self.lengthMember:
+                self.tableFlags.append('API_DUMP_MEMBER_INLINE')
+            if self.pointerLevels == 0:
+                if self.name == 'pNext':
+                    self.tableFlags.append('API_DUMP_MEMBER_PNEXT')
+                elif self.type == 'const void*' and self.arrayLength is not None:
+                    self.tableFlags.append('API_DUMP_MEMBER_PAYLOAD')
+                    return self.describeCount(memberNames)
+                return True
+            if self.pointerLevels > 1:
+                return False
+            if self.arrayLength is None:
+                self.tableFlags.append('API_DUMP_MEMBER_POINTER')
+                return True
+            self.tableFlags.append('API_DUMP_MEMBER_ARRAY')
+            return self.describeCount(memberNames)
+
+        def describeCount(self, memberNames):
+            if not self.lengthMember or self.arrayLength[0].isdigit() or self.arrayLength[0].isupper():
+                self.tableCount = self.arrayLength
+                return True
+            if self.arrayLength not in memberNames:
+                return False
+            self.tableCountMember = memberNames.index(self.arrayLength)
+            return True
+
         def values(self):
             return {
                 'memName': self.name,
@@ -2743,6 +3579,10 @@ class VulkanStruct:
                 'memLengthIsMember': self.lengthMember,
                 'memCondition': self.condition,
                 'memInheritedConditions': self.inheritedConditions,
+                'memTableFlags': ' | '.join(self.tableFlags) if len(self.tableFlags) > 0 else '0',
+                'memTableCount': self.tableCount,
+                'memTableCountMember': self.tableCountMember,
+                'memTableChildType': '"' + self.childType + '"' if 'API_DUMP_MEMBER_ARRAY' in self.tableFlags else 'NULL',
             }
 
 
@@ -2758,6 +3598,14 @@ class VulkanStruct:
                 for state in states:
                     self.conditionVars += ', ' + state['type'] + ' ' + state['name']
 
+        # Most structs are dumped by walking a table of their members, the others keep dump functions
+        # generated for them
+        self.isTable = self.name not in ['VkPhysicalDeviceMemoryProperties', 'VkPhysicalDeviceGroupProperties'] and self.conditionVars == ''
+        memberNames = [member.name for member in self.members]
+        for member in self.members:
+            if not member.describe(memberNames):
+                self.isTable = False
+
         self.structureIndex = -1
         
         if(self.structExtends is not None):
@@ -2774,6 +3622,23 @@ class VulkanStruct:
             'sctName': self.name,
             'sctConditionVars': self.conditionVars,
             'sctStructureTypeIndex': self.structureIndex,
+            'sctTable': self.isTable,
+        }
+
+# A type that the member tables of api_dump_tables.h refer to
+class VulkanMemberType:
+
+    def __init__(self, member, kind, ext):
+        self.name = member.typeID
+        self.type = member.baseType
+        self.kind = kind
+        self.ext = ext
+
+    def values(self):
+        return {
+            'mtyName': self.name,
+            'mtyBaseType': self.type,
+            'mtyKind': self.kind,
         }
 
 class VulkanSystemType: